@@ -0,0 +1,478 @@
+// hush_bench - замеры производительности хранилища без GUI.
+//
+// Каждая строка вывода - отдельный JSON-объект (JSON Lines), чтобы результаты
+// можно было складывать и сравнивать между релизами.
+//
+//   hush_bench [--sizes=1000,10000,100000,1000000] [--budget-ms=1000] [--min-iterations=3]
+//   hush_bench --selftest    - проверки формата хранилища (selftest.h), без замеров
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cipher.h"
+#include "database.h"
+#include "entry_view.h"
+#include "journal.h"
+#include "password_generator.h"
+#include "search_worker.h"
+#include "selftest.h"
+#include "strength_estimator.h"
+#include "vault_audit.h"
+#include "vault_export.h"
+#include "vault_import.h"
+
+using namespace std;
+
+namespace {
+
+const char* const BENCH_PASSWORD = "correct horse battery staple";
+
+struct BenchConfig {
+    vector<size_t> sizes         = {1000, 10000, 100000, 1000000};
+    double         budgetMs      = 1000.0;
+    int            minIterations = 3;
+    int            maxIterations = 10000;
+};
+
+struct BenchResult {
+    string         name;
+    size_t         entries = 0;
+    size_t         bytes   = 0;  // Объём данных за одну итерацию (0 - не применимо)
+    size_t         items   = 0;  // Количество элементов за одну итерацию
+    vector<double> samplesUs;
+};
+
+// Реалистичные длины полей: домен ~20, e-mail ~24, пароль 12-24 символа
+vector<PasswordEntry> make_synthetic_entries(size_t count, uint32_t seed) {
+    static const char* const domains[] = {"example.com", "mail.org",   "bank.net",
+                                          "shop.io",     "social.app", "work.corp"};
+    static const char* const words[]   = {"alpha", "bravo",  "charlie", "delta", "echo",
+                                          "fox",   "golf",   "hotel",   "india", "juliet"};
+    static const char        pwChars[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*";
+
+    mt19937               gen(seed);
+    vector<PasswordEntry> entries;
+    entries.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        PasswordEntry entry;
+        const char*   domain = domains[gen() % size(domains)];
+        const char*   word   = words[gen() % size(words)];
+
+        entry.title = string(word) + "-" + to_string(i) + "." + domain;
+        entry.login = string(words[gen() % size(words)]) + "." + to_string(gen() % 100000) + "@" +
+                      domain;
+
+        size_t pwLen = 12 + gen() % 13;
+        entry.password.reserve(pwLen);
+        for (size_t j = 0; j < pwLen; ++j) {
+            entry.password += pwChars[gen() % (sizeof(pwChars) - 1)];
+        }
+
+        entry.is_favorite = gen() % 10 == 0;
+        if (gen() % 50 == 0) {
+            entry.requires_hardware_key    = true;
+            entry.hardware_key_fingerprint = "0781:5567:" + to_string(gen());
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+// Гоняем fn, пока не наберём minIterations и не исчерпаем бюджет времени
+BenchResult run_bench(const BenchConfig& config, const string& name, size_t entries,
+                      const function<void()>& fn) {
+    using clock = chrono::steady_clock;
+
+    BenchResult result;
+    result.name    = name;
+    result.entries = entries;
+
+    auto start = clock::now();
+    for (int i = 0; i < config.maxIterations; ++i) {
+        auto t0 = clock::now();
+        fn();
+        auto t1 = clock::now();
+        result.samplesUs.push_back(chrono::duration<double, micro>(t1 - t0).count());
+
+        double elapsedMs = chrono::duration<double, milli>(t1 - start).count();
+        if (i + 1 >= config.minIterations && elapsedMs >= config.budgetMs) break;
+    }
+    return result;
+}
+
+double percentile(vector<double> sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    sort(sorted.begin(), sorted.end());
+    size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+    rank        = clamp<size_t>(rank, 1, sorted.size());
+    return sorted[rank - 1];
+}
+
+void report(const BenchResult& result) {
+    double total = 0.0;
+    for (double s : result.samplesUs) total += s;
+    double meanUs = result.samplesUs.empty() ? 0.0 : total / result.samplesUs.size();
+
+    double itemsPerSec = meanUs > 0 ? result.items * 1e6 / meanUs : 0.0;
+    double bytesPerSec = meanUs > 0 ? result.bytes * 1e6 / meanUs : 0.0;
+
+    printf(
+        "{\"bench\":\"%s\",\"entries\":%zu,\"iterations\":%zu,\"bytes\":%zu,"
+        "\"mean_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"items_per_sec\":%.1f,"
+        "\"mb_per_sec\":%.3f}\n",
+        result.name.c_str(), result.entries, result.samplesUs.size(), result.bytes, meanUs,
+        percentile(result.samplesUs, 0.50), percentile(result.samplesUs, 0.99), itemsPerSec,
+        bytesPerSec / (1024.0 * 1024.0));
+    fflush(stdout);
+}
+
+void bench_size(const BenchConfig& config, size_t count) {
+    Vault vault;
+    auto  synthetic = make_synthetic_entries(count, 42);
+    for (const auto& entry : synthetic) vault.add(entry);
+    // Минимальные параметры Argon2id: db_load_file каждый раз вырабатывает ключ заново,
+    // а замер должен показывать чтение и расшифровку (сам KDF меряет argon2id_default)
+    db_set_key(vault, VaultKey::generate(BENCH_PASSWORD, KdfParams{1, 8, 1}));
+
+    auto tmp  = filesystem::temp_directory_path();
+    auto path = (tmp / ("hush_bench_" + to_string(count) + ".hush")).string();
+    auto copy = (tmp / ("hush_bench_" + to_string(count) + "_copy.hush")).string();
+
+    auto save_or_die = [&](const string& target) {
+        if (!db_save_file(vault, target)) {
+            fprintf(stderr, "db_save_file failed: %s\n", target.c_str());
+            exit(1);
+        }
+    };
+
+    // Добавление записей в пустое хранилище: строки копируются в закреплённый пул (SecureArena)
+    BenchResult add = run_bench(config, "vault_add", count, [&] {
+        Vault fresh;
+        for (const auto& entry : synthetic) fresh.add(entry);
+    });
+    add.items = count;
+    report(add);
+
+    // Импорт тех же записей из выгрузки CSV в пустое хранилище (Database/Import)
+    string csv = "name,username,password,favorite\n";
+    for (const auto& entry : synthetic) {
+        for (const string* field : {&entry.title, &entry.login, &entry.password}) {
+            csv += '"';
+            for (char c : *field) {
+                if (c == '"') csv += '"';
+                csv += c;
+            }
+            csv += "\",";
+        }
+        csv += entry.is_favorite ? "1\n" : "0\n";
+    }
+    BenchResult import = run_bench(config, "db_import_csv", count, [&] {
+        Vault         fresh;
+        mutex         freshMutex;
+        istringstream in(csv);
+        if (db_import(fresh, freshMutex, in).imported != count) exit(1);
+    });
+    import.bytes = csv.size();
+    import.items = count;
+    report(import);
+
+    // Полное сохранение: чередуем два файла, чтобы каждый раз писать всё хранилище
+    bool        toCopy = false;
+    BenchResult save   = run_bench(config, "db_save_file", count, [&] {
+        save_or_die(toCopy ? copy : path);
+        toCopy = !toCopy;
+    });
+    save_or_die(path);
+    size_t fileSize = filesystem::file_size(path);
+    save.bytes      = fileSize;
+    save.items      = count;
+    report(save);
+
+    // Сохранение после правки одной записи (autosave после saveEntry)
+    mt19937     editGen(3);
+    BenchResult edit = run_bench(config, "db_save_file_one_edit", count, [&] {
+        size_t        index = editGen() % count;
+        PasswordEntry entry;
+        vault.reveal(index, entry);
+        entry.password += "!";
+        vault.update(index, entry);
+        save_or_die(path);
+    });
+    edit.items = 1;
+    report(edit);
+
+    // Загрузка
+    BenchResult load = run_bench(config, "db_load_file", count, [&] {
+        if (!db_load_file(vault, path, BENCH_PASSWORD) || vault.entries.size() != count) {
+            fprintf(stderr, "db_load_file failed: %s\n", path.c_str());
+            exit(1);
+        }
+    });
+    load.bytes = fileSize;
+    load.items = count;
+    report(load);
+
+    // Расшифровка одного пароля после загрузки (copyPasswordFromBrowser)
+    mt19937     revealGen(5);
+    string      password;
+    BenchResult reveal = run_bench(config, "reveal_password", count, [&] {
+        if (!vault.reveal_password(revealGen() % count, password)) exit(1);
+    });
+    reveal.items = 1;
+    report(reveal);
+
+    // Проверка хранилища после загрузки: все пароли запечатаны и различны, то есть
+    // каждый расшифровывается и оценивается (Database/Audit)
+    BenchResult audit = run_bench(config, "db_audit", count, [&] {
+        if (db_audit(vault.entries, vault.key.get()).unreadable != 0) exit(1);
+    });
+    audit.items = count;
+    report(audit);
+
+    // Открытая выгрузка в CSV (Database/Export): каждый пароль расшифровывается по одному
+    auto        exported = (tmp / ("hush_bench_" + to_string(count) + ".csv")).string();
+    BenchResult exportCsv = run_bench(config, "db_export_csv", count, [&] {
+        if (!db_export(vault.entries, vault.key.get(), exported, ExportFormat::Csv)) exit(1);
+    });
+    exportCsv.bytes = filesystem::file_size(exported);
+    exportCsv.items = count;
+    report(exportCsv);
+    filesystem::remove(exported);
+
+    // Автосохранение правки одной записью журнала
+    BenchResult journal = run_bench(config, "db_autosave_one_edit", count, [&] {
+        size_t        index = editGen() % count;
+        PasswordEntry entry;
+        vault.reveal(index, entry);
+        entry.password += "!";
+        vault.update(index, entry);
+        if (!db_autosave(vault)) exit(1);
+    });
+    journal.items = 1;
+    report(journal);
+    save_or_die(path);
+
+    // Шифрование объёма, равного сериализованному хранилищу
+    string  plaintext(fileSize, '\0');
+    mt19937 gen(7);
+    for (auto& c : plaintext) c = static_cast<char>(gen());
+    string encrypted;
+
+    BenchResult enc = run_bench(config, "encrypt_data", count,
+                                [&] { encrypted = encrypt_data(plaintext, BENCH_PASSWORD); });
+    enc.bytes = plaintext.size();
+    enc.items = 1;
+    report(enc);
+
+    BenchResult dec = run_bench(config, "decrypt_data", count, [&] {
+        if (decrypt_data(encrypted, BENCH_PASSWORD).size() != plaintext.size()) exit(1);
+    });
+    dec.bytes = plaintext.size();
+    dec.items = 1;
+    report(dec);
+
+    // Шифр блоков v2 на каждом ядре, которое есть у процессора
+    uint8_t key[CHACHA_KEY_SIZE]     = {1};
+    uint8_t nonce[CHACHA_NONCE_SIZE] = {2};
+    uint8_t tag[POLY1305_TAG_SIZE];
+    for (CipherPath path : {CipherPath::Scalar, CipherPath::SSE2, CipherPath::AVX2}) {
+        if (!cipher_set_path(path)) continue;
+        string      name = string("chacha20_poly1305_") + cipher_path_name(path);
+        BenchResult aead = run_bench(config, name, count, [&] {
+            aead_seal(key, nonce, nullptr, 0, (uint8_t*)plaintext.data(), plaintext.size(), tag);
+        });
+        aead.bytes = plaintext.size();
+        aead.items = 1;
+        report(aead);
+    }
+    cipher_set_path(cipher_best_path());
+
+    // Построение поискового индекса (часть db_load_file)
+    BenchResult reindex =
+        run_bench(config, "search_index_rebuild", count, [&] { vault.reindex(); });
+    reindex.items = count;
+    report(reindex);
+
+    // Фильтрация списка, как в updateBrowser
+    struct Query {
+        const char* name;
+        const char* text;
+    };
+    const Query queries[] = {{"updateBrowser_filter_all", ""},
+                             {"updateBrowser_filter_short", "al"},
+                             {"updateBrowser_filter_common", "alpha"},
+                             {"updateBrowser_filter_rare", "-4242."},
+                             {"updateBrowser_filter_none", "zz-no-match"}};
+    for (const auto& query : queries) {
+        size_t      matched = 0;
+        BenchResult filter  = run_bench(config, query.name, count, [&] {
+            matched = entry_view::filter_entries(vault.entries, vault.search, query.text).size();
+        });
+        filter.items = count;
+        report(filter);
+        (void)matched;
+    }
+
+    // Набор запроса по букве в фоновом поиске: от последней буквы до полного результата
+    {
+        mutex                   vaultMutex;
+        mutex                   resultMutex;
+        condition_variable      resultReady;
+        uint64_t                done = 0;
+        SearchWorker            worker(vault, vaultMutex, [&](SearchResult result) {
+            if (!result.complete) return;
+            lock_guard<mutex> lock(resultMutex);
+            done = result.generation;
+            resultReady.notify_all();
+        });
+        const string typed = "alpha-42";
+
+        BenchResult typing = run_bench(config, "SearchWorker_typing", count, [&] {
+            uint64_t generation = worker.submit("");
+            for (size_t len = 1; len <= typed.size(); ++len) {
+                generation = worker.submit(typed.substr(0, len));
+            }
+            unique_lock<mutex> lock(resultMutex);
+            resultReady.wait(lock, [&] { return done == generation; });
+        });
+        typing.items = typed.size();
+        report(typing);
+    }
+
+    // Выбранная строка -> запись по постоянному номеру: случайные строки по всему списку
+    vector<uint64_t> rowIds;
+    for (int index : entry_view::filter_entries(vault.entries, vault.search, "")) {
+        rowIds.push_back(vault.entries[index].id);
+    }
+    mt19937      rowGen(1);
+    volatile int sink = 0;
+    BenchResult  find = run_bench(config, "selectedEntry", count, [&] {
+        sink = vault.index_of(rowIds[rowGen() % rowIds.size()]);
+    });
+    find.items = 1;
+    report(find);
+    (void)sink;
+
+    filesystem::remove(path);
+    filesystem::remove(copy);
+}
+
+void bench_kdf(const BenchConfig& config) {
+    uint8_t     salt[16] = {0};
+    uint8_t     key[32];
+    BenchResult kdf = run_bench(config, "derive_key_simple", 0, [&] {
+        derive_key_simple(BENCH_PASSWORD, salt, sizeof(salt), key, sizeof(key));
+    });
+    kdf.items = 1;
+    report(kdf);
+
+    BenchResult argon = run_bench(config, "argon2id_default", 0, [&] {
+        argon2id(BENCH_PASSWORD, strlen(BENCH_PASSWORD), salt, sizeof(salt), KDF_DEFAULT, key,
+                 sizeof(key));
+    });
+    argon.items = 1;
+    report(argon);
+}
+
+// Пакет паролей для плановой смены: 10000 штук по 20 символов, все классы обязательны
+void bench_generator(const BenchConfig& config) {
+    constexpr size_t BATCH = 10000;
+
+    PasswordPolicy policy;
+    policy.length      = 20;
+    policy.min_lower   = 1;
+    policy.min_upper   = 1;
+    policy.min_digits  = 1;
+    policy.min_special = 1;
+
+    PasswordGenerator generator;
+    vector<string>    passwords;
+    BenchResult       batch = run_bench(config, "generate_password_batch", 0, [&] {
+        generator.generate_batch(policy, BATCH, passwords);
+    });
+    batch.items = BATCH;
+    batch.bytes = BATCH * policy.length;
+    report(batch);
+}
+
+// Оценка стойкости: пароль целиком и посимвольный ввод, как в редакторе записи
+void bench_strength(const BenchConfig& config) {
+    const string password = "Tr0ub4dor&3-correct-horse-1990";
+
+    BenchResult full = run_bench(config, "strength_estimate", 0,
+                                 [&] { StrengthEstimator::estimate(password); });
+    full.items = 1;
+    report(full);
+
+    StrengthEstimator estimator;
+    BenchResult       typing = run_bench(config, "strength_update_typing", 0, [&] {
+        for (size_t len = 1; len <= password.size(); ++len) {
+            estimator.update(string_view(password).substr(0, len));
+        }
+        estimator.clear();
+    });
+    typing.items = password.size();
+    report(typing);
+}
+
+vector<size_t> parse_sizes(const string& value) {
+    vector<size_t> sizes;
+    size_t         pos = 0;
+    while (pos < value.size()) {
+        size_t comma = value.find(',', pos);
+        if (comma == string::npos) comma = value.size();
+        sizes.push_back(stoull(value.substr(pos, comma - pos)));
+        pos = comma + 1;
+    }
+    return sizes;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--sizes=", 0) == 0) {
+            config.sizes = parse_sizes(arg.substr(8));
+        } else if (arg.rfind("--budget-ms=", 0) == 0) {
+            config.budgetMs = stod(arg.substr(12));
+        } else if (arg.rfind("--min-iterations=", 0) == 0) {
+            config.minIterations = stoi(arg.substr(17));
+        } else if (arg == "--selftest") {
+            return run_selftest();
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--sizes=1000,10000] [--budget-ms=1000] [--min-iterations=3]\n"
+                    "       %s --selftest\n",
+                    argv[0], argv[0]);
+            return 2;
+        }
+    }
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__OPTIMIZE__)
+    // Замеры отладочной сборки (-O0) ничего не говорят о скорости приложения
+    fprintf(stderr, "warning: hush_bench is built without optimization\n");
+#endif
+
+    bench_kdf(config);
+    bench_generator(config);
+    bench_strength(config);
+    for (size_t count : config.sizes) {
+        bench_size(config, count);
+    }
+    return 0;
+}
@@ -0,0 +1,334 @@
+// breach_compile - сборка файла утечек для BreachCorpus (breach_corpus.h) из текстовой
+// выгрузки SHA-1, например Have I Been Pwned: по строке "HEX[:COUNT]" на пароль,
+// в любом порядке и регистре.
+//
+// Выгрузка бывает больше памяти: записи сортируются частями по --memory МиБ во временные
+// файлы рядом с результатом и затем сливаются, одинаковые хеши складываются. Фильтр
+// Блума (--bloom-bits битов на хеш, 0 - без фильтра) строится в памяти: около гигабайта
+// на миллиард хешей при 10 битах.
+//
+//   breach_compile [--bloom-bits=10] [--memory=1024] <pwned-passwords.txt> <corpus.hbc>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "breach_corpus.h"
+
+using namespace std;
+using namespace breach_format;
+
+namespace {
+
+constexpr uint64_t RECORDS_PER_BUCKET = 128;  // Корзина - около 3 КиБ, меньше страницы
+constexpr size_t   READ_RECORDS       = 4096;
+
+bool hash_less(const BreachRecord& a, const BreachRecord& b) {
+    return memcmp(a.hash, b.hash, HASH_SIZE) < 0;
+}
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "HEX" или "HEX:COUNT"; без числа пароль считается встреченным один раз
+bool parse_line(const string& line, BreachRecord& record) {
+    if (line.size() < 2 * HASH_SIZE) return false;
+    for (size_t i = 0; i < HASH_SIZE; ++i) {
+        int hi = hex_digit(line[2 * i]), lo = hex_digit(line[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        record.hash[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+
+    record.count = 1;
+    if (line.size() == 2 * HASH_SIZE) return true;
+    if (line[2 * HASH_SIZE] != ':') return false;
+
+    const char*        digits = line.c_str() + 2 * HASH_SIZE + 1;
+    char*              end    = nullptr;
+    unsigned long long count  = strtoull(digits, &end, 10);
+    if (end == digits || *end != '\0') return false;
+    record.count = static_cast<uint32_t>(clamp<unsigned long long>(count, 1, UINT32_MAX));
+    return true;
+}
+
+// Отсортированная часть во временном файле, читается блоками
+class RunReader {
+   public:
+    explicit RunReader(const string& path) : in_(path, ios::binary) {}
+
+    bool next(BreachRecord& record) {
+        if (pos_ == buffer_.size()) {
+            buffer_.resize(READ_RECORDS);
+            in_.read(reinterpret_cast<char*>(buffer_.data()), READ_RECORDS * sizeof(BreachRecord));
+            buffer_.resize(static_cast<size_t>(in_.gcount()) / sizeof(BreachRecord));
+            pos_ = 0;
+            if (buffer_.empty()) return false;
+        }
+        record = buffer_[pos_++];
+        return true;
+    }
+
+   private:
+    ifstream             in_;
+    vector<BreachRecord> buffer_;
+    size_t               pos_ = 0;
+};
+
+class CorpusWriter {
+   public:
+    CorpusWriter(const string& path, uint64_t maxCount, double bloomBits)
+        : out_(path, ios::binary | ios::trunc) {
+        fanoutBits_ = 0;
+        while (fanoutBits_ < MAX_FANOUT_BITS &&
+               (uint64_t(1) << fanoutBits_) * RECORDS_PER_BUCKET < maxCount) {
+            ++fanoutBits_;
+        }
+        buckets_.assign((size_t(1) << fanoutBits_) + 1, 0);
+
+        if (bloomBits > 0 && maxCount > 0) {
+            uint64_t bits = static_cast<uint64_t>(ceil(maxCount * bloomBits));
+            bloomBlocks_  = (bits + BLOOM_BLOCK_BITS - 1) / BLOOM_BLOCK_BITS;
+            bloomHashes_  = static_cast<uint32_t>(
+                clamp<long>(lround(bloomBits * log(2.0)), 1, MAX_BLOOM_HASHES));
+            bloom_.assign(bloomBlocks_ * (BLOOM_BLOCK_BITS / 8), 0);
+        }
+
+        // Заголовок и fanout дописываются в конце, когда известно число записей
+        recordsOffset_ = sizeof(Header) + buckets_.size() * sizeof(uint64_t);
+        out_.seekp(static_cast<streamoff>(recordsOffset_));
+    }
+
+    // Записи приходят по возрастанию хеша; одинаковые складываются
+    void add(const BreachRecord& record) {
+        if (pending_ && memcmp(last_.hash, record.hash, HASH_SIZE) == 0) {
+            last_.count = static_cast<uint32_t>(min<uint64_t>(uint64_t(last_.count) + record.count,
+                                                              UINT32_MAX));
+            return;
+        }
+        if (pending_) emit(last_);
+        last_    = record;
+        pending_ = true;
+    }
+
+    bool finish() {
+        if (pending_) emit(last_);
+        flush_records();
+
+        Header header         = {};
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version        = VERSION;
+        header.fanout_bits    = fanoutBits_;
+        header.count          = count_;
+        header.fanout_offset  = sizeof(Header);
+        header.records_offset = recordsOffset_;
+
+        if (!bloom_.empty()) {
+            uint64_t end        = recordsOffset_ + count_ * sizeof(BreachRecord);
+            header.bloom_offset = (end + 63) / 64 * 64;
+            header.bloom_blocks = bloomBlocks_;
+            header.bloom_hashes = bloomHashes_;
+            out_.seekp(static_cast<streamoff>(header.bloom_offset));
+            out_.write(reinterpret_cast<const char*>(bloom_.data()),
+                       static_cast<streamsize>(bloom_.size()));
+        }
+
+        // Число записей в каждой корзине -> начало корзины
+        uint64_t start = 0;
+        for (auto& bucket : buckets_) {
+            uint64_t n = bucket;
+            bucket     = start;
+            start += n;
+        }
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out_.write(reinterpret_cast<const char*>(buckets_.data()),
+                   static_cast<streamsize>(buckets_.size() * sizeof(uint64_t)));
+        out_.flush();
+        return out_.good();
+    }
+
+    uint64_t count() const { return count_; }
+    bool     good() const { return out_.good(); }
+
+   private:
+    void emit(const BreachRecord& record) {
+        uint32_t prefix = uint32_t(record.hash[0]) << 24 | uint32_t(record.hash[1]) << 16 |
+                          uint32_t(record.hash[2]) << 8 | record.hash[3];
+        ++buckets_[fanoutBits_ ? prefix >> (32 - fanoutBits_) : 0];
+
+        if (!bloom_.empty()) {
+            uint8_t* block = bloom_.data() + bloom_block(record.hash, bloomBlocks_) * 64;
+            for (uint32_t i = 0; i < bloomHashes_; ++i) {
+                uint32_t bit = bloom_bit(record.hash, i);
+                block[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+            }
+        }
+
+        batch_.push_back(record);
+        if (batch_.size() == READ_RECORDS) flush_records();
+        ++count_;
+    }
+
+    void flush_records() {
+        out_.write(reinterpret_cast<const char*>(batch_.data()),
+                   static_cast<streamsize>(batch_.size() * sizeof(BreachRecord)));
+        batch_.clear();
+    }
+
+    ofstream             out_;
+    uint32_t             fanoutBits_;
+    vector<uint64_t>     buckets_;  // Сначала число записей в корзине, в конце - начало
+    uint64_t             recordsOffset_;
+    vector<uint8_t>      bloom_;
+    uint64_t             bloomBlocks_ = 0;
+    uint32_t             bloomHashes_ = 0;
+    vector<BreachRecord> batch_;
+    BreachRecord         last_    = {};
+    bool                 pending_ = false;
+    uint64_t             count_   = 0;
+};
+
+bool write_run(vector<BreachRecord>& records, const string& path) {
+    sort(records.begin(), records.end(), hash_less);
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(records.data()),
+              static_cast<streamsize>(records.size() * sizeof(BreachRecord)));
+    records.clear();
+    return out.good();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    double           bloomBits = 10;
+    size_t           memoryMb  = 1024;
+    vector<string>   paths;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--bloom-bits=", 0) == 0) {
+            bloomBits = atof(arg.c_str() + 13);
+        } else if (arg.rfind("--memory=", 0) == 0) {
+            memoryMb = strtoull(arg.c_str() + 9, nullptr, 10);
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2 || bloomBits < 0 || bloomBits > 64 || memoryMb == 0) {
+        fprintf(stderr,
+                "usage: %s [--bloom-bits=10] [--memory=1024] <pwned-passwords.txt> "
+                "<corpus.hbc>\n",
+                argv[0]);
+        return 2;
+    }
+    const string& input  = paths[0];
+    const string& output = paths[1];
+
+    ifstream in(input);
+    if (!in) {
+        fprintf(stderr, "breach_compile: cannot read '%s'\n", input.c_str());
+        return 1;
+    }
+
+    // Чтение и сортировка частями
+    size_t               runRecords = memoryMb * 1024 * 1024 / sizeof(BreachRecord);
+    vector<BreachRecord> records;
+    vector<string>       runs;
+    uint64_t             total = 0;
+    string               line;
+    auto                 cleanup = [&] {
+        for (const auto& run : runs) filesystem::remove(run);
+    };
+
+    records.reserve(min<size_t>(runRecords, 1 << 20));
+    for (uint64_t lineNo = 1; getline(in, line); ++lineNo) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        BreachRecord record;
+        if (!parse_line(line, record)) {
+            fprintf(stderr, "breach_compile: %s:%llu: expected HEX[:COUNT]\n", input.c_str(),
+                    static_cast<unsigned long long>(lineNo));
+            cleanup();
+            return 1;
+        }
+        records.push_back(record);
+        ++total;
+
+        if (records.size() == runRecords) {
+            runs.push_back(output + ".run" + to_string(runs.size()));
+            if (!write_run(records, runs.back())) {
+                fprintf(stderr, "breach_compile: cannot write '%s'\n", runs.back().c_str());
+                cleanup();
+                return 1;
+            }
+            fprintf(stderr, "breach_compile: %llu hashes sorted\n",
+                    static_cast<unsigned long long>(total));
+        }
+    }
+    if (in.bad()) {
+        fprintf(stderr, "breach_compile: error reading '%s'\n", input.c_str());
+        cleanup();
+        return 1;
+    }
+
+    // Слияние: одна часть целиком в памяти или k-путевое слияние файлов
+    string       tmp = output + ".tmp";
+    CorpusWriter writer(tmp, total, bloomBits);
+    if (runs.empty()) {
+        sort(records.begin(), records.end(), hash_less);
+        for (const auto& record : records) writer.add(record);
+    } else {
+        if (!records.empty()) {
+            runs.push_back(output + ".run" + to_string(runs.size()));
+            if (!write_run(records, runs.back())) {
+                fprintf(stderr, "breach_compile: cannot write '%s'\n", runs.back().c_str());
+                cleanup();
+                return 1;
+            }
+        }
+        vector<BreachRecord>().swap(records);
+
+        using Head = pair<BreachRecord, size_t>;
+        auto later = [](const Head& a, const Head& b) { return hash_less(b.first, a.first); };
+        priority_queue<Head, vector<Head>, decltype(later)> heads(later);
+
+        vector<RunReader> readers;
+        readers.reserve(runs.size());
+        for (size_t i = 0; i < runs.size(); ++i) {
+            readers.emplace_back(runs[i]);
+            BreachRecord record;
+            if (readers[i].next(record)) heads.push({record, i});
+        }
+        while (!heads.empty()) {
+            auto [record, run] = heads.top();
+            heads.pop();
+            writer.add(record);
+            if (readers[run].next(record)) heads.push({record, run});
+        }
+    }
+
+    bool ok = writer.finish();
+    cleanup();
+    error_code ec;
+    if (ok) filesystem::rename(tmp, output, ec);
+    if (!ok || ec) {
+        fprintf(stderr, "breach_compile: cannot write '%s'\n", output.c_str());
+        filesystem::remove(tmp, ec);
+        return 1;
+    }
+
+    fprintf(stderr, "breach_compile: %llu distinct hashes written to %s\n",
+            static_cast<unsigned long long>(writer.count()), output.c_str());
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "breach_corpus.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "secure_arena.h"
+
+using namespace std;
+using namespace breach_format;
+
+namespace {
+
+uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+uint32_t load32_be(const uint8_t* p) {
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+}
+
+uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void sha1_block(uint32_t* h, const uint8_t* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) w[i] = load32_be(block + 4 * i);
+    for (int i = 16; i < 80; ++i) w[i] = rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        uint32_t t = rotl32(a, 5) + f + e + k + w[i];
+        e          = d;
+        d          = c;
+        c          = rotl32(b, 30);
+        b          = a;
+        a          = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    secure_zero(w, sizeof(w));
+}
+
+}  // namespace
+
+// SHA-1 нужен только для сверки с выгрузками утечек, где пароли хранятся так
+void sha1(const void* in, size_t inLen, uint8_t* out) {
+    uint32_t       h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    const uint8_t* p    = static_cast<const uint8_t*>(in);
+
+    size_t full = inLen / 64 * 64;
+    for (size_t i = 0; i < full; i += 64) sha1_block(h, p + i);
+
+    // Хвост, единичный бит и длина в битах; хвост, расписание слов и состояние
+    // затираются: в них остаются следы пароля
+    uint8_t  tail[128] = {};
+    size_t   rest      = inLen - full;
+    size_t   padded    = rest < 56 ? 64 : 128;
+    uint64_t bits      = uint64_t(inLen) * 8;
+    if (rest) memcpy(tail, p + full, rest);
+    tail[rest] = 0x80;
+    for (int i = 0; i < 8; ++i) tail[padded - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+
+    sha1_block(h, tail);
+    if (padded == 128) sha1_block(h, tail + 64);
+    secure_zero(tail, sizeof(tail));
+
+    for (int i = 0; i < 5; ++i) {
+        out[4 * i]     = static_cast<uint8_t>(h[i] >> 24);
+        out[4 * i + 1] = static_cast<uint8_t>(h[i] >> 16);
+        out[4 * i + 2] = static_cast<uint8_t>(h[i] >> 8);
+        out[4 * i + 3] = static_cast<uint8_t>(h[i]);
+    }
+    secure_zero(h, sizeof(h));
+}
+
+namespace breach_format {
+
+uint64_t bloom_block(const uint8_t* hash, uint64_t blocks) {
+    return load64(hash + 4) % blocks;
+}
+
+uint32_t bloom_bit(const uint8_t* hash, uint32_t index) {
+    return static_cast<uint32_t>(load64(hash + 12) >> (9 * index)) % BLOOM_BLOCK_BITS;
+}
+
+}  // namespace breach_format
+
+bool BreachCorpus::open(const string& path) {
+    close();
+    if (!file_.open(path, true)) return false;
+
+    const uint8_t* data = file_.data();
+    uint64_t       size = file_.size();
+    if (size < sizeof(Header)) return fail();
+
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+        header->fanout_bits > MAX_FANOUT_BITS) {
+        return fail();
+    }
+
+    // Таблицы не выходят за файл и выровнены под свои типы
+    uint64_t buckets = (uint64_t(1) << header->fanout_bits) + 1;
+    auto     fits    = [&](uint64_t offset, uint64_t count, uint64_t item, uint64_t align) {
+        return offset % align == 0 && offset <= size && count <= (size - offset) / item;
+    };
+    if (!fits(header->fanout_offset, buckets, sizeof(uint64_t), alignof(uint64_t)) ||
+        !fits(header->records_offset, header->count, sizeof(BreachRecord),
+              alignof(BreachRecord))) {
+        return fail();
+    }
+    if (header->bloom_offset != 0 &&
+        (header->bloom_blocks == 0 || header->bloom_hashes == 0 ||
+         header->bloom_hashes > MAX_BLOOM_HASHES ||
+         !fits(header->bloom_offset, header->bloom_blocks, BLOOM_BLOCK_BITS / 8, 8))) {
+        return fail();
+    }
+
+    const uint64_t* fanout = reinterpret_cast<const uint64_t*>(data + header->fanout_offset);
+    if (fanout[0] != 0 || fanout[buckets - 1] != header->count) return fail();
+
+    header_  = header;
+    fanout_  = fanout;
+    records_ = reinterpret_cast<const BreachRecord*>(data + header->records_offset);
+    bloom_   = header->bloom_offset ? data + header->bloom_offset : nullptr;
+    path_    = path;
+    file_.advise_random();
+    return true;
+}
+
+bool BreachCorpus::fail() {
+    file_.close();
+    return false;
+}
+
+void BreachCorpus::close() {
+    file_.close();
+    path_.clear();
+    header_  = nullptr;
+    fanout_  = nullptr;
+    records_ = nullptr;
+    bloom_   = nullptr;
+}
+
+uint32_t BreachCorpus::check(string_view password) const {
+    if (!header_) return 0;
+
+    uint8_t hash[HASH_SIZE];
+    sha1(password.data(), password.size(), hash);
+    uint32_t count = check_hash(hash);
+    secure_zero(hash, sizeof(hash));
+    return count;
+}
+
+uint32_t BreachCorpus::check_hash(const uint8_t* hash) const {
+    if (!header_) return 0;
+
+    if (bloom_) {
+        uint64_t       index = bloom_block(hash, header_->bloom_blocks);
+        const uint8_t* block = bloom_ + index * (BLOOM_BLOCK_BITS / 8);
+        for (uint32_t i = 0; i < header_->bloom_hashes; ++i) {
+            uint32_t bit = bloom_bit(hash, i);
+            if (!(block[bit / 8] & (1u << (bit % 8)))) return 0;
+        }
+    }
+
+    // Корзина по первым fanout_bits битам; границы проверены только для последней,
+    // поэтому внутренние ещё раз ограничиваются числом записей
+    uint32_t bits   = header_->fanout_bits;
+    uint64_t bucket = bits ? load32_be(hash) >> (32 - bits) : 0;
+    uint64_t lo     = min(fanout_[bucket], header_->count);
+    uint64_t hi     = min(fanout_[bucket + 1], header_->count);
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        int      cmp = memcmp(records_[mid].hash, hash, HASH_SIZE);
+        if (cmp == 0) return max<uint32_t>(records_[mid].count, 1);
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef BREACH_CORPUS_H
+#define BREACH_CORPUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "mapped_file.h"
+
+// Файл утёкших паролей (.hbc), который собирает breach_compile из выгрузки SHA-1
+// вида Have I Been Pwned ("HEX:COUNT" по строке на хеш). Внутри, после заголовка:
+//
+//   fanout   (2^fanout_bits + 1) x uint64: записи с первыми fanout_bits битами хеша,
+//            равными b, лежат в [fanout[b], fanout[b + 1])
+//   records  count x BreachRecord по возрастанию хеша
+//   bloom    необязательный блочный фильтр Блума: по блоку в 64 байта на хеш, в блоке
+//            bloom_hashes битов. Отсутствующий хеш (почти все пароли хранилища) он
+//            отсекает за одно обращение к одной странице
+//
+// Числа - в порядке байтов машины, собравшей файл, как и в самом хранилище.
+namespace breach_format {
+
+constexpr char     MAGIC[8]         = {'H', 'U', 'S', 'H', 'B', 'R', 'C', '1'};
+constexpr uint32_t VERSION          = 1;
+constexpr size_t   HASH_SIZE        = 20;  // SHA-1
+constexpr size_t   BLOOM_BLOCK_BITS = 512;
+constexpr uint32_t MAX_FANOUT_BITS  = 28;
+constexpr uint32_t MAX_BLOOM_HASHES = 7;  // По 9 битов номера в 64-битной части хеша
+
+struct Header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t fanout_bits;
+    uint64_t count;
+    uint64_t fanout_offset;
+    uint64_t records_offset;
+    uint64_t bloom_offset;  // 0 - фильтра нет
+    uint64_t bloom_blocks;
+    uint32_t bloom_hashes;
+    uint32_t reserved;
+};
+static_assert(sizeof(Header) == 64);
+
+struct BreachRecord {
+    uint8_t  hash[HASH_SIZE];
+    uint32_t count;  // Сколько раз пароль встречался в утечках
+};
+static_assert(sizeof(BreachRecord) == 24);
+
+// Номер блока фильтра и биты в нём берутся из байтов хеша за fanout: SHA-1 и так
+// равномерен, второй хеш не нужен
+uint64_t bloom_block(const uint8_t* hash, uint64_t blocks);
+uint32_t bloom_bit(const uint8_t* hash, uint32_t index);
+
+}  // namespace breach_format
+
+void sha1(const void* in, size_t inLen, uint8_t* out);
+
+// Проверка паролей по файлу утечек целиком офлайн. Файл отображается в память только
+// для чтения и в память не загружается: поиск читает страницу фильтра, а если хеш в нём
+// есть - страницу fanout и одну-две страницы записей. Проверки из нескольких потоков
+// безопасны
+class BreachCorpus {
+   public:
+    BreachCorpus() = default;
+
+    BreachCorpus(const BreachCorpus&)            = delete;
+    BreachCorpus& operator=(const BreachCorpus&) = delete;
+
+    // false - файла нет или он повреждён (заголовок и границы таблиц не сходятся)
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return header_ != nullptr; }
+
+    const std::string& path() const { return path_; }
+    uint64_t           size() const { return header_ ? header_->count : 0; }
+
+    // Сколько раз пароль встречался в утечках, 0 - не встречался
+    uint32_t check(std::string_view password) const;
+    uint32_t check_hash(const uint8_t* hash) const;
+
+   private:
+    bool fail();
+
+    MappedFile                         file_;
+    std::string                        path_;
+    const breach_format::Header*       header_  = nullptr;
+    const uint64_t*                    fanout_  = nullptr;
+    const breach_format::BreachRecord* records_ = nullptr;
+    const uint8_t*                     bloom_   = nullptr;
+};
+
+#endif
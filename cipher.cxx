@@ -0,0 +1,476 @@
+#include "cipher.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HUSH_CIPHER_X86 1
+#include <immintrin.h>
+#endif
+
+#include "secure_arena.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t CHACHA_BLOCK = 64;
+
+inline uint32_t load32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;  // Как и весь формат файла, считаем, что порядок байт little-endian
+}
+
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void store64(uint8_t* p, uint64_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// Ядро: XOR data с ключевым потоком от состояния state, state[12] (счётчик блоков)
+// продвигается на число использованных блоков
+using XorFn = void (*)(uint32_t* state, uint8_t* data, size_t len);
+
+// Скалярное ядро
+
+inline uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+inline void quarter_round(uint32_t* x, int a, int b, int c, int d) {
+    x[a] += x[b], x[d] = rotl32(x[d] ^ x[a], 16);
+    x[c] += x[d], x[b] = rotl32(x[b] ^ x[c], 12);
+    x[a] += x[b], x[d] = rotl32(x[d] ^ x[a], 8);
+    x[c] += x[d], x[b] = rotl32(x[b] ^ x[c], 7);
+}
+
+void chacha_block(const uint32_t* state, uint32_t* out) {
+    memcpy(out, state, CHACHA_BLOCK);
+    for (int i = 0; i < 10; ++i) {
+        quarter_round(out, 0, 4, 8, 12);
+        quarter_round(out, 1, 5, 9, 13);
+        quarter_round(out, 2, 6, 10, 14);
+        quarter_round(out, 3, 7, 11, 15);
+        quarter_round(out, 0, 5, 10, 15);
+        quarter_round(out, 1, 6, 11, 12);
+        quarter_round(out, 2, 7, 8, 13);
+        quarter_round(out, 3, 4, 9, 14);
+    }
+    for (int i = 0; i < 16; ++i) out[i] += state[i];
+}
+
+void xor_scalar(uint32_t* state, uint8_t* data, size_t len) {
+    uint32_t block[16];
+    while (len > 0) {
+        chacha_block(state, block);
+        ++state[12];
+
+        size_t n = min(len, CHACHA_BLOCK);
+        if (n == CHACHA_BLOCK) {
+            for (int i = 0; i < 16; ++i) {
+                uint32_t word = load32(data + 4 * i) ^ block[i];
+                memcpy(data + 4 * i, &word, sizeof(word));
+            }
+        } else {
+            const uint8_t* stream = reinterpret_cast<const uint8_t*>(block);
+            for (size_t i = 0; i < n; ++i) data[i] ^= stream[i];
+        }
+        data += n;
+        len -= n;
+    }
+    secure_zero(block, sizeof(block));
+}
+
+#ifdef HUSH_CIPHER_X86
+// Векторные ядра считают несколько блоков сразу: в векторе x[i] лежит слово i
+// состояния всех блоков, после раундов слова перекладываются обратно по блокам.
+
+#define HUSH_SSE2 __attribute__((target("sse2")))
+#define HUSH_AVX2 __attribute__((target("avx2")))
+
+template <int N>
+HUSH_SSE2 inline __m128i rotl_sse2(__m128i x) {
+    return _mm_or_si128(_mm_slli_epi32(x, N), _mm_srli_epi32(x, 32 - N));
+}
+
+HUSH_SSE2 inline void quarter_round_sse2(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+    a = _mm_add_epi32(a, b), d = rotl_sse2<16>(_mm_xor_si128(d, a));
+    c = _mm_add_epi32(c, d), b = rotl_sse2<12>(_mm_xor_si128(b, c));
+    a = _mm_add_epi32(a, b), d = rotl_sse2<8>(_mm_xor_si128(d, a));
+    c = _mm_add_epi32(c, d), b = rotl_sse2<7>(_mm_xor_si128(b, c));
+}
+
+HUSH_SSE2 void xor_sse2(uint32_t* state, uint8_t* data, size_t len) {
+    const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+
+    for (; len >= 4 * CHACHA_BLOCK; data += 4 * CHACHA_BLOCK, len -= 4 * CHACHA_BLOCK) {
+        __m128i x[16], in[16];
+        for (int i = 0; i < 16; ++i) in[i] = _mm_set1_epi32(static_cast<int>(state[i]));
+        in[12] = _mm_add_epi32(in[12], lanes);
+        for (int i = 0; i < 16; ++i) x[i] = in[i];
+
+        for (int i = 0; i < 10; ++i) {
+            quarter_round_sse2(x[0], x[4], x[8], x[12]);
+            quarter_round_sse2(x[1], x[5], x[9], x[13]);
+            quarter_round_sse2(x[2], x[6], x[10], x[14]);
+            quarter_round_sse2(x[3], x[7], x[11], x[15]);
+            quarter_round_sse2(x[0], x[5], x[10], x[15]);
+            quarter_round_sse2(x[1], x[6], x[11], x[12]);
+            quarter_round_sse2(x[2], x[7], x[8], x[13]);
+            quarter_round_sse2(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; ++i) x[i] = _mm_add_epi32(x[i], in[i]);
+
+        // Транспонирование 4x4: четвёрка слов 4g..4g+3 каждого блока
+        for (int g = 0; g < 4; ++g) {
+            __m128i t0 = _mm_unpacklo_epi32(x[4 * g], x[4 * g + 1]);
+            __m128i t1 = _mm_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+            __m128i t2 = _mm_unpackhi_epi32(x[4 * g], x[4 * g + 1]);
+            __m128i t3 = _mm_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+
+            __m128i words[4] = {_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+                                _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)};
+            for (int b = 0; b < 4; ++b) {
+                __m128i* p = reinterpret_cast<__m128i*>(data + b * CHACHA_BLOCK + 16 * g);
+                _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), words[b]));
+            }
+        }
+        state[12] += 4;
+    }
+    xor_scalar(state, data, len);
+}
+
+template <int N>
+HUSH_AVX2 inline __m256i rotl_avx2(__m256i x) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, N), _mm256_srli_epi32(x, 32 - N));
+}
+
+// Повороты на 16 и 8 - перестановка байт, она дешевле двух сдвигов
+template <>
+HUSH_AVX2 inline __m256i rotl_avx2<16>(__m256i x) {
+    const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                                          13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    return _mm256_shuffle_epi8(x, rot16);
+}
+
+template <>
+HUSH_AVX2 inline __m256i rotl_avx2<8>(__m256i x) {
+    const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                                         14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+    return _mm256_shuffle_epi8(x, rot8);
+}
+
+HUSH_AVX2 inline void quarter_round_avx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d) {
+    a = _mm256_add_epi32(a, b), d = rotl_avx2<16>(_mm256_xor_si256(d, a));
+    c = _mm256_add_epi32(c, d), b = rotl_avx2<12>(_mm256_xor_si256(b, c));
+    a = _mm256_add_epi32(a, b), d = rotl_avx2<8>(_mm256_xor_si256(d, a));
+    c = _mm256_add_epi32(c, d), b = rotl_avx2<7>(_mm256_xor_si256(b, c));
+}
+
+HUSH_AVX2 void xor_avx2(uint32_t* state, uint8_t* data, size_t len) {
+    const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+    for (; len >= 8 * CHACHA_BLOCK; data += 8 * CHACHA_BLOCK, len -= 8 * CHACHA_BLOCK) {
+        __m256i x[16], in[16];
+        for (int i = 0; i < 16; ++i) in[i] = _mm256_set1_epi32(static_cast<int>(state[i]));
+        in[12] = _mm256_add_epi32(in[12], lanes);
+        for (int i = 0; i < 16; ++i) x[i] = in[i];
+
+        for (int i = 0; i < 10; ++i) {
+            quarter_round_avx2(x[0], x[4], x[8], x[12]);
+            quarter_round_avx2(x[1], x[5], x[9], x[13]);
+            quarter_round_avx2(x[2], x[6], x[10], x[14]);
+            quarter_round_avx2(x[3], x[7], x[11], x[15]);
+            quarter_round_avx2(x[0], x[5], x[10], x[15]);
+            quarter_round_avx2(x[1], x[6], x[11], x[12]);
+            quarter_round_avx2(x[2], x[7], x[8], x[13]);
+            quarter_round_avx2(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; ++i) x[i] = _mm256_add_epi32(x[i], in[i]);
+
+        // Транспонирование 4x4 идёт внутри 128-битных половин: в нижней - блоки 0-3,
+        // в верхней - блоки 4-7. words[g][b] - слова 4g..4g+3 блоков b и b + 4
+        __m256i words[4][4];
+        for (int g = 0; g < 4; ++g) {
+            __m256i t0 = _mm256_unpacklo_epi32(x[4 * g], x[4 * g + 1]);
+            __m256i t1 = _mm256_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+            __m256i t2 = _mm256_unpackhi_epi32(x[4 * g], x[4 * g + 1]);
+            __m256i t3 = _mm256_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+            words[g][0] = _mm256_unpacklo_epi64(t0, t1);
+            words[g][1] = _mm256_unpackhi_epi64(t0, t1);
+            words[g][2] = _mm256_unpacklo_epi64(t2, t3);
+            words[g][3] = _mm256_unpackhi_epi64(t2, t3);
+        }
+        for (int b = 0; b < 4; ++b) {
+            __m256i stream[4] = {_mm256_permute2x128_si256(words[0][b], words[1][b], 0x20),
+                                 _mm256_permute2x128_si256(words[2][b], words[3][b], 0x20),
+                                 _mm256_permute2x128_si256(words[0][b], words[1][b], 0x31),
+                                 _mm256_permute2x128_si256(words[2][b], words[3][b], 0x31)};
+            uint8_t* blocks[2] = {data + b * CHACHA_BLOCK, data + (b + 4) * CHACHA_BLOCK};
+            for (int i = 0; i < 4; ++i) {
+                __m256i* p = reinterpret_cast<__m256i*>(blocks[i / 2] + 32 * (i % 2));
+                _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), stream[i]));
+            }
+        }
+        state[12] += 8;
+    }
+    xor_sse2(state, data, len);
+}
+#endif
+
+bool path_supported(CipherPath path) {
+    switch (path) {
+        case CipherPath::Scalar: return true;
+#ifdef HUSH_CIPHER_X86
+        case CipherPath::SSE2: return __builtin_cpu_supports("sse2");
+        case CipherPath::AVX2: return __builtin_cpu_supports("avx2");
+#endif
+        default: return false;
+    }
+}
+
+XorFn path_kernel(CipherPath path) {
+#ifdef HUSH_CIPHER_X86
+    if (path == CipherPath::AVX2) return xor_avx2;
+    if (path == CipherPath::SSE2) return xor_sse2;
+#endif
+    return xor_scalar;
+}
+
+struct ActivePath {
+    atomic<CipherPath> path;
+    atomic<XorFn>      kernel;
+
+    ActivePath() : path(cipher_best_path()), kernel(path_kernel(path)) {}
+};
+
+ActivePath& active() {
+    static ActivePath instance;
+    return instance;
+}
+
+// Poly1305 на 64-битных словах: аккумулятор в трёх частях по 44, 44 и 42 бита
+class Poly1305 {
+   public:
+    explicit Poly1305(const uint8_t* key) {
+        uint64_t t0 = load64(key), t1 = load64(key + 8);
+        r_[0] = t0 & 0xffc0fffffffULL;
+        r_[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffULL;
+        r_[2] = (t1 >> 24) & 0x00ffffffc0fULL;
+        memcpy(pad_, key + 16, sizeof(pad_));
+    }
+
+    ~Poly1305() {
+        secure_zero(r_, sizeof(r_));
+        secure_zero(h_, sizeof(h_));
+        secure_zero(pad_, sizeof(pad_));
+    }
+
+    void update(const uint8_t* data, size_t len) {
+        if (len == 0) return;
+        if (used_ > 0) {
+            size_t n = min(len, sizeof(buffer_) - used_);
+            memcpy(buffer_ + used_, data, n);
+            used_ += n;
+            data += n;
+            len -= n;
+            if (used_ < sizeof(buffer_)) return;
+            blocks(buffer_, sizeof(buffer_), FULL_BLOCK_BIT);
+            used_ = 0;
+        }
+
+        size_t full = len & ~size_t(15);
+        blocks(data, full, FULL_BLOCK_BIT);
+        memcpy(buffer_, data + full, len - full);
+        used_ = len - full;
+    }
+
+    // Дополняет последний неполный блок нулями до 16 байт (как требует AEAD)
+    void pad16() {
+        if (used_ == 0) return;
+        memset(buffer_ + used_, 0, sizeof(buffer_) - used_);
+        blocks(buffer_, sizeof(buffer_), FULL_BLOCK_BIT);
+        used_ = 0;
+    }
+
+    void final(uint8_t* tag) {
+        if (used_ > 0) {
+            buffer_[used_] = 1;
+            memset(buffer_ + used_ + 1, 0, sizeof(buffer_) - used_ - 1);
+            blocks(buffer_, sizeof(buffer_), 0);
+        }
+
+        uint64_t h0 = h_[0], h1 = h_[1], h2 = h_[2], c;
+        c = h1 >> 44, h1 &= MASK44, h2 += c;
+        c = h2 >> 42, h2 &= MASK42, h0 += c * 5;
+        c = h0 >> 44, h0 &= MASK44, h1 += c;
+        c = h1 >> 44, h1 &= MASK44, h2 += c;
+        c = h2 >> 42, h2 &= MASK42, h0 += c * 5;
+        c = h0 >> 44, h0 &= MASK44, h1 += c;
+
+        // h - p; если не ушло в минус, берём его (без ветвлений)
+        uint64_t g0 = h0 + 5;
+        c           = g0 >> 44, g0 &= MASK44;
+        uint64_t g1 = h1 + c;
+        c           = g1 >> 44, g1 &= MASK44;
+        uint64_t g2 = h2 + c - (1ULL << 42);
+
+        uint64_t mask = (g2 >> 63) - 1;
+        h0            = (h0 & ~mask) | (g0 & mask);
+        h1            = (h1 & ~mask) | (g1 & mask);
+        h2            = (h2 & ~mask) | (g2 & mask);
+
+        uint64_t t0 = load64(pad_), t1 = load64(pad_ + 8);
+        h0 += t0 & MASK44;
+        c = h0 >> 44, h0 &= MASK44;
+        h1 += (((t0 >> 44) | (t1 << 20)) & MASK44) + c;
+        c = h1 >> 44, h1 &= MASK44;
+        h2 += ((t1 >> 24) & MASK42) + c;
+        h2 &= MASK42;
+
+        store64(tag, h0 | (h1 << 44));
+        store64(tag + 8, (h1 >> 20) | (h2 << 24));
+    }
+
+   private:
+    using u128 = unsigned __int128;
+
+    static constexpr uint64_t MASK44         = 0xfffffffffffULL;
+    static constexpr uint64_t MASK42         = 0x3ffffffffffULL;
+    static constexpr uint64_t FULL_BLOCK_BIT = 1ULL << 40;  // 2^128 в старшей части
+
+    void blocks(const uint8_t* data, size_t len, uint64_t hibit) {
+        const uint64_t r0 = r_[0], r1 = r_[1], r2 = r_[2];
+        const uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+        uint64_t       h0 = h_[0], h1 = h_[1], h2 = h_[2];
+
+        for (; len >= 16; data += 16, len -= 16) {
+            uint64_t t0 = load64(data), t1 = load64(data + 8);
+            h0 += t0 & MASK44;
+            h1 += ((t0 >> 44) | (t1 << 20)) & MASK44;
+            h2 += ((t1 >> 24) & MASK42) | hibit;
+
+            u128 d0 = (u128)h0 * r0 + (u128)h1 * s2 + (u128)h2 * s1;
+            u128 d1 = (u128)h0 * r1 + (u128)h1 * r0 + (u128)h2 * s2;
+            u128 d2 = (u128)h0 * r2 + (u128)h1 * r1 + (u128)h2 * r0;
+
+            uint64_t c = (uint64_t)(d0 >> 44);
+            h0         = (uint64_t)d0 & MASK44;
+            d1 += c;
+            c  = (uint64_t)(d1 >> 44);
+            h1 = (uint64_t)d1 & MASK44;
+            d2 += c;
+            c  = (uint64_t)(d2 >> 42);
+            h2 = (uint64_t)d2 & MASK42;
+            h0 += c * 5;
+            c = h0 >> 44, h0 &= MASK44;
+            h1 += c;
+        }
+        h_[0] = h0, h_[1] = h1, h_[2] = h2;
+    }
+
+    uint64_t r_[3];
+    uint64_t h_[3] = {};
+    uint8_t  pad_[16];
+    uint8_t  buffer_[16];
+    size_t   used_ = 0;
+};
+
+void chacha_init(uint32_t* state, const uint8_t* key, const uint8_t* nonce, uint32_t counter) {
+    // "expand 32-byte k"
+    state[0] = 0x61707865, state[1] = 0x3320646e, state[2] = 0x79622d32, state[3] = 0x6b206574;
+    for (int i = 0; i < 8; ++i) state[4 + i] = load32(key + 4 * i);
+    state[12] = counter;
+    for (int i = 0; i < 3; ++i) state[13 + i] = load32(nonce + 4 * i);
+}
+
+// Код подлинности AEAD: ad, шифротекст и их длины
+void aead_tag(const uint8_t* key, const uint8_t* nonce, const uint8_t* ad, size_t adLen,
+              const uint8_t* data, size_t len, uint8_t* tag) {
+    // Ключ Poly1305 - начало блока 0 ключевого потока
+    uint8_t  polyKey[CHACHA_BLOCK] = {};
+    uint32_t state[16];
+    chacha_init(state, key, nonce, 0);
+    xor_scalar(state, polyKey, sizeof(polyKey));
+    secure_zero(state, sizeof(state));
+
+    Poly1305 mac(polyKey);
+    secure_zero(polyKey, sizeof(polyKey));
+    mac.update(ad, adLen);
+    mac.pad16();
+    mac.update(data, len);
+    mac.pad16();
+
+    uint8_t lengths[16];
+    store64(lengths, adLen);
+    store64(lengths + 8, len);
+    mac.update(lengths, sizeof(lengths));
+    mac.final(tag);
+}
+
+}  // namespace
+
+CipherPath cipher_best_path() {
+    if (path_supported(CipherPath::AVX2)) return CipherPath::AVX2;
+    if (path_supported(CipherPath::SSE2)) return CipherPath::SSE2;
+    return CipherPath::Scalar;
+}
+
+CipherPath cipher_path() {
+    return active().path;
+}
+
+const char* cipher_path_name(CipherPath path) {
+    switch (path) {
+        case CipherPath::Scalar: return "scalar";
+        case CipherPath::SSE2: return "sse2";
+        case CipherPath::AVX2: return "avx2";
+    }
+    return "";
+}
+
+bool cipher_set_path(CipherPath path) {
+    if (!path_supported(path)) return false;
+    active().path   = path;
+    active().kernel = path_kernel(path);
+    return true;
+}
+
+void chacha20_xor(const uint8_t* key, const uint8_t* nonce, uint32_t counter, uint8_t* data,
+                  size_t len) {
+    uint32_t state[16];
+    chacha_init(state, key, nonce, counter);
+    active().kernel.load()(state, data, len);
+    secure_zero(state, sizeof(state));
+}
+
+void poly1305(const uint8_t* key, const uint8_t* data, size_t len, uint8_t* tag) {
+    Poly1305 mac(key);
+    mac.update(data, len);
+    mac.final(tag);
+}
+
+void aead_seal(const uint8_t* key, const uint8_t* nonce, const uint8_t* ad, size_t adLen,
+               uint8_t* data, size_t len, uint8_t* tag) {
+    chacha20_xor(key, nonce, 1, data, len);
+    aead_tag(key, nonce, ad, adLen, data, len, tag);
+}
+
+bool aead_open(const uint8_t* key, const uint8_t* nonce, const uint8_t* ad, size_t adLen,
+               uint8_t* data, size_t len, const uint8_t* tag) {
+    uint8_t expected[POLY1305_TAG_SIZE];
+    aead_tag(key, nonce, ad, adLen, data, len, expected);
+
+    // Сравнение за постоянное время: по нему нельзя подбирать tag побайтно
+    uint8_t diff = 0;
+    for (size_t i = 0; i < POLY1305_TAG_SIZE; ++i) diff |= expected[i] ^ tag[i];
+    if (diff != 0) return false;
+
+    chacha20_xor(key, nonce, 1, data, len);
+    return true;
+}
@@ -0,0 +1,36 @@
+#ifndef CIPHER_H
+#define CIPHER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ChaCha20-Poly1305 (RFC 8439). Ключевой поток ChaCha20 считается одним из ядер:
+// скалярным, SSE2 (4 блока за раз) или AVX2 (8 блоков); ядро выбирается при первом
+// вызове по CPUID. Результат от ядра не зависит.
+constexpr size_t CHACHA_KEY_SIZE   = 32;
+constexpr size_t CHACHA_NONCE_SIZE = 12;
+constexpr size_t POLY1305_TAG_SIZE = 16;
+
+enum class CipherPath { Scalar, SSE2, AVX2 };
+
+// Лучшее ядро, которое поддерживает процессор, и ядро, которое используется сейчас
+CipherPath  cipher_best_path();
+CipherPath  cipher_path();
+const char* cipher_path_name(CipherPath path);
+// Переключает ядро (для сравнения в hush_bench). false - процессор его не поддерживает
+bool cipher_set_path(CipherPath path);
+
+// XOR data с ключевым потоком, начиная с блока counter
+void chacha20_xor(const uint8_t* key, const uint8_t* nonce, uint32_t counter, uint8_t* data,
+                  size_t len);
+
+void poly1305(const uint8_t* key, const uint8_t* data, size_t len, uint8_t* tag);
+
+// Шифрует data на месте и вычисляет tag по ad и шифротексту
+void aead_seal(const uint8_t* key, const uint8_t* nonce, const uint8_t* ad, size_t adLen,
+               uint8_t* data, size_t len, uint8_t* tag);
+// Проверяет tag и только потом расшифровывает data на месте. false - данные или ключ не те
+bool aead_open(const uint8_t* key, const uint8_t* nonce, const uint8_t* ad, size_t adLen,
+               uint8_t* data, size_t len, const uint8_t* tag);
+
+#endif
@@ -0,0 +1,538 @@
+// hush-cli - пакетная работа с хранилищем без GUI.
+//
+// Хранилище открывается один раз, затем выполняются команды из файла-сценария
+// или stdin (по одной на строку), и в конце изменения сохраняются одной записью
+// в журнал автосохранения (journal.h).
+//
+//   hush-cli [--create] <vault.hush> [script]
+//
+// Мастер-пароль берётся из переменной окружения HUSH_MASTER_PASSWORD,
+// иначе запрашивается с терминала. migrate и calibrate запрашивают его ещё раз.
+//
+// Команды:
+//   list [filter]    записи, в названии или логине которых есть filter
+//   get <title> [title|login|password|favorite|hardware_key]
+//   add <title> <login> <password> [favorite]
+//   update <title> [title=...] [login=...] [password=...] [favorite=0|1]
+//   delete <title>
+//   save             записать файл целиком, свернув журнал
+//   migrate          перевести хранилище формата v1 в блочный формат v2
+//   calibrate [ms]   подобрать параметры Argon2id под время разблокировки (500 мс)
+//                    на этой машине и записать файл целиком
+//   generate [count] [length]
+//                    count новых паролей (1) длины length (16), по одному на строку:
+//                    в каждом есть строчная и заглавная буква, цифра и спецсимвол
+//   audit [report.csv]
+//                    слабые и повторяющиеся пароли, дубли названия и логина; с файлом -
+//                    отчёт в CSV, иначе по строке на запись с проблемами. Если задан
+//                    HUSH_BREACH_CORPUS (файл из breach_compile), пароли сверяются и с ним
+//   import <file> [csv|keepass|bitwarden]
+//                    записи из выгрузки CSV, KeePass XML или Bitwarden JSON (формат по
+//                    содержимому); записи с уже имеющимися названием и логином пропускаются
+//   export <file> [csv|json]
+//                    все записи с паролями открытым текстом: CSV или JSON Bitwarden (формат
+//                    по расширению файла); читаются командой import
+//
+// Аргументы разделяются пробелами, значения с пробелами берутся в кавычки.
+// При первой ошибке выполнение прекращается, и хранилище не сохраняется.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "database.h"
+#include "entry_view.h"
+#include "journal.h"
+#include "password_generator.h"
+#include "secure_arena.h"
+#include "vault_audit.h"
+#include "vault_export.h"
+#include "vault_import.h"
+
+using namespace std;
+
+namespace {
+
+struct CliState {
+    Vault  vault;
+    string path;
+    bool   dirty = false;
+};
+
+string read_master_password() {
+    if (const char* env = getenv("HUSH_MASTER_PASSWORD")) return env;
+    const char* password = getpass("Password: ");
+    return password ? password : "";
+}
+
+// Миграция и калибровка вырабатывают ключ с новой солью, а сеанс хранит только
+// выработанный ключ, поэтому пароль спрашивается заново и сверяется с ним
+bool confirm_password(const CliState& state, string& password, string& error) {
+    password = read_master_password();
+    if (!state.vault.key || !state.vault.key->verify(password)) {
+        error = "wrong password";
+        return false;
+    }
+    return true;
+}
+
+// Разбивает строку на аргументы с учётом "..." и '...'
+bool tokenize(const string& line, vector<string>& args, string& error) {
+    args.clear();
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && isspace(static_cast<unsigned char>(line[i]))) ++i;
+        if (i >= line.size() || line[i] == '#') break;
+
+        string arg;
+        while (i < line.size() && !isspace(static_cast<unsigned char>(line[i]))) {
+            char c = line[i];
+            if (c == '"' || c == '\'') {
+                char quote = c;
+                ++i;
+                while (i < line.size() && line[i] != quote) {
+                    if (quote == '"' && line[i] == '\\' && i + 1 < line.size()) ++i;
+                    arg += line[i++];
+                }
+                if (i >= line.size()) {
+                    error = "unterminated quote";
+                    return false;
+                }
+                ++i;
+            } else {
+                arg += c;
+                ++i;
+            }
+        }
+        args.push_back(arg);
+    }
+    return true;
+}
+
+bool parse_flag(const string& value, bool& out) {
+    if (value == "1" || value == "true" || value == "yes") {
+        out = true;
+        return true;
+    }
+    if (value == "0" || value == "false" || value == "no") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+bool find_entry(const CliState& state, const string& title, int& index, string& error) {
+    index = state.vault.find(title);
+    if (index < 0) {
+        error = "no entry '" + title + "'";
+        return false;
+    }
+    return true;
+}
+
+bool cmd_list(CliState& state, const vector<string>& args, string& error) {
+    string filter = args.size() > 1 ? args[1] : "";
+    for (int index : entry_view::filter_entries(state.vault.entries, state.vault.search, filter)) {
+        const auto& entry = state.vault.entries[index];
+        cout << entry.title << '\t' << entry.login << '\n';
+    }
+    return true;
+}
+
+bool cmd_get(CliState& state, const vector<string>& args, string& error) {
+    if (args.size() < 2 || args.size() > 3) {
+        error = "usage: get <title> [field]";
+        return false;
+    }
+
+    int index;
+    if (!find_entry(state, args[1], index, error)) return false;
+    const auto& entry = state.vault.entries[index];
+
+    string field = args.size() == 3 ? args[2] : "password";
+    if (field == "title") {
+        cout << entry.title << '\n';
+    } else if (field == "login") {
+        cout << entry.login << '\n';
+    } else if (field == "password") {
+        // Расшифровывается пароль только этой записи
+        string password;
+        if (!state.vault.reveal_password(index, password)) {
+            error = "cannot decrypt password of '" + args[1] + "'";
+            return false;
+        }
+        cout << password << '\n';
+        secure_wipe(password);
+    } else if (field == "favorite") {
+        cout << (entry.is_favorite ? 1 : 0) << '\n';
+    } else if (field == "hardware_key") {
+        cout << entry.hardware_key_fingerprint << '\n';
+    } else {
+        error = "unknown field '" + field + "'";
+        return false;
+    }
+    return true;
+}
+
+bool cmd_add(CliState& state, const vector<string>& args, string& error) {
+    if (args.size() < 4 || args.size() > 5 || (args.size() == 5 && args[4] != "favorite")) {
+        error = "usage: add <title> <login> <password> [favorite]";
+        return false;
+    }
+    if (args[1].empty()) {
+        error = "title cannot be empty";
+        return false;
+    }
+    if (state.vault.find(args[1]) >= 0) {
+        error = "entry '" + args[1] + "' already exists";
+        return false;
+    }
+
+    PasswordEntry entry;
+    entry.title       = args[1];
+    entry.login       = args[2];
+    entry.password    = args[3];
+    entry.is_favorite = args.size() == 5;
+    state.vault.add(entry);
+    state.dirty = true;
+    return true;
+}
+
+bool cmd_update(CliState& state, const vector<string>& args, string& error) {
+    if (args.size() < 3) {
+        error = "usage: update <title> field=value...";
+        return false;
+    }
+
+    int index;
+    if (!find_entry(state, args[1], index, error)) return false;
+    PasswordEntry entry;
+    if (!state.vault.reveal(index, entry)) {
+        error = "cannot decrypt password of '" + args[1] + "'";
+        return false;
+    }
+
+    for (size_t i = 2; i < args.size(); ++i) {
+        size_t eq = args[i].find('=');
+        if (eq == string::npos) {
+            error = "expected field=value, got '" + args[i] + "'";
+            return false;
+        }
+        string field = args[i].substr(0, eq);
+        string value = args[i].substr(eq + 1);
+
+        if (field == "title") {
+            if (value.empty()) {
+                error = "title cannot be empty";
+                return false;
+            }
+            entry.title = value;
+        } else if (field == "login") {
+            entry.login = value;
+        } else if (field == "password") {
+            entry.password = value;
+        } else if (field == "favorite") {
+            if (!parse_flag(value, entry.is_favorite)) {
+                error = "favorite must be 0 or 1";
+                return false;
+            }
+        } else {
+            error = "unknown field '" + field + "'";
+            return false;
+        }
+    }
+
+    state.vault.update(index, entry);
+    secure_wipe(entry.password);
+    state.dirty = true;
+    return true;
+}
+
+bool cmd_delete(CliState& state, const vector<string>& args, string& error) {
+    if (args.size() != 2) {
+        error = "usage: delete <title>";
+        return false;
+    }
+
+    int index;
+    if (!find_entry(state, args[1], index, error)) return false;
+    state.vault.remove(index);
+    state.dirty = true;
+    return true;
+}
+
+bool cmd_save(CliState& state, const vector<string>& args, string& error) {
+    if (!db_save_file(state.vault, state.path)) {
+        error = "failed to save '" + state.path + "'";
+        return false;
+    }
+    state.dirty = false;
+    return true;
+}
+
+bool cmd_migrate(CliState& state, const vector<string>& args, string& error) {
+    if (state.vault.layout.version == VAULT_FORMAT_V2) return true;
+
+    string password;
+    if (!confirm_password(state, password, error)) return false;
+    if (!db_migrate_file(state.vault, state.path, password)) {
+        error = "failed to migrate '" + state.path + "'";
+        return false;
+    }
+    state.dirty = false;
+    return true;
+}
+
+bool cmd_calibrate(CliState& state, const vector<string>& args, string& error) {
+    auto target = KDF_UNLOCK_TARGET;
+    if (args.size() > 1) {
+        char* end = nullptr;
+        long  ms  = strtol(args[1].c_str(), &end, 10);
+        if (*end != '\0' || ms <= 0) {
+            error = "bad time '" + args[1] + "'";
+            return false;
+        }
+        target = chrono::milliseconds(ms);
+    }
+
+    string password;
+    if (!confirm_password(state, password, error)) return false;
+
+    KdfParams params = kdf_calibrate(target);
+    cout << "t=" << params.t_cost << " m=" << params.m_cost << "KiB lanes=" << params.lanes
+         << '\n';
+    if (!db_set_key(state.vault, VaultKey::generate(password, params))) {
+        error = "cannot re-encrypt passwords of '" + state.path + "', key not changed";
+        return false;
+    }
+    return cmd_save(state, args, error);
+}
+
+bool parse_count(const string& value, size_t& out, string& error) {
+    char*         end = nullptr;
+    unsigned long n   = strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || n == 0 || value[0] == '-') {
+        error = "bad number '" + value + "'";
+        return false;
+    }
+    out = n;
+    return true;
+}
+
+bool cmd_generate(CliState& state, const vector<string>& args, string& error) {
+    PasswordPolicy policy;
+    policy.min_lower   = 1;
+    policy.min_upper   = 1;
+    policy.min_digits  = 1;
+    policy.min_special = 1;
+
+    size_t count = 1;
+    if (args.size() > 3) {
+        error = "usage: generate [count] [length]";
+        return false;
+    }
+    if (args.size() > 1 && !parse_count(args[1], count, error)) return false;
+    if (args.size() > 2 && !parse_count(args[2], policy.length, error)) return false;
+
+    static PasswordGenerator generator;
+    vector<string>           passwords;
+    if (!generator.generate_batch(policy, count, passwords)) {
+        error = "length must be at least 4";
+        return false;
+    }
+    for (auto& password : passwords) {
+        cout << password << '\n';
+        secure_wipe(password);
+    }
+    return true;
+}
+
+bool cmd_audit(CliState& state, const vector<string>& args, string& error) {
+    if (args.size() > 2) {
+        error = "usage: audit [report.csv]";
+        return false;
+    }
+
+    BreachCorpus breaches;
+    if (const char* corpus = getenv("HUSH_BREACH_CORPUS"); corpus && *corpus) {
+        if (!breaches.open(corpus)) {
+            error = "cannot open breach corpus '" + string(corpus) + "'";
+            return false;
+        }
+    }
+
+    AuditReport report = db_audit(state.vault.entries, state.vault.key.get(), &breaches);
+    cerr << report.entries << " entries, " << report.weak << " weak, " << report.breached
+         << " breached, " << report.reused << " reused, " << report.duplicates
+         << " duplicated, " << report.unreadable << " unreadable (" << report.elapsed_ms
+         << " ms)\n";
+
+    if (args.size() == 2) {
+        if (!db_export_audit(report, args[1])) {
+            error = "cannot write '" + args[1] + "'";
+            return false;
+        }
+        return true;
+    }
+    for (const auto& f : report.findings) {
+        cout << f.title << '\t' << f.login << '\t' << f.strength << '%';
+        if (f.unreadable) cout << "\tunreadable";
+        if (f.weak()) cout << "\tweak";
+        if (f.breached) cout << "\tbreached:" << f.breached;
+        if (f.reuse_group) cout << "\treused:" << f.reuse_group;
+        if (f.duplicate_group) cout << "\tduplicate:" << f.duplicate_group;
+        cout << '\n';
+    }
+    return true;
+}
+
+bool cmd_import(CliState& state, const vector<string>& args, string& error) {
+    ImportFormat format = ImportFormat::Auto;
+    if (args.size() < 2 || args.size() > 3 ||
+        (args.size() == 3 && !db_parse_import_format(args[2], format))) {
+        error = "usage: import <file> [csv|keepass|bitwarden]";
+        return false;
+    }
+
+    ifstream in(args[1], ios::binary);
+    if (!in) {
+        error = "cannot read '" + args[1] + "'";
+        return false;
+    }
+
+    // Сеанс однопоточный, блокировка нужна только интерфейсу db_import
+    mutex        vaultMutex;
+    ImportReport report = db_import(state.vault, vaultMutex, in, format);
+    if (report.imported) state.dirty = true;
+    cerr << db_import_format_name(report.format) << ": " << report.imported << " imported, "
+         << report.duplicates << " duplicates, " << report.untitled << " untitled ("
+         << report.elapsed_ms << " ms)\n";
+
+    if (!report.error.empty()) {
+        error = args[1] + ": " + report.error;
+        return false;
+    }
+    return true;
+}
+
+bool cmd_export(CliState& state, const vector<string>& args, string& error) {
+    ExportFormat format = args.size() > 1 ? db_export_format_for(args[1]) : ExportFormat::Csv;
+    if (args.size() < 2 || args.size() > 3 ||
+        (args.size() == 3 && !db_parse_export_format(args[2], format))) {
+        error = "usage: export <file> [csv|json]";
+        return false;
+    }
+
+    if (!db_export(state.vault.entries, state.vault.key.get(), args[1], format)) {
+        error = "cannot export to '" + args[1] + "'";
+        return false;
+    }
+    cerr << state.vault.entries.size() << " entries exported\n";
+    return true;
+}
+
+bool run_command(CliState& state, const vector<string>& args, string& error) {
+    struct Command {
+        const char* name;
+        bool (*fn)(CliState&, const vector<string>&, string&);
+    };
+    static const Command commands[] = {{"list", cmd_list},     {"get", cmd_get},
+                                       {"add", cmd_add},       {"update", cmd_update},
+                                       {"delete", cmd_delete}, {"save", cmd_save},
+                                       {"migrate", cmd_migrate}, {"calibrate", cmd_calibrate},
+                                       {"generate", cmd_generate}, {"audit", cmd_audit},
+                                       {"import", cmd_import}, {"export", cmd_export}};
+
+    for (const auto& command : commands) {
+        if (args[0] == command.name) return command.fn(state, args, error);
+    }
+    error = "unknown command '" + args[0] + "'";
+    return false;
+}
+
+int run_script(CliState& state, istream& in) {
+    string         line;
+    vector<string> args;
+    int            lineNo = 0;
+
+    while (getline(in, line)) {
+        ++lineNo;
+        string error;
+        if (!tokenize(line, args, error) || (!args.empty() && !run_command(state, args, error))) {
+            cerr << "hush-cli: line " << lineNo << ": " << error << '\n';
+            return 1;
+        }
+    }
+
+    cout.flush();
+    // Изменения пакета дописываются в журнал одной записью, журнал сворачивается по порогу
+    if (state.dirty && !db_autosave(state.vault)) {
+        cerr << "hush-cli: failed to save '" << state.path << "'\n";
+        return 1;
+    }
+    if (db_journal_needs_compaction(state.vault)) {
+        string error;
+        if (!cmd_save(state, {}, error)) {
+            cerr << "hush-cli: " << error << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool           create = false;
+    vector<string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--create") {
+            create = true;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.empty() || positional.size() > 2) {
+        cerr << "usage: hush-cli [--create] <vault.hush> [script]\n";
+        return 2;
+    }
+
+    CliState state;
+    state.path      = positional[0];
+    string password = read_master_password();
+    if (password.empty()) {
+        cerr << "hush-cli: password cannot be empty\n";
+        return 1;
+    }
+
+    if (create && !ifstream(state.path)) {
+        state.vault.path = state.path;
+        state.dirty      = true;
+        if (!db_set_key(state.vault, VaultKey::generate(password, KDF_DEFAULT))) {
+            cerr << "hush-cli: cannot derive a key for '" << state.path << "'\n";
+            return 1;
+        }
+    } else if (!db_load_file(state.vault, state.path, password)) {
+        cerr << "hush-cli: cannot open '" << state.path << "' (missing file or wrong password)\n";
+        return 1;
+    }
+
+    if (positional.size() == 2) {
+        ifstream script(positional[1]);
+        if (!script) {
+            cerr << "hush-cli: cannot read script '" << positional[1] << "'\n";
+            return 1;
+        }
+        return run_script(state, script);
+    }
+    return run_script(state, cin);
+}
@@ -0,0 +1,75 @@
+#include "clipboard.h"
+
+#include <FL/Fl.H>
+
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// 1 - системный буфер обмена, а не выделение X11, которое вставляется средней кнопкой
+constexpr int CLIPBOARD = 1;
+
+}  // namespace
+
+Clipboard::Clipboard(int timeout, Listener listener)
+    : timeout_(timeout), listener_(move(listener)) {
+    Fl::add_clipboard_notify(changed, this);
+}
+
+Clipboard::~Clipboard() {
+    Fl::remove_timeout(tick, this);
+    Fl::remove_clipboard_notify(changed);
+}
+
+void Clipboard::copy(string_view text) {
+    Fl::copy(text.data(), static_cast<int>(text.size()), CLIPBOARD);
+    copied_      = text.size();
+    secondsLeft_ = timeout_;
+
+    Fl::remove_timeout(tick, this);
+    Fl::add_timeout(1.0, tick, this);
+    if (listener_) listener_(secondsLeft_);
+}
+
+void Clipboard::clear() {
+    Fl::remove_timeout(tick, this);
+    if (active()) wipe();
+}
+
+void Clipboard::wipe() {
+    // FLTK держит свою копию текста и при той же длине пишет поверх неё: пароль
+    // сначала затирается пробелами, затем буфер опустошается
+    string blank(copied_, ' ');
+    Fl::copy(blank.data(), static_cast<int>(blank.size()), CLIPBOARD);
+    Fl::copy("", 0, CLIPBOARD);
+    finish();
+}
+
+void Clipboard::finish() {
+    copied_      = 0;
+    secondsLeft_ = 0;
+    if (listener_) listener_(0);
+}
+
+// FLTK сообщает только об изменениях буфера другими процессами. Пароля в системном
+// буфере уже нет, а Fl::copy снова сделал бы приложение владельцем и стёр чужой текст,
+// поэтому отсчёт просто останавливается
+void Clipboard::changed(int source, void* self) {
+    Clipboard* clipboard = static_cast<Clipboard*>(self);
+    if (source != CLIPBOARD || !clipboard->active()) return;
+
+    Fl::remove_timeout(tick, self);
+    clipboard->finish();
+}
+
+void Clipboard::tick(void* self) {
+    Clipboard* clipboard = static_cast<Clipboard*>(self);
+    if (--clipboard->secondsLeft_ > 0) {
+        Fl::repeat_timeout(1.0, tick, self);
+        if (clipboard->listener_) clipboard->listener_(clipboard->secondsLeft_);
+    } else {
+        clipboard->wipe();
+    }
+}
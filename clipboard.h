@@ -0,0 +1,43 @@
+#ifndef CLIPBOARD_H
+#define CLIPBOARD_H
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+// Пароли в буфере обмена: копирование через Fl::copy (на всех платформах, без запуска
+// процессов) и очистка через timeout секунд. Отсчёт идёт одним таймером FLTK в потоке
+// GUI: новое копирование перезапускает его, а не добавляет второй. Если буфер до того
+// занял другой процесс (Fl::add_clipboard_notify), пароля в нём уже нет, и очистка
+// отменяется, чтобы не стереть чужой текст. Вызывать только из потока GUI
+class Clipboard {
+   public:
+    // Вызывается при копировании и раз в секунду с оставшимся временем; 0 - буфер очищен
+    using Listener = std::function<void(int secondsLeft)>;
+
+    Clipboard(int timeout, Listener listener);
+    ~Clipboard();
+
+    Clipboard(const Clipboard&)            = delete;
+    Clipboard& operator=(const Clipboard&) = delete;
+
+    void copy(std::string_view text);
+    // Очищает буфер сейчас, если в нём ещё лежит скопированное отсюда
+    void clear();
+
+    bool active() const { return secondsLeft_ > 0; }
+    int  seconds_left() const { return secondsLeft_; }
+
+   private:
+    static void tick(void* self);
+    static void changed(int source, void* self);
+    void        wipe();
+    void        finish();
+
+    int      timeout_;
+    Listener listener_;
+    int      secondsLeft_ = 0;
+    size_t   copied_      = 0;  // Длина скопированного текста
+};
+
+#endif
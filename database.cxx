@@ -2,25 +2,204 @@
 
 #include <advobfuscator/string.h>
 
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <vector>
 
+#include "cipher.h"
+#include "file_sync.h"
+#include "journal.h"
+#include "lz_codec.h"
+#include "mapped_file.h"
+#include "vault_format.h"
+
 #ifdef __APPLE__
 #include <pwd.h>
 #include <unistd.h>
 #endif
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/random.h>
+#endif
+
 using namespace std;
 using namespace andrivet::advobfuscator;
 
-vector<PasswordEntry> g_passwordEntries;
-string                g_currentDatabasePath = "";
+static constexpr auto MAGIC_HEADER = "HUSH"_obf;
+
+Vault::Vault()                            = default;
+Vault::~Vault()                           = default;
+Vault::Vault(Vault&&) noexcept            = default;
+Vault& Vault::operator=(Vault&&) noexcept = default;
+
+string_view Vault::store(string_view s) {
+    return arena.store(s);
+}
+
+EntryRef Vault::store(const PasswordEntry& entry) {
+    EntryRef ref;
+    ref.title                    = store(entry.title);
+    ref.login                    = store(entry.login);
+    ref.password                 = store(entry.password);
+    ref.is_favorite              = entry.is_favorite;
+    ref.requires_hardware_key    = entry.requires_hardware_key;
+    ref.hardware_key_fingerprint = store(entry.hardware_key_fingerprint);
+    return ref;
+}
+
+size_t VaultLayout::locate(size_t index, size_t& first) const {
+    first = 0;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (index < first + blocks[b].count) return b;
+        first += blocks[b].count;
+    }
+    return blocks.size();
+}
+
+void VaultLayout::apply(const JournalRecord& record) {
+    if (version != VAULT_FORMAT_V2) return;
+
+    if (record.op == JournalOp::Add) {
+        if (blocks.empty() || blocks.back().count >= VAULT_BLOCK_ENTRIES) blocks.emplace_back();
+        blocks.back().count++;
+        blocks.back().dirty = true;
+        return;
+    }
+
+    size_t first;
+    size_t b = locate(record.index, first);
+    if (b < blocks.size()) {
+        blocks[b].dirty = true;
+        if (record.op == JournalOp::Remove && --blocks[b].count == 0) {
+            blocks.erase(blocks.begin() + b);
+            // Номер блока входит в его код подлинности: сдвинутые блоки запечатываются заново
+            for (size_t i = b; i < blocks.size(); ++i) blocks[i].dirty = true;
+        }
+    }
+}
+
+bool Vault::apply(const JournalRecord& record) {
+    if (record.op != JournalOp::Add) {
+        if (record.index >= entries.size()) return false;
+        // Номер в записи журнала должен совпасть с номером записи, которую она меняет
+        if (record.entry.id != 0 && record.entry.id != entries.id(record.index)) return false;
+    }
+    layout.apply(record);
+    ++revision;
+
+    if (record.op == JournalOp::Add) {
+        EntryRef entry = record.entry;
+        if (entry.id == 0 || ids.count(entry.id)) entry.id = next_id;
+        next_id = max(next_id, entry.id + 1);
+        ids.emplace(entry.id, entries.size());
+        search.insert(entry.title, entry.login);
+        entries.push_back(entry);
+    } else if (record.op == JournalOp::Update) {
+        EntryRef entry = record.entry;
+        entry.id       = entries.id(record.index);
+        search.update(record.index, entries.title(record.index), entries.login(record.index),
+                      entry.title, entry.login);
+        entries.set(record.index, entry);
+    } else {
+        search.erase(record.index, entries.title(record.index), entries.login(record.index));
+        ids.erase(entries.id(record.index));
+        entries.erase(record.index);
+        // Записи после удалённой сдвинулись на одну позицию
+        for (size_t i = record.index; i < entries.size(); ++i) ids[entries.id(i)] = i;
+    }
+    return true;
+}
+
+// Записи без номера (файлы старых форматов) нумеруются по порядку следом за
+// наибольшим известным номером, поэтому до первой записи файла номера те же при каждой загрузке
+void Vault::reindex() {
+    next_id = 1;
+    for (size_t i = 0; i < entries.size(); ++i) next_id = max(next_id, entries.id(i) + 1);
+
+    ids.clear();
+    ids.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        uint64_t id = entries.id(i);
+        if (id == 0 || !ids.emplace(id, i).second) {
+            entries.set_id(i, next_id);
+            ids.emplace(next_id++, i);
+        }
+    }
+
+    search.assign(entries);
+    ++revision;
+}
+
+void Vault::add(const PasswordEntry& entry) {
+    JournalRecord record{JournalOp::Add, entries.size(), store(entry)};
+    record.entry.id = next_id;
+    apply(record);
+    journal.pending.push_back(record);
+}
+
+bool Vault::update(size_t index, const PasswordEntry& entry) {
+    if (index >= entries.size()) return false;
+    JournalRecord record{JournalOp::Update, index, store(entry)};
+    record.entry.id = entries.id(index);
+    apply(record);
+    journal.pending.push_back(record);
+    return true;
+}
+
+bool Vault::remove(size_t index) {
+    if (index >= entries.size()) return false;
+    JournalRecord record{JournalOp::Remove, index, {}};
+    record.entry.id = entries.id(index);
+    apply(record);
+    journal.pending.push_back(record);
+    return true;
+}
 
-static constexpr auto   MAGIC_HEADER = "HUSH"_obf;
-static constexpr size_t SALT_SIZE    = 16;
-static constexpr size_t KEY_SIZE     = 32;
+void Vault::clear() {
+    entries.clear();
+    arena.clear();
+    image.reset();
+    path.clear();
+    layout  = VaultLayout();
+    journal = VaultJournal();
+    search.clear();
+    ids.clear();
+    next_id = 1;
+    key.reset();
+    ++revision;
+}
+
+int Vault::find(string_view title) const {
+    return entries.find_title(title);
+}
+
+int Vault::index_of(uint64_t id) const {
+    auto it = ids.find(id);
+    return it == ids.end() ? -1 : static_cast<int>(it->second);
+}
+
+bool Vault::reveal(size_t index, PasswordEntry& entry) const {
+    if (!reveal_password(index, entry.password)) return false;
+
+    entry.title                    = string(entries.title(index));
+    entry.login                    = string(entries.login(index));
+    entry.is_favorite              = entries.is_favorite(index);
+    entry.requires_hardware_key    = entries.requires_hardware_key(index);
+    entry.hardware_key_fingerprint = string(entries.hardware_key_fingerprint(index));
+    return true;
+}
+
+bool Vault::reveal_password(size_t index, string& password) const {
+    if (index >= entries.size()) return false;
+    if (entries.sealed_password(index).empty()) {
+        password = string(entries.password(index));
+        return true;
+    }
+    return key && db_reveal_password(entries[index], *key, password);
+}
 
 void derive_key_simple(const string& password, const uint8_t* salt, size_t saltLen, uint8_t* key,
                        size_t keyLen) {
@@ -43,6 +222,41 @@ void xor_cipher(uint8_t* data, size_t len, const uint8_t* key, size_t keyLen) {
     }
 }
 
+// Три прохода XOR, после каждого ключ перемешивается с солью.
+// XOR коммутативен, поэтому одна и та же функция шифрует и расшифровывает.
+// Остался только для файлов v1. Три прохода сводятся к одному с XOR трёх ключей,
+// по 8 байт за раз
+static void apply_keystream(uint8_t* data, size_t len, const uint8_t* fileKey,
+                            const uint8_t* salt) {
+    uint8_t key[KEY_SIZE];
+    uint8_t combined[KEY_SIZE] = {};
+    memcpy(key, fileKey, KEY_SIZE);
+
+    for (int pass = 0; pass < 3; ++pass) {
+        for (size_t i = 0; i < KEY_SIZE; ++i) combined[i] ^= key[i];
+        for (size_t i = 0; i < KEY_SIZE; ++i) {
+            key[i] = key[i] * 31 + salt[i % SALT_SIZE];
+        }
+    }
+
+    uint64_t words[KEY_SIZE / sizeof(uint64_t)];
+    memcpy(words, combined, KEY_SIZE);
+    size_t i = 0;
+    for (; i + KEY_SIZE <= len; i += KEY_SIZE) {
+        for (size_t w = 0; w < KEY_SIZE / sizeof(uint64_t); ++w) {
+            uint64_t v;
+            memcpy(&v, data + i + w * sizeof(v), sizeof(v));
+            v ^= words[w];
+            memcpy(data + i + w * sizeof(v), &v, sizeof(v));
+        }
+    }
+    xor_cipher(data + i, len - i, combined, KEY_SIZE);
+
+    secure_zero(key, sizeof(key));
+    secure_zero(combined, sizeof(combined));
+    secure_zero(words, sizeof(words));
+}
+
 string encrypt_data(const string& plaintext, const string& masterPassword) {
     if (plaintext.empty() || masterPassword.empty()) return "";
 
@@ -56,49 +270,30 @@ string encrypt_data(const string& plaintext, const string& masterPassword) {
     uint8_t key[KEY_SIZE];
     derive_key_simple(masterPassword, salt, SALT_SIZE, key, KEY_SIZE);
 
-    vector<uint8_t> encrypted(plaintext.begin(), plaintext.end());
-
-    for (int pass = 0; pass < 3; ++pass) {
-        xor_cipher(encrypted.data(), encrypted.size(), key, KEY_SIZE);
-        for (size_t i = 0; i < KEY_SIZE; ++i) {
-            key[i] = key[i] * 31 + salt[i % SALT_SIZE];
-        }
-    }
-
     string result;
     result.append((char*)salt, SALT_SIZE);
-    result.append((char*)encrypted.data(), encrypted.size());
+    result.append(plaintext);
+    apply_keystream((uint8_t*)result.data() + SALT_SIZE, plaintext.size(), key, salt);
 
     return result;
 }
 
-string decrypt_data(const string& encrypted, const string& masterPassword) {
-    if (encrypted.empty() || masterPassword.empty()) return "";
-    if (encrypted.size() < SALT_SIZE) return "";
-
-    uint8_t salt[SALT_SIZE];
-    memcpy(salt, encrypted.data(), SALT_SIZE);
+bool decrypt_in_place(uint8_t* data, size_t len, const string& masterPassword) {
+    if (masterPassword.empty() || len < SALT_SIZE) return false;
 
     uint8_t key[KEY_SIZE];
-    derive_key_simple(masterPassword, salt, SALT_SIZE, key, KEY_SIZE);
-
-    string          ciphertext = encrypted.substr(SALT_SIZE);
-    vector<uint8_t> decrypted(ciphertext.begin(), ciphertext.end());
-
-    uint8_t keys[3][KEY_SIZE];
-    memcpy(keys[0], key, KEY_SIZE);
-    for (int pass = 1; pass < 3; ++pass) {
-        memcpy(keys[pass], keys[pass - 1], KEY_SIZE);
-        for (size_t i = 0; i < KEY_SIZE; ++i) {
-            keys[pass][i] = keys[pass][i] * 31 + salt[i % SALT_SIZE];
-        }
-    }
+    derive_key_simple(masterPassword, data, SALT_SIZE, key, KEY_SIZE);
+    apply_keystream(data + SALT_SIZE, len - SALT_SIZE, key, data);
+    return true;
+}
 
-    for (int pass = 2; pass >= 0; --pass) {
-        xor_cipher(decrypted.data(), decrypted.size(), keys[pass], KEY_SIZE);
-    }
+string decrypt_data(const string& encrypted, const string& masterPassword) {
+    if (encrypted.empty() || masterPassword.empty()) return "";
+    if (encrypted.size() < SALT_SIZE) return "";
 
-    return string(decrypted.begin(), decrypted.end());
+    string buffer = encrypted;
+    decrypt_in_place(reinterpret_cast<uint8_t*>(buffer.data()), buffer.size(), masterPassword);
+    return buffer.substr(SALT_SIZE);
 }
 
 static string get_config_path() {
@@ -143,108 +338,791 @@ void clear_last_db_path() {
     remove(get_config_path().c_str());
 }
 
-bool db_load_file(const string& filepath, const string& masterPassword) {
-    ifstream is(filepath, ios::binary);
-    if (!is) return false;
-
-    char header[5] = {0};
-    is.read(header, 4);
+string get_breach_corpus_path() {
+    ifstream config(get_config_path() + "_breach");
+    string   path;
+    if (config) getline(config, path);
+    return path;
+}
 
-    auto expected = MAGIC_HEADER;
-    if (string(header) != string(expected)) {
-        return false;
+void save_breach_corpus_path(const string& path) {
+    string configPath = get_config_path() + "_breach";
+    if (path.empty()) {
+        remove(configPath.c_str());
+        return;
     }
 
-    string encryptedData((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
-    is.close();
+    ofstream config(configPath);
+    if (config) config << path;
+}
 
-    if (encryptedData.empty()) return false;
+void write_entry(string& out, const EntryRef& entry) {
+    auto write_string = [&](string_view s) {
+        size_t len = s.length();
+        out.append((char*)&len, sizeof(len));
+        out.append(s);
+    };
 
-    string decrypted = decrypt_data(encryptedData, masterPassword);
-    if (decrypted.empty()) return false;
+    write_string(entry.title);
+    write_string(entry.login);
+    write_string(entry.password);
+    out.append((char*)&entry.is_favorite, sizeof(bool));
+    out.append((char*)&entry.requires_hardware_key, sizeof(bool));
+    write_string(entry.hardware_key_fingerprint);
+}
 
-    g_passwordEntries.clear();
-    size_t pos = 0;
+size_t entry_size(const EntryRef& entry) {
+    return 4 * sizeof(size_t) + entry.title.size() + entry.login.size() + entry.password.size() +
+           2 * sizeof(bool) + entry.hardware_key_fingerprint.size();
+}
 
-    auto read_string = [&](string& s) -> bool {
-        if (pos + sizeof(size_t) > decrypted.size()) return false;
+// Строки не копируются: поля записи ссылаются прямо в data
+bool read_entry(const uint8_t* data, size_t size, size_t& pos, EntryRef& entry) {
+    auto read_string = [&](string_view& s) -> bool {
+        if (pos + sizeof(size_t) > size) return false;
         size_t len;
-        memcpy(&len, decrypted.data() + pos, sizeof(len));
+        memcpy(&len, data + pos, sizeof(len));
         pos += sizeof(len);
 
-        if (pos + len > decrypted.size()) return false;
-        s = decrypted.substr(pos, len);
+        if (len > size - pos) return false;
+        s = string_view(reinterpret_cast<const char*>(data + pos), len);
         pos += len;
         return true;
     };
 
+    if (!read_string(entry.title) || !read_string(entry.login) || !read_string(entry.password)) {
+        return false;
+    }
+    if (pos + sizeof(bool) <= size) {
+        memcpy(&entry.is_favorite, data + pos, sizeof(bool));
+        pos += sizeof(bool);
+    }
+    // Читаем поля физического ключа (для обратной совместимости проверяем размер)
+    if (pos + sizeof(bool) <= size) {
+        memcpy(&entry.requires_hardware_key, data + pos, sizeof(bool));
+        pos += sizeof(bool);
+    }
+    if (pos < size) {
+        read_string(entry.hardware_key_fingerprint);
+    }
+    return true;
+}
+
+// Разбор расшифрованного образа v1: количество записей и записи подряд
+static bool parse_entries(const uint8_t* data, size_t size, EntryTable& entries) {
+    size_t pos = 0;
     size_t count;
-    if (pos + sizeof(count) > decrypted.size()) return false;
-    memcpy(&count, decrypted.data() + pos, sizeof(count));
+    if (pos + sizeof(count) > size) return false;
+    memcpy(&count, data + pos, sizeof(count));
     pos += sizeof(count);
 
+    // При неверном пароле count - мусор, поэтому резервируем не больше, чем влезает в файл
+    entries.clear();
+    entries.reserve(min(count, size / (3 * sizeof(size_t))));
+
     for (size_t i = 0; i < count; ++i) {
-        PasswordEntry entry;
-        if (!read_string(entry.title) || !read_string(entry.login) ||
-            !read_string(entry.password)) {
+        EntryRef entry;
+        if (!read_entry(data, size, pos, entry)) return false;
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+// Формат v2:
+//   заголовок  "HSH2", версия, соль, проверка ключа, ёмкость блока,
+//              ёмкость индекса, число блоков, флаги (зарезервированы, 0)
+//   параметры  Argon2id {проходы, память, полосы, метка записи}
+//   индекс     index_capacity записей {смещение, длина, число записей}
+//   хвост      поколение, код подлинности слота, контрольная сумма FNV-1a всего слота
+//   блоки      длина заголовка блока, заголовок блока, пароли подряд
+//              заголовок блока: nonce (12 байт) + шифротекст {число записей, {постоянный
+//              номер, запись без пароля, смещение и длина пароля}...} + код подлинности
+//              пароль: nonce + шифротекст + код подлинности
+// Заголовки блоков, пароли и код слота запечатываются ChaCha20-Poly1305 (RFC 8439)
+// на ключе файла. Связанные данные заголовка блока - метка записи, номер блока в индексе
+// и число записей, пароля - номер записи, слота - все его байты до кода. Смещение пароля
+// отсчитывается от конца заголовка блока; при загрузке расшифровываются только заголовки,
+// а пароль - когда он понадобится. Открытый текст заголовка блока сжимается lz_compress
+// и хранится как {исходная длина, сжатые данные}; пароли не сжимаются: каждый запечатан
+// отдельно.
+// Заголовок с параметрами, индексом и хвостом - слот; слотов в файле два подряд.
+// Поколение g лежит в слоте g % 2, действует целый слот с большим поколением.
+// Дописывание блоков пишет следующее поколение в другой слот: оборванная запись портит
+// только его, а прежний слот по-прежнему указывает на целые блоки.
+// Индекс резервируется с запасом, чтобы новые блоки дописывались в конец файла,
+// а переписывался только заголовок.
+static constexpr auto   MAGIC_HEADER_V2 = "HSH2"_obf;
+static constexpr size_t V2_HEADER_SIZE  = 56;
+static constexpr size_t V2_KDF_SIZE     = 16;
+static constexpr size_t V2_INDEX_START  = V2_HEADER_SIZE + V2_KDF_SIZE;
+static constexpr size_t V2_INDEX_SLOT   = 16;
+static constexpr size_t V2_SLOT_MAC     = SEALED_OVERHEAD;
+static constexpr size_t V2_SLOT_TRAILER = 2 * sizeof(uint64_t) + V2_SLOT_MAC;
+static constexpr size_t CHECK_SIZE      = 16;
+
+void put_u32(string& out, uint32_t v) {
+    out.append((char*)&v, sizeof(v));
+}
+
+void put_u64(string& out, uint64_t v) {
+    out.append((char*)&v, sizeof(v));
+}
+
+uint32_t get_u32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t get_u64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Пароли запечатываются каждый со своим nonce, поэтому случайные байты берутся
+// одним системным вызовом (getentropy отдаёт до 256 байт за раз), а не по 4 байта
+void fill_random(uint8_t* out, size_t len) {
+#if defined(__linux__) || defined(__APPLE__)
+    for (size_t i = 0; i < len; i += 256) {
+        if (getentropy(out + i, min<size_t>(256, len - i)) != 0) abort();
+    }
+#else
+    random_device rd;
+    for (size_t i = 0; i < len; i += sizeof(uint32_t)) {
+        uint32_t r = rd();
+        memcpy(out + i, &r, min(sizeof(r), len - i));
+    }
+#endif
+}
+
+uint64_t fnv1a64(const void* data, size_t len) {
+    const uint8_t* p    = static_cast<const uint8_t*>(data);
+    uint64_t       hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool derive_file_key(const string& password, const uint8_t* salt, const KdfParams& kdf,
+                     uint8_t* key) {
+    // Ключ сеанса для файла v1: тот же derive_key_simple, что у encrypt_data
+    if (!kdf.argon2()) {
+        derive_key_simple(password, salt, SALT_SIZE, key, KEY_SIZE);
+        return true;
+    }
+
+    return argon2id(password.data(), password.size(), salt, SALT_SIZE, kdf, key, KEY_SIZE);
+}
+
+void seal_payload(string& sealed, const uint8_t* fileKey, const uint8_t* ad, size_t adLen) {
+    uint8_t* nonce = (uint8_t*)sealed.data();
+    fill_random(nonce, CHACHA_NONCE_SIZE);
+
+    uint8_t tag[POLY1305_TAG_SIZE];
+    aead_seal(fileKey, nonce, ad, adLen, nonce + CHACHA_NONCE_SIZE,
+              sealed.size() - CHACHA_NONCE_SIZE, tag);
+    sealed.append((const char*)tag, POLY1305_TAG_SIZE);
+}
+
+bool open_payload(uint8_t* data, size_t size, const uint8_t* fileKey, const uint8_t* ad,
+                  size_t adLen, uint8_t*& plain, size_t& plainSize) {
+    if (size < SEALED_OVERHEAD) return false;
+    plain     = data + CHACHA_NONCE_SIZE;
+    plainSize = size - SEALED_OVERHEAD;
+    return aead_open(fileKey, data, ad, adLen, plain, plainSize, plain + plainSize);
+}
+
+// Значение для проверки пароля до расшифровки блоков
+static void compute_key_check(const uint8_t* fileKey, uint8_t* check) {
+    blake2b(fileKey, KEY_SIZE, check, CHECK_SIZE);
+}
+
+// Связанные данные блока: метка полной записи, номер блока в индексе и число записей.
+// Блок не переставить в индексе и не подставить из другой записи файла
+static string block_ad(const VaultLayout& layout, uint32_t index, uint32_t count) {
+    string ad;
+    put_u32(ad, layout.save_tag);
+    put_u32(ad, index);
+    put_u32(ad, count);
+    return ad;
+}
+
+// Пароль запечатывается с номером записи, чтобы его нельзя было подставить другой записи
+static string seal_password(string_view password, uint64_t id, const uint8_t* fileKey) {
+    string sealed;
+    sealed.reserve(SEALED_OVERHEAD + password.size());
+    sealed.resize(CHACHA_NONCE_SIZE);
+    sealed.append(password);
+    seal_payload(sealed, fileKey, (const uint8_t*)&id, sizeof(id));
+    return sealed;
+}
+
+bool db_reveal_password(const EntryRef& entry, const VaultKey& key, string& password) {
+    if (entry.sealed_password.empty()) {
+        password = string(entry.password);
+        return true;
+    }
+
+    // Образ файла не трогаем: запечатанный пароль расшифровывается в копии
+    string   sealed(entry.sealed_password);
+    uint8_t* plain;
+    size_t   plainSize;
+    bool     opened = open_payload((uint8_t*)sealed.data(), sealed.size(), key.data(),
+                                   (const uint8_t*)&entry.id, sizeof(entry.id), plain, plainSize);
+    if (opened) password.assign((const char*)plain, plainSize);
+    secure_wipe(sealed);
+    return opened;
+}
+
+// Запечатанный пароль, не расшифрованный с загрузки, копируется как есть:
+// он зашифрован тем же ключом и с тем же номером записи
+static string encrypt_block(const EntryTable& entries, size_t first, uint32_t count,
+                            const uint8_t* fileKey, const string& ad) {
+    size_t rawSize = sizeof(uint32_t);
+    for (size_t i = first; i < first + count; ++i) {
+        rawSize += entry_size(entries[i]) - entries.password(i).size() + 2 * sizeof(uint64_t);
+    }
+
+    string raw;  // Заголовок до сжатия
+    string secrets;
+    raw.reserve(rawSize);
+    put_u32(raw, count);
+    for (size_t i = first; i < first + count; ++i) {
+        EntryRef entry = entries[i];
+        size_t   start = secrets.size();
+        if (!entry.sealed_password.empty()) {
+            secrets.append(entry.sealed_password);
+        } else if (!entry.password.empty()) {
+            secrets.append(seal_password(entry.password, entry.id, fileKey));
+        }
+
+        entry.password = {};
+        put_u64(raw, entry.id);
+        write_entry(raw, entry);
+        put_u32(raw, static_cast<uint32_t>(start));
+        put_u32(raw, static_cast<uint32_t>(secrets.size() - start));
+    }
+
+    string head;
+    head.reserve(SEALED_OVERHEAD + sizeof(uint32_t) + lz_bound(raw.size()));
+    head.resize(CHACHA_NONCE_SIZE);
+    put_u32(head, static_cast<uint32_t>(raw.size()));
+    lz_compress((const uint8_t*)raw.data(), raw.size(), head);
+    secure_wipe(raw);
+    seal_payload(head, fileKey, (const uint8_t*)ad.data(), ad.size());
+
+    string block;
+    put_u32(block, static_cast<uint32_t>(head.size()));
+    block.append(head);
+    block.append(secrets);
+    return block;
+}
+
+static size_t v2_slot_size(uint32_t indexCapacity) {
+    return V2_INDEX_START + indexCapacity * V2_INDEX_SLOT + V2_SLOT_TRAILER;
+}
+
+static size_t v2_data_start(uint32_t indexCapacity) {
+    return 2 * v2_slot_size(indexCapacity);
+}
+
+// Смещение слота, в который пишется заголовок поколения layout.generation
+static uint64_t v2_slot_offset(const VaultLayout& layout) {
+    return (layout.generation % 2) * v2_slot_size(layout.index_capacity);
+}
+
+static string v2_header(const VaultLayout& layout, const uint8_t* check, const uint8_t* fileKey) {
+    auto   magic = MAGIC_HEADER_V2;
+    string header((const char*)magic, 4);
+    put_u32(header, VAULT_FORMAT_V2);
+    header.append((const char*)layout.salt, SALT_SIZE);
+    header.append((const char*)check, CHECK_SIZE);
+    put_u32(header, VAULT_BLOCK_ENTRIES);
+    put_u32(header, layout.index_capacity);
+    put_u32(header, static_cast<uint32_t>(layout.blocks.size()));
+    put_u32(header, 0);  // Флаги
+
+    put_u32(header, layout.kdf.t_cost);
+    put_u32(header, layout.kdf.m_cost);
+    put_u32(header, layout.kdf.lanes);
+    put_u32(header, layout.save_tag);
+
+    for (uint32_t i = 0; i < layout.index_capacity; ++i) {
+        const VaultBlock* block = i < layout.blocks.size() ? &layout.blocks[i] : nullptr;
+        put_u64(header, block ? block->offset : 0);
+        put_u32(header, block ? block->length : 0);
+        put_u32(header, block ? block->count : 0);
+    }
+
+    put_u64(header, layout.generation);
+
+    // Код подлинности слота: пустой запечатанный текст, слот до кода - связанные данные
+    string mac(CHACHA_NONCE_SIZE, '\0');
+    seal_payload(mac, fileKey, (const uint8_t*)header.data(), header.size());
+    header.append(mac);
+
+    put_u64(header, fnv1a64(header.data(), header.size()));
+    return header;
+}
+
+static bool load_v2(Vault& vault, unique_ptr<MappedFile> image, const string& filepath,
+                    const string& masterPassword) {
+    uint8_t* data = image->data();
+    size_t   size = image->size();
+    if (size < V2_HEADER_SIZE || get_u32(data + 4) != VAULT_FORMAT_V2) return false;
+
+    VaultLayout layout;
+    memcpy(layout.salt, data + 8, SALT_SIZE);
+    layout.index_capacity = get_u32(data + 44);
+    if (get_u32(data + 52) != 0) return false;
+
+    size_t slotSize  = v2_slot_size(layout.index_capacity);
+    size_t dataStart = v2_data_start(layout.index_capacity);
+    if (layout.index_capacity > size || dataStart > size) return false;
+
+    // Из двух слотов берётся целый с большим поколением. Соль, параметры и ёмкость
+    // в слотах одинаковы, от поколения зависят только число блоков и индекс
+    const uint8_t* header = nullptr;
+    for (uint64_t s = 0; s < 2; ++s) {
+        const uint8_t* slot    = data + s * slotSize;
+        const uint8_t* trailer = slot + slotSize - V2_SLOT_TRAILER;
+        uint64_t       gen     = get_u64(trailer);
+        if (get_u64(slot + slotSize - sizeof(uint64_t)) !=
+                fnv1a64(slot, slotSize - sizeof(uint64_t)) ||
+            gen % 2 != s) {
+            continue;
+        }
+        if (!header || gen > layout.generation) {
+            header            = slot;
+            layout.generation = gen;
+        }
+    }
+    if (!header) return false;
+
+    uint32_t blockCount = get_u32(header + 48);
+    if (blockCount > layout.index_capacity) return false;
+
+    const uint8_t* kdf = header + V2_HEADER_SIZE;
+    layout.kdf         = {get_u32(kdf), get_u32(kdf + 4), get_u32(kdf + 8)};
+    layout.save_tag    = get_u32(kdf + 12);
+    if (!layout.kdf.argon2() || !kdf_params_valid(layout.kdf)) return false;
+
+    VaultKeyPtr key = VaultKey::derive(masterPassword, layout.salt, layout.kdf);
+    if (!key) return false;
+
+    const uint8_t* fileKey = key->data();
+    uint8_t        check[CHECK_SIZE];
+    compute_key_check(fileKey, check);
+    if (memcmp(check, header + 24, CHECK_SIZE) != 0) return false;
+
+    // Сумма слота ловит только оборванную запись; подмену индекса ловит код подлинности
+    size_t   macStart = slotSize - V2_SLOT_MAC - sizeof(uint64_t);
+    uint8_t  mac[V2_SLOT_MAC];
+    uint8_t* unused;
+    size_t   unusedSize;
+    memcpy(mac, header + macStart, V2_SLOT_MAC);
+    if (!open_payload(mac, V2_SLOT_MAC, fileKey, header, macStart, unused, unusedSize)) {
+        return false;
+    }
+
+    // По отпечатку заголовка журнал узнаёт файл, к которому он относится
+    layout.header_hash = fnv1a64(header, slotSize);
+
+    EntryTable entries;
+    layout.file_end = dataStart;
+    // Распакованный заголовок блока; записи копируют из него строки в свои столбцы
+    vector<uint8_t, SecureAllocator<uint8_t>> unpacked;
+
+    for (uint32_t b = 0; b < blockCount; ++b) {
+        const uint8_t* slot = header + V2_INDEX_START + b * V2_INDEX_SLOT;
+
+        VaultBlock block;
+        block.offset = get_u64(slot);
+        block.length = get_u32(slot + 8);
+        block.count  = get_u32(slot + 12);
+        block.dirty  = false;
+
+        if (block.offset < dataStart || block.offset > size ||
+            block.length > size - block.offset) {
             return false;
         }
-        if (pos + sizeof(bool) <= decrypted.size()) {
-            memcpy(&entry.is_favorite, decrypted.data() + pos, sizeof(bool));
-            pos += sizeof(bool);
+
+        // Расшифровывается только заголовок блока, пароли остаются запечатанными
+        if (block.length < sizeof(uint32_t)) return false;
+        uint8_t* head     = data + block.offset + sizeof(uint32_t);
+        size_t   headSize = get_u32(data + block.offset);
+        if (headSize > block.length - sizeof(uint32_t)) return false;
+        const char* secrets     = (const char*)head + headSize;
+        size_t      secretsSize = block.length - sizeof(uint32_t) - headSize;
+
+        string   ad = block_ad(layout, b, block.count);
+        uint8_t* plain;
+        size_t   plainSize;
+        if (!open_payload(head, headSize, fileKey, (const uint8_t*)ad.data(), ad.size(), plain,
+                          plainSize) ||
+            plainSize < sizeof(uint32_t)) {
+            return false;
         }
-        // Читаем поля физического ключа (для обратной совместимости проверяем размер)
-        if (pos + sizeof(bool) <= decrypted.size()) {
-            memcpy(&entry.requires_hardware_key, decrypted.data() + pos, sizeof(bool));
-            pos += sizeof(bool);
+
+        // Каждый сжатый байт даёт не больше 255 исходных, больше - повреждение
+        size_t rawSize    = get_u32(plain);
+        size_t packedSize = plainSize - sizeof(uint32_t);
+        if (rawSize < sizeof(uint32_t) || rawSize / 255 > packedSize) return false;
+        unpacked.resize(rawSize);
+        if (!lz_decompress(plain + sizeof(uint32_t), packedSize, unpacked.data(), rawSize)) {
+            return false;
         }
-        if (pos < decrypted.size()) {
-            read_string(entry.hardware_key_fingerprint);
+        plain     = unpacked.data();
+        plainSize = rawSize;
+        if (get_u32(plain) != block.count) return false;
+
+        size_t pos = sizeof(uint32_t);
+        for (uint32_t i = 0; i < block.count; ++i) {
+            EntryRef entry;
+            if (pos + sizeof(uint64_t) > plainSize) return false;
+            entry.id = get_u64(plain + pos);
+            pos += sizeof(uint64_t);
+            if (!read_entry(plain, plainSize, pos, entry)) return false;
+            if (pos + 2 * sizeof(uint32_t) > plainSize) return false;
+            uint32_t offset = get_u32(plain + pos);
+            uint32_t length = get_u32(plain + pos + sizeof(uint32_t));
+            pos += 2 * sizeof(uint32_t);
+            if (offset > secretsSize || length > secretsSize - offset) return false;
+            entry.sealed_password = string_view(secrets + offset, length);
+            entries.push_back(entry);
         }
-        g_passwordEntries.push_back(entry);
+
+        layout.file_end = max(layout.file_end, block.offset + block.length);
+        layout.blocks.push_back(block);
     }
 
-    g_currentDatabasePath = filepath;
-    save_last_db_path(filepath);
+    vault.clear();
+    vault.entries = std::move(entries);
+    vault.image   = std::move(image);
+    vault.layout  = std::move(layout);
+    vault.path    = filepath;
+    vault.key     = std::move(key);
+    vault.reindex();
+
+    // Изменения, сделанные после последней записи файла, лежат в журнале
+    db_journal_replay(vault);
     return true;
 }
 
-bool db_save_file(const string& filepath, const string& masterPassword) {
-    if (filepath.empty() || masterPassword.empty()) return false;
+static bool load_v1(Vault& vault, unique_ptr<MappedFile> image, const string& filepath,
+                    const string& masterPassword) {
+    uint8_t* encrypted = image->data() + 4;
+    size_t   size      = image->size() - 4;
+    if (size <= SALT_SIZE) return false;
 
-    string plaintext;
+    if (!decrypt_in_place(encrypted, size, masterPassword)) return false;
 
-    auto write_string = [&](const string& s) {
-        size_t len = s.length();
-        plaintext.append((char*)&len, sizeof(len));
-        plaintext.append(s);
+    EntryTable entries;
+    if (!parse_entries(encrypted + SALT_SIZE, size - SALT_SIZE, entries)) return false;
+
+    // v1 шифрует весь файл ключом из пароля и соли в начале файла. Соль выбирается
+    // один раз на сеанс, чтобы сохранения обходились без пароля
+    VaultKeyPtr key = VaultKey::generate(masterPassword, KdfParams());
+    if (!key) return false;
+
+    vault.clear();
+    vault.entries        = std::move(entries);
+    vault.image          = std::move(image);
+    vault.layout.version = VAULT_FORMAT_V1;
+    vault.path           = filepath;
+    vault.key            = std::move(key);
+    memcpy(vault.layout.salt, vault.key->salt(), SALT_SIZE);
+    // v1 не хранит номера записей: reindex присваивает их по порядку
+    vault.reindex();
+    return true;
+}
+
+bool db_load_file(Vault& vault, const string& filepath, const string& masterPassword) {
+    if (masterPassword.empty()) return false;
+
+    // Файл отображается в память и расшифровывается на месте: весь образ занимает
+    // ровно один буфер размером с файл, а записи ссылаются прямо в него
+    auto image = make_unique<MappedFile>();
+    if (!image->open(filepath) || image->size() < 4) return false;
+
+    auto v1 = MAGIC_HEADER;
+    if (memcmp(image->data(), (const char*)v1, 4) == 0) {
+        return load_v1(vault, std::move(image), filepath, masterPassword);
+    }
+
+    auto v2 = MAGIC_HEADER_V2;
+    if (memcmp(image->data(), (const char*)v2, 4) == 0) {
+        return load_v2(vault, std::move(image), filepath, masterPassword);
+    }
+    return false;
+}
+
+// Записи v1 шифруются и пишутся кусками по SAVE_CHUNK байт. Гамма повторяется
+// с периодом KEY_SIZE, и каждый кусок начинается с кратного ему смещения
+static constexpr size_t SAVE_CHUNK = 64 * 1024;
+static_assert(SAVE_CHUNK % KEY_SIZE == 0);
+
+static bool save_v1(const EntryTable& entries, const VaultSnapshot& snapshot,
+                    const string& filepath) {
+    const VaultKey& key = *snapshot.key;
+    if (key.kdf().argon2()) return false;  // v1 знает только derive_key_simple
+
+    // Как у encrypt_data: соль, затем шифротекст
+    auto                  magic = MAGIC_HEADER;
+    file_sync::AtomicFile file;
+    if (!file.open(filepath) || !file.write(string_view((const char*)magic, 4)) ||
+        !file.write(string_view((const char*)key.salt(), SALT_SIZE))) {
+        return false;
+    }
+
+    string chunk;
+    chunk.reserve(SAVE_CHUNK * 2);
+    auto flush = [&](size_t len) {
+        apply_keystream((uint8_t*)chunk.data(), len, key.data(), key.salt());
+        bool ok = file.write(string_view(chunk.data(), len));
+        chunk.erase(0, len);
+        return ok;
     };
 
-    size_t count = g_passwordEntries.size();
-    plaintext.append((char*)&count, sizeof(count));
+    size_t count   = entries.size();
+    bool   written = true;
+    chunk.append((char*)&count, sizeof(count));
+    // Запись длиннее SAVE_CHUNK даёт несколько кусков сразу: сбрасываются все полные
+    for (size_t i = 0; i < count && written; ++i) {
+        write_entry(chunk, entries[i]);
+        while (written && chunk.size() >= SAVE_CHUNK) written = flush(SAVE_CHUNK);
+    }
+    written = written && flush(chunk.size());
+    secure_wipe(chunk);
+    return written && file.commit();
+}
+
+// Полная запись v2: записи заново раскладываются по полным блокам. Соль и параметры
+// KDF - те, для которых выработан ключ сеанса; заголовок отличается от прошлого
+// случайной меткой записи. Блоки шифруются и пишутся по одному, в памяти только
+// текущий: место заголовка с индексом заполняется нулями и переписывается в конце,
+// когда длины блоков известны
+static bool save_v2_full(const EntryTable& entries, VaultSnapshot& snapshot,
+                         const string& filepath) {
+    const VaultKey& key = *snapshot.key;
+    if (!key.kdf().argon2()) return false;  // Ключ сеанса v1 - сначала db_migrate_file
+
+    VaultLayout layout;
+    memcpy(layout.salt, key.salt(), SALT_SIZE);
+    layout.kdf = key.kdf();
+    fill_random(reinterpret_cast<uint8_t*>(&layout.save_tag), sizeof(layout.save_tag));
+
+    for (size_t left = entries.size(); left > 0;) {
+        VaultBlock block;
+        block.count = static_cast<uint32_t>(min(left, VAULT_BLOCK_ENTRIES));
+        layout.blocks.push_back(block);
+        left -= block.count;
+    }
+
+    // Индекс с запасом вдвое, чтобы новые блоки не требовали полной перезаписи
+    layout.index_capacity = 16;
+    while (layout.index_capacity < layout.blocks.size() * 2) layout.index_capacity *= 2;
+
+    const uint8_t* fileKey = key.data();
+    uint8_t        check[CHECK_SIZE];
+    compute_key_check(fileKey, check);
+
+    file_sync::AtomicFile file;
+    uint64_t              offset = v2_data_start(layout.index_capacity);
+    if (!file.open(filepath) || !file.write(string(offset, '\0'))) return false;
+
+    size_t first = 0;
+    for (uint32_t b = 0; b < layout.blocks.size(); ++b) {
+        VaultBlock& block     = layout.blocks[b];
+        string      encrypted = encrypt_block(entries, first, block.count, fileKey,
+                                              block_ad(layout, b, block.count));
+        if (!file.write(encrypted)) return false;
+        first += block.count;
+
+        block.offset = offset;
+        block.length = static_cast<uint32_t>(encrypted.size());
+        block.dirty  = false;
+        offset += block.length;
+    }
+    layout.file_end = offset;
+
+    // Поколение 0 в первом слоте; второй остаётся нулями и не проходит проверку суммы
+    string header      = v2_header(layout, check, fileKey);
+    layout.header_hash = fnv1a64(header.data(), header.size());
+    if (!file.write_at(header, 0) || !file.commit()) return false;
+
+    snapshot.layout = std::move(layout);
+    return true;
+}
+
+// Дописывает изменённые блоки в конец файла и пишет заголовок с индексом следующим
+// поколением в другой слот. Старые копии блоков и действующий слот не трогаются, а новый
+// слот пишется только после того, как новые блоки сброшены на диск: при обрыве на любом
+// шаге загрузка берёт прежний слот, который указывает на целые блоки.
+// Старые копии становятся мусором, который убирает следующая полная запись.
+static bool save_v2_incremental(const EntryTable& entries, VaultSnapshot& snapshot,
+                                const string& filepath) {
+    VaultLayout layout = snapshot.layout;
+    if (!snapshot.key->matches(layout.salt, layout.kdf)) return false;
+
+    const uint8_t* fileKey = snapshot.key->data();
+    uint8_t        check[CHECK_SIZE];
+    compute_key_check(fileKey, check);
+
+    file_sync::SyncedFile file;
+    if (!file.open(filepath)) return false;
+
+    // Файл переписан другим сеансом с другим паролем - нужна полная перезапись
+    uint8_t stored[CHECK_SIZE];
+    if (!file.read_at(stored, CHECK_SIZE, v2_slot_offset(layout) + 24) ||
+        memcmp(stored, check, CHECK_SIZE) != 0) {
+        return false;
+    }
+
+    uint64_t offset = layout.file_end;
+    size_t   first  = 0;
+    for (uint32_t b = 0; b < layout.blocks.size(); ++b) {
+        VaultBlock& block = layout.blocks[b];
+        if (block.dirty) {
+            string encrypted = encrypt_block(entries, first, block.count, fileKey,
+                                             block_ad(layout, b, block.count));
+            if (!file.write_at(encrypted, offset)) return false;
+
+            block.offset = offset;
+            block.length = static_cast<uint32_t>(encrypted.size());
+            block.dirty  = false;
+            offset += block.length;
+        }
+        first += block.count;
+    }
+    layout.file_end = offset;
+    if (!file.sync()) return false;
+
+    ++layout.generation;
+    string header      = v2_header(layout, check, fileKey);
+    layout.header_hash = fnv1a64(header.data(), header.size());
+    if (!file.write_at(header, v2_slot_offset(layout)) || !file.sync()) return false;
+
+    snapshot.layout = std::move(layout);
+    return true;
+}
+
+// Дописывать блоки можно, если файл тот же, индекс вмещает все блоки,
+// а мусор от старых копий не превышает живые данные
+static bool can_save_incrementally(const VaultSnapshot& snapshot, const string& filepath) {
+    const VaultLayout& layout = snapshot.layout;
+    if (filepath != snapshot.path || layout.index_capacity == 0) return false;
+    if (layout.blocks.size() > layout.index_capacity) return false;
+
+    uint64_t live = 0;
+    for (const auto& block : layout.blocks) live += block.length;
+    uint64_t used = layout.file_end - v2_data_start(layout.index_capacity);
+    return used <= 2 * live + (1 << 20);
+}
+
+VaultSnapshot db_snapshot(Vault& vault) {
+    VaultSnapshot snapshot{vault.entries, vault.layout, vault.path, vault.key};
+    // Всё накопленное войдёт в файл; pending теперь копит только новые изменения
+    vault.journal.pending.clear();
+    return snapshot;
+}
+
+// Записи пишутся из entries: у db_write_snapshot это копия снимка, у db_save_file -
+// сами записи хранилища, без копии
+static bool write_entries(const EntryTable& entries, VaultSnapshot& snapshot,
+                          const string& filepath) {
+    if (filepath.empty() || !snapshot.key) return false;
+
+    bool saved;
+    if (snapshot.layout.version == VAULT_FORMAT_V1) {
+        saved = save_v1(entries, snapshot, filepath);
+    } else {
+        saved = (can_save_incrementally(snapshot, filepath) &&
+                 save_v2_incremental(entries, snapshot, filepath)) ||
+                save_v2_full(entries, snapshot, filepath);
+    }
+    if (!saved) return false;
 
-    for (const auto& entry : g_passwordEntries) {
-        write_string(entry.title);
-        write_string(entry.login);
-        write_string(entry.password);
-        plaintext.append((char*)&entry.is_favorite, sizeof(bool));
-        plaintext.append((char*)&entry.requires_hardware_key, sizeof(bool));
-        write_string(entry.hardware_key_fingerprint);
+    // Файл теперь содержит все изменения снимка, журнал рядом с ним больше не нужен
+    db_journal_remove(filepath);
+    snapshot.path = filepath;
+    return true;
+}
+
+bool db_write_snapshot(VaultSnapshot& snapshot, const string& filepath) {
+    return write_entries(snapshot.entries, snapshot, filepath);
+}
+
+void db_commit_snapshot(Vault& vault, const VaultSnapshot& snapshot, bool written) {
+    if (!written) {
+        // Изменения снимка ушли из pending, но не дошли до диска
+        vault.journal.stale = true;
+        return;
     }
 
-    string encrypted = encrypt_data(plaintext, masterPassword);
-    if (encrypted.empty()) return false;
+    // Раскладка записанного файла плюс изменения, сделанные во время записи
+    VaultLayout layout = snapshot.layout;
+    for (const auto& record : vault.journal.pending) layout.apply(record);
+    vault.layout = std::move(layout);
+    vault.key    = snapshot.key;  // Файл записан ключом снимка (у миграции он новый)
+
+    vault.journal.bytes = 0;
+    vault.journal.stale = false;
+    if (vault.path != snapshot.path) vault.path = snapshot.path;
+}
 
-    ofstream os(filepath, ios::binary);
-    if (!os) return false;
+bool db_save_file(Vault& vault, const string& filepath) {
+    if (filepath.empty() || !vault.key) return false;
 
-    auto   header = MAGIC_HEADER;
-    string headerStr(header);
-    os.write(headerStr.c_str(), 4);
-    os.write(encrypted.data(), encrypted.size());
-    os.close();
+    // Запись синхронная, поэтому столбцы записей не копируются в снимок
+    VaultSnapshot snapshot{EntryTable(), vault.layout, vault.path, vault.key};
+    vault.journal.pending.clear();
+    bool saved = write_entries(vault.entries, snapshot, filepath);
+    db_commit_snapshot(vault, snapshot, saved);
+    return saved;
+}
 
-    g_currentDatabasePath = filepath;
-    save_last_db_path(filepath);
+bool db_set_key(Vault& vault, VaultKeyPtr key) {
+    if (!key) return false;
+
+    // Новым ключом запечатанные пароли не открыть, поэтому они расшифровываются заранее.
+    // Сначала проверяется, что открываются все: иначе после смены ключа пароль, который не
+    // открылся, пропал бы без следа. Только потом записи меняются
+    string password;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < vault.entries.size(); ++i) {
+            if (vault.entries.sealed_password(i).empty()) continue;
+
+            bool revealed =
+                vault.key && db_reveal_password(vault.entries[i], *vault.key, password);
+            if (revealed && pass == 1) vault.entries.unseal(i, password);
+            secure_wipe(password);
+            if (!revealed) return false;
+        }
+    }
+
+    // Параметры KDF хранятся только в заголовке v2. Блоки и журнал зашифрованы прежним
+    // ключом, поэтому следующая запись - полная
+    memcpy(vault.layout.salt, key->salt(), SALT_SIZE);
+    vault.layout.version        = VAULT_FORMAT_V2;
+    vault.layout.kdf            = key->kdf();
+    vault.layout.index_capacity = 0;
+    vault.journal.stale         = true;
+    vault.key                   = std::move(key);
     return true;
 }
+
+bool db_migrate_file(Vault& vault, const string& filepath, const string& masterPassword) {
+    if (vault.layout.version == VAULT_FORMAT_V2) return true;
+
+    VaultSnapshot snapshot = db_snapshot(vault);
+    snapshot.layout        = VaultLayout();
+    snapshot.key           = VaultKey::generate(masterPassword, KDF_DEFAULT);
+    if (!snapshot.key) return false;
+    bool migrated = db_write_snapshot(snapshot, filepath);
+    db_commit_snapshot(vault, snapshot, migrated);
+    return migrated;
+}
@@ -1,9 +1,22 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "entry_table.h"
+#include "kdf.h"
+#include "search_index.h"
+#include "secure_arena.h"
+#include "vault_key.h"
+
+class MappedFile;
+
 struct PasswordEntry {
     std::string title;
     std::string login;
@@ -13,14 +26,162 @@ struct PasswordEntry {
     std::string hardware_key_fingerprint = "";  // Fingerprint физического устройства
 };
 
-extern std::vector<PasswordEntry> g_passwordEntries;
-extern std::string                g_currentDatabasePath;
+// Изменение одной записи. Из них состоит журнал автосохранения (journal.h)
+enum class JournalOp : uint8_t { Add = 1, Update = 2, Remove = 3 };
+
+struct JournalRecord {
+    JournalOp op    = JournalOp::Add;
+    uint64_t  index = 0;  // Для Add не используется: запись добавляется в конец
+    EntryRef  entry;      // Для Add и Update; для Remove - только entry.id
+};
+
+// Формат v2 хранит записи блоками фиксированной ёмкости, каждый блок шифруется
+// отдельно, поэтому при сохранении переписываются только изменённые блоки.
+// Пароли внутри блока запечатаны каждый отдельно от названий и логинов
+constexpr int    VAULT_FORMAT_V1     = 1;
+constexpr int    VAULT_FORMAT_V2     = 2;
+constexpr size_t VAULT_BLOCK_ENTRIES = 256;
+
+// Блок записей: непрерывный участок Vault::entries
+struct VaultBlock {
+    uint32_t count  = 0;
+    bool     dirty  = true;
+    uint64_t offset = 0;  // Положение зашифрованного блока в файле
+    uint32_t length = 0;
+};
+
+// Раскладка файла, из которого загружено хранилище
+struct VaultLayout {
+    int                     version = VAULT_FORMAT_V2;
+    std::vector<VaultBlock> blocks;  // Только для v2
+    uint8_t                 salt[16]       = {};
+    uint32_t                index_capacity = 0;  // 0 - файл ещё не записан в v2
+    uint64_t                file_end       = 0;  // Конец данных в файле
+    uint64_t                header_hash    = 0;  // Отпечаток заголовка с индексом
+    uint64_t                generation     = 0;  // Поколение действующего слота заголовка
+    KdfParams               kdf;                 // Argon2id ключа файла; пусто - ещё не задан
+    uint32_t                save_tag = 0;        // Случайная метка полной записи файла
+
+    // Блок, содержащий запись index; first - индекс первой записи блока
+    size_t locate(size_t index, size_t& first) const;
+
+    // Отмечает блок, который затрагивает изменение (вызывается до изменения entries)
+    void apply(const JournalRecord& record);
+};
+
+// Журнал изменений рядом с файлом хранилища
+struct VaultJournal {
+    uint64_t                              bytes = 0;  // Длина на диске, 0 - журнала нет
+    std::chrono::steady_clock::time_point started;    // Первая запись в журнал
+    std::vector<JournalRecord>            pending;    // Изменения, ещё не записанные на диск
+    bool                                  stale = false;  // Журнал неполон: нужна запись файла
+};
+
+// Открытое хранилище: записи и путь к файлу, из которого они загружены.
+// Все изменения записей идут через методы, чтобы хранилище знало, что поменялось.
+struct Vault {
+    EntryTable  entries;
+    std::string path;
+    uint64_t    revision = 0;  // Растёт при каждом изменении entries
+
+    Vault();
+    ~Vault();
+    Vault(Vault&&) noexcept;
+    Vault& operator=(Vault&&) noexcept;
+
+    // Ссылки в entries указывают на память этого объекта, копировать нельзя
+    Vault(const Vault&)            = delete;
+    Vault& operator=(const Vault&) = delete;
+
+    void add(const PasswordEntry& entry);
+    bool update(size_t index, const PasswordEntry& entry);
+    bool remove(size_t index);
+    void clear();
+
+    // Применяет изменение без записи в pending (воспроизведение журнала)
+    bool apply(const JournalRecord& record);
 
-bool db_load_file(const std::string& filepath, const std::string& masterPassword);
-bool db_save_file(const std::string& filepath, const std::string& masterPassword);
+    // Строит поисковый индекс заново по entries (после загрузки файла)
+    void reindex();
+
+    // Индекс первой записи с таким названием, -1 если не найдена
+    int find(std::string_view title) const;
+
+    // Индекс записи с постоянным номером id, -1 если такой нет
+    int index_of(uint64_t id) const;
+
+    // Запись целиком или только её пароль; запечатанный пароль расшифровывается ключом
+    // хранилища. false - нет такой записи или запечатанный пароль повреждён
+    bool reveal(size_t index, PasswordEntry& entry) const;
+    bool reveal_password(size_t index, std::string& password) const;
+
+    // Копирует строку в пул хранилища и возвращает ссылку на копию
+    std::string_view store(std::string_view s);
+    EntryRef         store(const PasswordEntry& entry);
+
+    std::unique_ptr<MappedFile> image;    // Расшифрованный на месте файл
+    SecureArena                 arena;    // Строки изменений для журнала и сам журнал
+    VaultLayout                 layout;
+    VaultJournal                journal;
+    SearchIndex                 search;  // Обновляется в apply, строится заново при загрузке
+    VaultKeyPtr                 key;     // Ключ для соли и KDF из layout, задаётся при загрузке
+
+    std::unordered_map<uint64_t, size_t> ids;          // Постоянный номер -> индекс в entries
+    uint64_t                             next_id = 1;  // Номер для следующей новой записи
+};
+
+// Криптография хранилища (открыта для hush_bench)
+void        derive_key_simple(const std::string& password, const uint8_t* salt, size_t saltLen,
+                              uint8_t* key, size_t keyLen);
+std::string encrypt_data(const std::string& plaintext, const std::string& masterPassword);
+std::string decrypt_data(const std::string& encrypted, const std::string& masterPassword);
+
+// Расшифровка на месте: data начинается с соли, шифротекст заменяется открытым текстом
+bool decrypt_in_place(uint8_t* data, size_t len, const std::string& masterPassword);
+
+// Пароль записи: запечатанный расшифровывается ключом key, иначе берётся как есть.
+// Не трогает Vault, поэтому годится и для записей снимка. false - пароль повреждён
+bool db_reveal_password(const EntryRef& entry, const VaultKey& key, std::string& password);
+
+// Путь к последней базе запоминает GUI, сами load/save конфиг не трогают.
+// Пароль нужен только загрузке: она вырабатывает vault.key, запись берёт его
+bool db_load_file(Vault& vault, const std::string& filepath, const std::string& masterPassword);
+bool db_save_file(Vault& vault, const std::string& filepath);
+
+// Снимок хранилища для записи на диск без удержания блокировки. Столбцы записей
+// копируются; запечатанные пароли ссылаются в образ файла, и ссылки действительны,
+// пока хранилище не закрыто.
+struct VaultSnapshot {
+    EntryTable  entries;
+    VaultLayout layout;
+    std::string path;
+    VaultKeyPtr key;
+};
+
+// db_save_file по шагам для записи в фоне: снимок и фиксация под блокировкой хранилища,
+// запись без неё. Изменения, сделанные во время записи, остаются в vault.journal.pending.
+// Сам db_save_file синхронный и пишет записи хранилища без копии в снимке
+VaultSnapshot db_snapshot(Vault& vault);
+bool          db_write_snapshot(VaultSnapshot& snapshot, const std::string& filepath);
+void          db_commit_snapshot(Vault& vault, const VaultSnapshot& snapshot, bool written);
+
+// Переписывает хранилище формата v1 в формате v2. v1 не хранит параметры Argon2id,
+// поэтому ключ вырабатывается заново и нужен пароль
+bool db_migrate_file(Vault& vault, const std::string& filepath, const std::string& masterPassword);
+
+// Задаёт ключ с новой солью (VaultKey::generate): новое хранилище, смена пароля или
+// параметров Argon2id. Ключ меняется, поэтому следующая запись будет полной, в формате v2,
+// а журнал до неё не ведётся. Запечатанные прежним ключом пароли расшифровываются заранее.
+// false - ключ не выработан или какой-то пароль не открылся; хранилище тогда не меняется
+bool db_set_key(Vault& vault, VaultKeyPtr key);
 
 std::string get_last_db_path();
 void        save_last_db_path(const std::string& path);
 void        clear_last_db_path();
 
+// Файл утечек (BreachCorpus) хранится отдельно от хранилища и выбирается один раз;
+// пустой путь - проверка отключена
+std::string get_breach_corpus_path();
+void        save_breach_corpus_path(const std::string& path);
+
 #endif
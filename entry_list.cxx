@@ -0,0 +1,172 @@
+#include "entry_list.h"
+
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+
+#include <algorithm>
+
+using namespace std;
+
+static constexpr int WHEEL_ROWS = 3;  // Строк за один щелчок колеса
+
+EntryList::EntryList(int x, int y, int w, int h, LabelFn label)
+    : Fl_Group(x, y, w, h), labelFn_(std::move(label)) {
+    box(FL_DOWN_BOX);
+    color(FL_BACKGROUND2_COLOR);
+    selection_color(FL_SELECTION_COLOR);
+
+    int sw     = Fl::scrollbar_size();
+    scrollbar_ = new Fl_Scrollbar(x + w - sw - Fl::box_dx(box()), y + Fl::box_dy(box()), sw,
+                                  h - Fl::box_dh(box()));
+    scrollbar_->type(FL_VERTICAL);
+    scrollbar_->callback(scrollbar_cb, this);
+    end();
+
+    update_scrollbar();
+}
+
+void EntryList::rows(vector<uint64_t> ids, uint64_t revision) {
+    if (revision != labelsRevision_) {
+        labels_.clear();
+        labelsRevision_ = revision;
+    }
+
+    ids_      = std::move(ids);
+    selected_ = -1;
+    top_      = 0;
+    update_scrollbar();
+    redraw();
+}
+
+void EntryList::invalidate_labels() {
+    labels_.clear();
+    redraw();
+}
+
+void EntryList::invalidate_labels(const function<bool(uint64_t id)>& affected) {
+    if (erase_if(labels_, [&](const auto& label) { return affected(label.first); }) > 0) redraw();
+}
+
+void EntryList::value(int row) {
+    selected_ = (row >= 1 && row <= size()) ? row - 1 : -1;
+    if (selected_ >= 0) show_row(selected_);
+    redraw();
+}
+
+uint64_t EntryList::entry(int row) const {
+    if (row < 1 || row > size()) return 0;
+    return ids_[row - 1];
+}
+
+const string& EntryList::label(uint64_t id) {
+    auto it = labels_.find(id);
+    if (it == labels_.end()) it = labels_.emplace(id, labelFn_(id)).first;
+    return it->second;
+}
+
+int EntryList::row_height() const {
+    fl_font(FL_HELVETICA, FL_NORMAL_SIZE);
+    return fl_height() + 2;
+}
+
+int EntryList::visible_rows() const {
+    return max(1, (h() - Fl::box_dh(box())) / row_height());
+}
+
+void EntryList::scroll_to(int top) {
+    top  = min(top, size() - visible_rows());
+    top_ = max(top, 0);
+    update_scrollbar();
+    redraw();
+}
+
+void EntryList::show_row(int row) {
+    if (row < top_) {
+        scroll_to(row);
+    } else if (row >= top_ + visible_rows()) {
+        scroll_to(row - visible_rows() + 1);
+    }
+}
+
+void EntryList::update_scrollbar() {
+    scrollbar_->value(top_, visible_rows(), 0, size());
+}
+
+void EntryList::scrollbar_cb(Fl_Widget* widget, void* data) {
+    auto* list = static_cast<EntryList*>(data);
+    list->scroll_to(static_cast<Fl_Scrollbar*>(widget)->value());
+}
+
+void EntryList::draw() {
+    draw_box();
+
+    int X  = x() + Fl::box_dx(box());
+    int Y  = y() + Fl::box_dy(box());
+    int W  = w() - Fl::box_dw(box()) - scrollbar_->w();
+    int H  = h() - Fl::box_dh(box());
+    int rh = row_height();
+
+    fl_push_clip(X, Y, W, H);
+    fl_rectf(X, Y, W, H, color());
+
+    // Рисуются только видимые строки, подписи остальных даже не строятся
+    for (int row = top_, rowY = Y; row < size() && rowY < Y + H; ++row, rowY += rh) {
+        bool selected = row == selected_;
+        if (selected) fl_rectf(X, rowY, W, rh, selection_color());
+
+        fl_color(selected ? FL_WHITE : FL_FOREGROUND_COLOR);
+        fl_draw(label(ids_[row]).c_str(), X + 3, rowY, W - 6, rh, FL_ALIGN_LEFT | FL_ALIGN_CLIP);
+    }
+    fl_pop_clip();
+
+    draw_child(*scrollbar_);
+}
+
+int EntryList::handle(int event) {
+    switch (event) {
+        case FL_PUSH:
+        case FL_DRAG: {
+            if (event == FL_PUSH && Fl::event_x() >= scrollbar_->x()) break;
+            take_focus();
+
+            int row = top_ + (Fl::event_y() - y() - Fl::box_dy(box())) / row_height();
+            if (row >= 0 && row < size()) {
+                selected_ = row;
+                show_row(row);
+                redraw();
+            }
+            return 1;
+        }
+        case FL_MOUSEWHEEL:
+            scroll_to(top_ + Fl::event_dy() * WHEEL_ROWS);
+            return 1;
+        case FL_FOCUS:
+        case FL_UNFOCUS:
+            return 1;
+        case FL_KEYBOARD: {
+            int page = visible_rows();
+            int row  = selected_;
+            switch (Fl::event_key()) {
+                case FL_Up: row = max(row - 1, 0); break;
+                case FL_Down: row = row + 1; break;
+                case FL_Page_Up: row = max(row - page, 0); break;
+                case FL_Page_Down: row = row + page; break;
+                case FL_Home: row = 0; break;
+                case FL_End: row = size() - 1; break;
+                default: return Fl_Group::handle(event);
+            }
+            if (size() > 0) value(min(row, size() - 1) + 1);
+            return 1;
+        }
+    }
+    return Fl_Group::handle(event);
+}
+
+void EntryList::resize(int x, int y, int w, int h) {
+    Fl_Widget::resize(x, y, w, h);
+
+    int sw = Fl::scrollbar_size();
+    scrollbar_->resize(x + w - sw - Fl::box_dx(box()), y + Fl::box_dy(box()), sw,
+                       h - Fl::box_dh(box()));
+    scroll_to(top_);
+}
@@ -0,0 +1,67 @@
+#ifndef ENTRY_LIST_H
+#define ENTRY_LIST_H
+
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Scrollbar.H>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Виртуальный список записей: хранит только постоянные номера записей в порядке
+// отображения и рисует видимые строки. Подписи строк строятся по запросу и кэшируются
+// по номеру записи, пока хранилище не изменится, поэтому прокрутка и фильтрация
+// стоят пропорционально числу видимых строк, а не размеру хранилища.
+class EntryList : public Fl_Group {
+   public:
+    // Подпись строки для записи с постоянным номером id
+    using LabelFn = std::function<std::string(uint64_t id)>;
+
+    EntryList(int x, int y, int w, int h, LabelFn label);
+
+    // Новые строки списка. revision - версия хранилища, к которой они относятся:
+    // при её смене кэш подписей сбрасывается
+    void rows(std::vector<uint64_t> ids, uint64_t revision);
+
+    // Сбрасывает кэш подписей
+    void invalidate_labels();
+    // Сбрасывает подписи только тех записей, для которых affected(id) истинно
+    // (например, подключили физический ключ)
+    void invalidate_labels(const std::function<bool(uint64_t id)>& affected);
+
+    // Выделенная строка с 1, 0 - ничего не выделено (как у Fl_Browser)
+    int  value() const { return selected_ + 1; }
+    void value(int row);
+
+    // Номер записи в строке row (с 1), 0 если такой строки нет
+    uint64_t entry(int row) const;
+
+    int size() const { return static_cast<int>(ids_.size()); }
+
+    void draw() override;
+    int  handle(int event) override;
+    void resize(int x, int y, int w, int h) override;
+
+   private:
+    static void scrollbar_cb(Fl_Widget* widget, void* data);
+
+    int                row_height() const;
+    int                visible_rows() const;
+    void               scroll_to(int top);
+    void               show_row(int row);
+    void               update_scrollbar();
+    const std::string& label(uint64_t id);
+
+    Fl_Scrollbar*         scrollbar_;
+    LabelFn               labelFn_;
+    std::vector<uint64_t> ids_;
+    int                   top_      = 0;   // Первая видимая строка
+    int                   selected_ = -1;  // Выделенная строка, -1 - нет
+
+    std::unordered_map<uint64_t, std::string> labels_;
+    uint64_t                                  labelsRevision_ = 0;
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "entry_table.h"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+void EntryTable::reserve(size_t count) {
+    ids_.reserve(count);
+    titles_.reserve(count);
+    logins_.reserve(count);
+    passwords_.reserve(count);
+    fingerprints_.reserve(count);
+    sealed_.reserve(count);
+    favorites_.reserve(count);
+    hardwareKeys_.reserve(count);
+}
+
+void EntryTable::clear() {
+    ids_.clear();
+    titles_.clear();
+    logins_.clear();
+    passwords_.clear();
+    fingerprints_.clear();
+    sealed_.clear();
+    favorites_.clear();
+    hardwareKeys_.clear();
+}
+
+EntryRef EntryTable::operator[](size_t index) const {
+    EntryRef entry;
+    entry.id                       = ids_[index];
+    entry.title                    = titles_.get(index);
+    entry.login                    = logins_.get(index);
+    entry.password                 = passwords_.get(index);
+    entry.is_favorite              = favorites_.get(index);
+    entry.requires_hardware_key    = hardwareKeys_.get(index);
+    entry.hardware_key_fingerprint = fingerprints_.get(index);
+    entry.sealed_password          = sealed_[index];
+    return entry;
+}
+
+void EntryTable::push_back(const EntryRef& entry) {
+    ids_.push_back(entry.id);
+    titles_.push_back(entry.title);
+    logins_.push_back(entry.login);
+    passwords_.push_back(entry.password);
+    fingerprints_.push_back(entry.hardware_key_fingerprint);
+    sealed_.push_back(entry.sealed_password);
+    favorites_.push_back(entry.is_favorite);
+    hardwareKeys_.push_back(entry.requires_hardware_key);
+}
+
+void EntryTable::set(size_t index, const EntryRef& entry) {
+    ids_[index] = entry.id;
+    titles_.set(index, entry.title);
+    logins_.set(index, entry.login);
+    passwords_.set(index, entry.password);
+    fingerprints_.set(index, entry.hardware_key_fingerprint);
+    sealed_[index] = entry.sealed_password;
+    favorites_.set(index, entry.is_favorite);
+    hardwareKeys_.set(index, entry.requires_hardware_key);
+}
+
+void EntryTable::erase(size_t index) {
+    ids_.erase(ids_.begin() + index);
+    titles_.erase(index);
+    logins_.erase(index);
+    passwords_.erase(index);
+    fingerprints_.erase(index);
+    sealed_.erase(sealed_.begin() + index);
+    favorites_.erase(index);
+    hardwareKeys_.erase(index);
+}
+
+void EntryTable::unseal(size_t index, string_view password) {
+    passwords_.set(index, password);
+    sealed_[index] = {};
+}
+
+int EntryTable::find_title(string_view title) const {
+    return titles_.find(title);
+}
+
+void EntryTable::collect(bool favorite, vector<int>& rows) const {
+    favorites_.collect(favorite, rows);
+}
+
+void EntryTable::TextColumn::clear() {
+    // Освобождаемый буфер затирает SecureAllocator
+    decltype(bytes_)().swap(bytes_);
+    slices_.clear();
+    dead_ = 0;
+}
+
+uint32_t EntryTable::TextColumn::append(string_view s) {
+    if (bytes_.size() + s.size() > UINT32_MAX) throw length_error("EntryTable column overflow");
+
+    uint32_t offset = static_cast<uint32_t>(bytes_.size());
+    bytes_.insert(bytes_.end(), s.begin(), s.end());
+    return offset;
+}
+
+void EntryTable::TextColumn::release(const Slice& slice) {
+    if (slice.length == 0) return;
+    secure_zero(bytes_.data() + slice.offset, slice.length);
+    dead_ += slice.length;
+}
+
+void EntryTable::TextColumn::push_back(string_view s) {
+    // s может ссылаться в этот же буфер, который при росте переедет
+    string copy;
+    if (!bytes_.empty() && s.data() >= bytes_.data() && s.data() < bytes_.data() + bytes_.size()) {
+        copy = s;
+        s    = copy;
+    }
+    slices_.push_back({append(s), static_cast<uint32_t>(s.size())});
+    if (!copy.empty()) secure_wipe(copy);
+}
+
+void EntryTable::TextColumn::set(size_t index, string_view s) {
+    Slice& slice = slices_[index];
+    if (s.size() <= slice.length) {
+        // Помещается на старое место: хвост затирается и становится мусором
+        if (!s.empty()) memmove(bytes_.data() + slice.offset, s.data(), s.size());
+        release({static_cast<uint32_t>(slice.offset + s.size()),
+                 static_cast<uint32_t>(slice.length - s.size())});
+        slice.length = static_cast<uint32_t>(s.size());
+    } else {
+        Slice old = slice;
+        push_back(s);
+        slices_[index] = slices_.back();
+        slices_.pop_back();
+        release(old);
+    }
+    compact();
+}
+
+void EntryTable::TextColumn::erase(size_t index) {
+    release(slices_[index]);
+    slices_.erase(slices_.begin() + index);
+    compact();
+}
+
+void EntryTable::TextColumn::compact() {
+    size_t live = bytes_.size() - dead_;
+    if (dead_ < 64 * 1024 || dead_ < live) return;
+
+    // Строки переписываются подряд в порядке записей
+    decltype(bytes_) packed;
+    packed.reserve(live);
+    for (auto& slice : slices_) {
+        uint32_t offset = static_cast<uint32_t>(packed.size());
+        packed.insert(packed.end(), bytes_.begin() + slice.offset,
+                      bytes_.begin() + slice.offset + slice.length);
+        slice.offset = offset;
+    }
+    bytes_.swap(packed);
+    dead_ = 0;
+}
+
+int EntryTable::TextColumn::find(string_view s) const {
+    const char* data = bytes_.data();
+    for (size_t i = 0; i < slices_.size(); ++i) {
+        const Slice& slice = slices_[i];
+        if (slice.length == s.size() && memcmp(data + slice.offset, s.data(), s.size()) == 0) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void EntryTable::BitColumn::set(size_t index, bool value) {
+    uint64_t bit = uint64_t(1) << (index % 64);
+    if (value) {
+        words_[index / 64] |= bit;
+    } else {
+        words_[index / 64] &= ~bit;
+    }
+}
+
+void EntryTable::BitColumn::push_back(bool value) {
+    if (size_ % 64 == 0) words_.push_back(0);
+    set(size_++, value);
+}
+
+// Биты после index сдвигаются на один вниз, через границы слов
+void EntryTable::BitColumn::erase(size_t index) {
+    size_t   w    = index / 64;
+    size_t   b    = index % 64;
+    uint64_t low  = words_[w] & ((uint64_t(1) << b) - 1);
+    uint64_t high = b == 63 ? 0 : (words_[w] >> (b + 1)) << b;
+    words_[w]     = low | high;
+
+    for (size_t k = w; k + 1 < words_.size(); ++k) {
+        words_[k] |= (words_[k + 1] & 1) << 63;
+        words_[k + 1] >>= 1;
+    }
+    if (--size_ % 64 == 0) words_.pop_back();
+}
+
+void EntryTable::BitColumn::clear() {
+    words_.clear();
+    size_ = 0;
+}
+
+void EntryTable::BitColumn::collect(bool value, vector<int>& rows) const {
+    for (size_t w = 0; w < words_.size(); ++w) {
+        uint64_t bits = value ? words_[w] : ~words_[w];
+        // Биты за концом последнего слова не относятся к записям
+        if (w == words_.size() - 1 && size_ % 64 != 0) bits &= (uint64_t(1) << (size_ % 64)) - 1;
+
+        while (bits) {
+            rows.push_back(static_cast<int>(w * 64 + countr_zero(bits)));
+            bits &= bits - 1;
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef ENTRY_TABLE_H
+#define ENTRY_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "secure_arena.h"
+
+// Запись внутри хранилища. Поля ссылаются на память Vault (столбцы EntryTable, пул строк
+// изменённых записей или образ файла) и действительны, пока хранилище открыто;
+// строка, полученная из EntryTable, - до следующего изменения таблицы.
+// Пароль записи, загруженной из файла, остаётся запечатанным в образе (sealed_password)
+// и расшифровывается только по запросу - Vault::reveal.
+struct EntryRef {
+    uint64_t         id = 0;  // Постоянный номер записи, хранится в файле (0 - ещё не присвоен)
+    std::string_view title;
+    std::string_view login;
+    std::string_view password;  // Пусто, если пароль запечатан
+    bool             is_favorite           = false;
+    bool             requires_hardware_key = false;
+    std::string_view hardware_key_fingerprint;
+    std::string_view sealed_password;  // nonce, шифротекст и код подлинности в образе файла
+};
+
+// Записи хранилища по столбцам: строки каждого поля подряд в одном буфере со своей
+// таблицей смещений, флаги - битовыми наборами. Поиск по названию проходит один
+// плотный буфер, отбор избранных - биты, а не каждую запись целиком.
+// Список, поиск и запись файла читают поля через методы-столбцы; operator[] собирает
+// строку целиком.
+class EntryTable {
+   public:
+    size_t size() const { return ids_.size(); }
+    bool   empty() const { return ids_.empty(); }
+    void   reserve(size_t count);
+    void   clear();
+
+    EntryRef operator[](size_t index) const;
+
+    // Строки entry копируются в столбцы (запечатанный пароль - только ссылка)
+    void push_back(const EntryRef& entry);
+    void set(size_t index, const EntryRef& entry);
+    void erase(size_t index);
+
+    uint64_t         id(size_t index) const { return ids_[index]; }
+    std::string_view title(size_t index) const { return titles_.get(index); }
+    std::string_view login(size_t index) const { return logins_.get(index); }
+    std::string_view password(size_t index) const { return passwords_.get(index); }
+    std::string_view hardware_key_fingerprint(size_t index) const {
+        return fingerprints_.get(index);
+    }
+    std::string_view sealed_password(size_t index) const { return sealed_[index]; }
+    bool             is_favorite(size_t index) const { return favorites_.get(index); }
+    bool             requires_hardware_key(size_t index) const { return hardwareKeys_.get(index); }
+
+    void set_id(size_t index, uint64_t id) { ids_[index] = id; }
+    // Расшифрованный пароль вместо запечатанного (смена ключа)
+    void unseal(size_t index, std::string_view password);
+
+    // Индекс первой записи с таким названием, -1 если нет
+    int find_title(std::string_view title) const;
+
+    // Дописывает в rows индексы избранных (favorite) или остальных записей по возрастанию
+    void collect(bool favorite, std::vector<int>& rows) const;
+
+    class const_iterator {
+       public:
+        const_iterator(const EntryTable* table, size_t index) : table_(table), index_(index) {}
+
+        EntryRef        operator*() const { return (*table_)[index_]; }
+        const_iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+       private:
+        const EntryTable* table_;
+        size_t            index_;
+    };
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, size()}; }
+
+   private:
+    // Строки одного поля подряд. Изменённая строка дописывается в конец, а старое место
+    // затирается; когда затёртого становится больше живого, буфер уплотняется
+    class TextColumn {
+       public:
+        std::string_view get(size_t index) const {
+            const Slice& slice = slices_[index];
+            return std::string_view(bytes_.data() + slice.offset, slice.length);
+        }
+
+        void reserve(size_t count) { slices_.reserve(count); }
+        void clear();
+        void push_back(std::string_view s);
+        void set(size_t index, std::string_view s);
+        void erase(size_t index);
+
+        // Линейный поиск строки s по буферу, -1 если нет
+        int find(std::string_view s) const;
+
+       private:
+        struct Slice {
+            uint32_t offset = 0;
+            uint32_t length = 0;
+        };
+
+        uint32_t append(std::string_view s);
+        void     release(const Slice& slice);
+        void     compact();
+
+        std::vector<char, SecureAllocator<char>> bytes_;
+        std::vector<Slice>                       slices_;
+        size_t                                   dead_ = 0;  // Затёртых байт в bytes_
+    };
+
+    class BitColumn {
+       public:
+        bool get(size_t index) const { return words_[index / 64] >> (index % 64) & 1; }
+        void set(size_t index, bool value);
+        void push_back(bool value);
+        void erase(size_t index);
+        void reserve(size_t count) { words_.reserve((count + 63) / 64); }
+        void clear();
+
+        void collect(bool value, std::vector<int>& rows) const;
+
+       private:
+        std::vector<uint64_t> words_;
+        size_t                size_ = 0;
+    };
+
+    std::vector<uint64_t>         ids_;
+    TextColumn                    titles_;
+    TextColumn                    logins_;
+    TextColumn                    passwords_;
+    TextColumn                    fingerprints_;
+    std::vector<std::string_view> sealed_;  // Ссылки в образ файла: шифротекст не копируется
+    BitColumn                     favorites_;
+    BitColumn                     hardwareKeys_;
+};
+
+#endif
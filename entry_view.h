@@ -0,0 +1,56 @@
+#ifndef ENTRY_VIEW_H
+#define ENTRY_VIEW_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "database.h"
+#include "search_index.h"
+
+namespace entry_view {
+
+// Подходит ли запись под фильтр: подстрока в названии или логине
+inline bool matches(const EntryTable& entries, size_t index, std::string_view filterText) {
+    return entries.title(index).find(filterText) != std::string_view::npos ||
+           entries.login(index).find(filterText) != std::string_view::npos;
+}
+
+// Индексы записей в порядке отображения: сначала избранные, затем остальные.
+// Кандидатов даёт триграммный индекс, поэтому перебираются только они, а не всё хранилище.
+inline std::vector<int> filter_entries(const EntryTable& entries, const SearchIndex& index,
+                                       const std::string& filterText) {
+    std::vector<int> rows;
+
+    // Без фильтра порядок строится по битам избранного, без обхода записей
+    if (filterText.empty()) {
+        rows.reserve(entries.size());
+        entries.collect(true, rows);
+        entries.collect(false, rows);
+        return rows;
+    }
+
+    std::vector<int> matched;
+    bool             exact = filterText.size() < SearchIndex::GRAM;
+    for (uint32_t i : index.candidates(filterText)) {
+        if (exact || matches(entries, i, filterText)) matched.push_back(static_cast<int>(i));
+    }
+
+    rows.reserve(matched.size());
+
+    // Add favorites first
+    for (int i : matched) {
+        if (entries.is_favorite(i)) rows.push_back(i);
+    }
+
+    // Add regular entries
+    for (int i : matched) {
+        if (!entries.is_favorite(i)) rows.push_back(i);
+    }
+
+    return rows;
+}
+
+}  // namespace entry_view
+
+#endif
@@ -0,0 +1,273 @@
+#ifndef FILE_SYNC_H
+#define FILE_SYNC_H
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Запись файлов хранилища с гарантией, что данные дошли до диска.
+// Файлы создаются с правами 0600: кроме владельца их никто не читает.
+namespace file_sync {
+
+#ifndef _WIN32
+// fsync на macOS не сбрасывает кэш самого накопителя, для этого есть F_FULLFSYNC
+inline bool sync_fd(int fd) {
+#ifdef F_FULLFSYNC
+    if (fcntl(fd, F_FULLFSYNC) == 0) return true;
+#endif
+    return fsync(fd) == 0;
+}
+
+inline bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool pwrite_all(int fd, const char* data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, len, static_cast<off_t>(offset));
+        if (n < 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+// Переименование становится надёжным только после fsync каталога
+inline void sync_parent_dir(const std::string& path) {
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    int         fd  = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+}
+#endif
+
+// Пишет файл целиком во временный файл рядом, сбрасывает его на диск и атомарно
+// подменяет им старый. При сбое на диске остаётся либо старая, либо новая версия.
+inline bool write_file_atomic(const std::string& path, const std::vector<std::string_view>& parts) {
+    std::string tmp = path + ".tmp";
+#ifndef _WIN32
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return false;
+
+    bool ok = true;
+    for (auto part : parts) {
+        ok = ok && write_all(fd, part.data(), part.size());
+    }
+    ok = ok && sync_fd(fd);
+    ok = (::close(fd) == 0) && ok;
+
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    sync_parent_dir(path);
+    return true;
+#else
+    {
+        std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+        if (!os) return false;
+        for (auto part : parts) os.write(part.data(), part.size());
+        os.flush();
+        if (!os) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+    return !ec;
+#endif
+}
+
+// Дописывает данные в конец файла (или создаёт его заново) и сбрасывает на диск
+inline bool append_file_synced(const std::string& path, std::string_view data, bool truncate) {
+#ifndef _WIN32
+    int flags = O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND);
+    int fd    = ::open(path.c_str(), flags, 0600);
+    if (fd < 0) return false;
+
+    bool ok = write_all(fd, data.data(), data.size()) && sync_fd(fd);
+    ok      = (::close(fd) == 0) && ok;
+    if (ok && truncate) sync_parent_dir(path);
+    return ok;
+#else
+    auto          mode = std::ios::binary | (truncate ? std::ios::trunc : std::ios::app);
+    std::ofstream os(path, mode);
+    if (!os) return false;
+    os.write(data.data(), data.size());
+    os.flush();
+    return bool(os);
+#endif
+}
+
+// write_file_atomic для данных, которые пишутся частями по мере готовности: файл
+// собирается во временном рядом и подменяет старый только в commit(). Без commit()
+// временный файл удаляется, старый остаётся нетронутым
+class AtomicFile {
+   public:
+    AtomicFile() = default;
+    ~AtomicFile() { abort(); }
+
+    AtomicFile(const AtomicFile&)            = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+
+    bool open(const std::string& path) {
+        abort();
+        path_ = path;
+        tmp_  = path + ".tmp";
+#ifndef _WIN32
+        fd_ = ::open(tmp_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        return fd_ >= 0;
+#else
+        fs_.open(tmp_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        return bool(fs_);
+#endif
+    }
+
+    // Дописывает в конец
+    bool write(std::string_view data) {
+#ifndef _WIN32
+        return write_all(fd_, data.data(), data.size());
+#else
+        fs_.seekp(0, std::ios::end);
+        return bool(fs_.write(data.data(), data.size()));
+#endif
+    }
+
+    // Переписывает уже записанное (заголовок, который известен только в конце)
+    bool write_at(std::string_view data, uint64_t offset) {
+#ifndef _WIN32
+        return pwrite_all(fd_, data.data(), data.size(), offset);
+#else
+        fs_.seekp(offset);
+        return bool(fs_.write(data.data(), data.size()));
+#endif
+    }
+
+    bool commit() {
+#ifndef _WIN32
+        bool ok = sync_fd(fd_);
+        ok      = (::close(fd_) == 0) && ok;
+        fd_     = -1;
+        if (!ok || ::rename(tmp_.c_str(), path_.c_str()) != 0) {
+            ::unlink(tmp_.c_str());
+            return false;
+        }
+        sync_parent_dir(path_);
+        return true;
+#else
+        fs_.flush();
+        bool ok = bool(fs_);
+        fs_.close();
+        std::error_code ec;
+        if (ok) std::filesystem::rename(tmp_, path_, ec);
+        if (!ok || ec) std::filesystem::remove(tmp_, ec);
+        return ok && !ec;
+#endif
+    }
+
+    void abort() {
+#ifndef _WIN32
+        if (fd_ < 0) return;
+        ::close(fd_);
+        fd_ = -1;
+        ::unlink(tmp_.c_str());
+#else
+        if (!fs_.is_open()) return;
+        fs_.close();
+        std::error_code ec;
+        std::filesystem::remove(tmp_, ec);
+#endif
+    }
+
+   private:
+    std::string path_;
+    std::string tmp_;
+#ifndef _WIN32
+    int fd_ = -1;
+#else
+    std::fstream fs_;
+#endif
+};
+
+// Файл, изменяемый на месте (дописывание блоков v2): запись по смещению и сброс на диск
+class SyncedFile {
+   public:
+    SyncedFile() = default;
+    ~SyncedFile() { close(); }
+
+    SyncedFile(const SyncedFile&)            = delete;
+    SyncedFile& operator=(const SyncedFile&) = delete;
+
+    bool open(const std::string& path) {
+#ifndef _WIN32
+        fd_ = ::open(path.c_str(), O_RDWR);
+        return fd_ >= 0;
+#else
+        fs_.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        return bool(fs_);
+#endif
+    }
+
+    bool read_at(void* data, size_t len, uint64_t offset) {
+#ifndef _WIN32
+        return ::pread(fd_, data, len, static_cast<off_t>(offset)) == static_cast<ssize_t>(len);
+#else
+        fs_.seekg(offset);
+        return bool(fs_.read(static_cast<char*>(data), len));
+#endif
+    }
+
+    bool write_at(std::string_view data, uint64_t offset) {
+#ifndef _WIN32
+        return pwrite_all(fd_, data.data(), data.size(), offset);
+#else
+        fs_.seekp(offset);
+        return bool(fs_.write(data.data(), data.size()));
+#endif
+    }
+
+    bool sync() {
+#ifndef _WIN32
+        return sync_fd(fd_);
+#else
+        return bool(fs_.flush());
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#else
+        if (fs_.is_open()) fs_.close();
+#endif
+    }
+
+   private:
+#ifndef _WIN32
+    int fd_ = -1;
+#else
+    std::fstream fs_;
+#endif
+};
+
+}  // namespace file_sync
+
+#endif
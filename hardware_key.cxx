@@ -0,0 +1,339 @@
+#include "hardware_key.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#endif
+
+#ifdef __APPLE__
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/IOKitLib.h>
+#include <IOKit/usb/IOUSBLib.h>
+#endif
+
+using namespace std;
+
+namespace hardware_key {
+
+// Фильтруем встроенные устройства (hub, bluetooth, камеры и т.д.)
+// Оставляем только массовые накопители и устройства с серийным номером
+static bool is_key_candidate(const USBDevice& device, bool massStorage) {
+    string name_lower = device.name;
+    transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
+
+    bool is_storage_device = massStorage || name_lower.find("storage") != string::npos ||
+                             name_lower.find("disk") != string::npos ||
+                             name_lower.find("flash") != string::npos ||
+                             name_lower.find("card reader") != string::npos ||
+                             name_lower.find("mass storage") != string::npos;
+
+    bool is_excluded = name_lower.find("hub") != string::npos ||
+                       name_lower.find("bluetooth") != string::npos ||
+                       name_lower.find("camera") != string::npos ||
+                       name_lower.find("keyboard") != string::npos ||
+                       name_lower.find("mouse") != string::npos;
+
+    return (is_storage_device || !device.serial_number.empty()) && !is_excluded;
+}
+
+// Создаём fingerprint из vendor_id, product_id и serial_number
+// Это уникальный идентификатор конкретного устройства
+static string make_fingerprint(const USBDevice& device) {
+    string fingerprint = device.vendor_id + ":" + device.product_id;
+
+    // Если есть серийный номер, добавляем его для большей уникальности
+    if (!device.serial_number.empty()) fingerprint += ":" + device.serial_number;
+    return fingerprint;
+}
+
+// Атрибут sysfs - одна строка текста
+static string read_attribute(const filesystem::path& dir, const char* name) {
+    ifstream is(dir / name);
+    string   value;
+    if (!is || !getline(is, value)) return "";
+    while (!value.empty() && isspace(static_cast<unsigned char>(value.back()))) value.pop_back();
+    return value;
+}
+
+// Есть ли у устройства интерфейс класса Mass Storage (08)
+static bool has_storage_interface(const filesystem::path& dir) {
+    string     prefix = dir.filename().string() + ":";
+    error_code ec;
+    for (filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().filename().string().rfind(prefix, 0) != 0) continue;
+        if (read_attribute(it->path(), "bInterfaceClass") == "08") return true;
+    }
+    return false;
+}
+
+vector<USBDevice> scan_sysfs(const string& root) {
+    vector<USBDevice> devices;
+
+    error_code ec;
+    for (filesystem::directory_iterator it(filesystem::path(root) / "bus/usb/devices", ec), end;
+         !ec && it != end; it.increment(ec)) {
+        // Интерфейсы ("1-1:1.0") - части устройства, "usbN" - корневые хабы контроллеров
+        string entry = it->path().filename().string();
+        if (entry.find(':') != string::npos || entry.rfind("usb", 0) == 0) continue;
+
+        const filesystem::path& dir = it->path();
+        if (read_attribute(dir, "bDeviceClass") == "09") continue;  // Хаб
+
+        USBDevice usb_device;
+        usb_device.vendor_id     = read_attribute(dir, "idVendor");
+        usb_device.product_id    = read_attribute(dir, "idProduct");
+        usb_device.serial_number = read_attribute(dir, "serial");
+        usb_device.name          = read_attribute(dir, "product");
+        if (usb_device.vendor_id.empty() || usb_device.product_id.empty()) continue;
+
+        if (usb_device.name.empty()) usb_device.name = "Unknown USB Device";
+        usb_device.fingerprint = make_fingerprint(usb_device);
+
+        if (is_key_candidate(usb_device, has_storage_interface(dir))) {
+            devices.push_back(usb_device);
+        }
+    }
+
+    // Порядок обхода каталога не определён, а список устройств видит пользователь
+    sort(devices.begin(), devices.end(),
+         [](const USBDevice& a, const USBDevice& b) { return a.fingerprint < b.fingerprint; });
+    return devices;
+}
+
+#ifdef __APPLE__
+// Получить строковое свойство USB устройства из IOKit
+static string get_usb_string_property(io_service_t device, CFStringRef property) {
+    CFTypeRef property_ref =
+        IORegistryEntryCreateCFProperty(device, property, kCFAllocatorDefault, 0);
+    if (!property_ref) return "";
+
+    string result;
+    if (CFGetTypeID(property_ref) == CFStringGetTypeID()) {
+        CFStringRef string_ref = (CFStringRef)property_ref;
+        char        buffer[256];
+        if (CFStringGetCString(string_ref, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
+            result = buffer;
+        }
+    } else if (CFGetTypeID(property_ref) == CFNumberGetTypeID()) {
+        CFNumberRef number_ref = (CFNumberRef)property_ref;
+        int         value;
+        if (CFNumberGetValue(number_ref, kCFNumberIntType, &value)) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%04x", value);
+            result = buffer;
+        }
+    }
+
+    CFRelease(property_ref);
+    return result;
+}
+
+static vector<USBDevice> scan_iokit() {
+    vector<USBDevice> devices;
+
+    // Создаём словарь для поиска USB устройств
+    CFMutableDictionaryRef matching_dict = IOServiceMatching(kIOUSBDeviceClassName);
+    if (!matching_dict) return devices;
+
+    io_iterator_t iterator;
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    kern_return_t kr = IOServiceGetMatchingServices(kIOMasterPortDefault, matching_dict, &iterator);
+#pragma clang diagnostic pop
+    if (kr != KERN_SUCCESS) return devices;
+
+    io_service_t device;
+    while ((device = IOIteratorNext(iterator))) {
+        USBDevice usb_device;
+
+        // Получаем основные свойства
+        usb_device.vendor_id     = get_usb_string_property(device, CFSTR("idVendor"));
+        usb_device.product_id    = get_usb_string_property(device, CFSTR("idProduct"));
+        usb_device.serial_number = get_usb_string_property(device, CFSTR("USB Serial Number"));
+        usb_device.name          = get_usb_string_property(device, CFSTR("USB Product Name"));
+
+        // Если имени нет, пробуем другие варианты
+        if (usb_device.name.empty()) {
+            usb_device.name = get_usb_string_property(device, CFSTR("kUSBProductString"));
+        }
+        if (usb_device.name.empty()) {
+            usb_device.name = "Unknown USB Device";
+        }
+
+        if (!usb_device.vendor_id.empty() && !usb_device.product_id.empty()) {
+            usb_device.fingerprint = make_fingerprint(usb_device);
+            if (is_key_candidate(usb_device, false)) devices.push_back(usb_device);
+        }
+
+        IOObjectRelease(device);
+    }
+
+    IOObjectRelease(iterator);
+    return devices;
+}
+#endif
+
+DeviceTable::DeviceTable(Enumerate enumerate, bool hotplug) : enumerate_(std::move(enumerate)) {
+    if (!enumerate_) return;
+    refresh();
+
+#ifndef _WIN32
+    if (hotplug && pipe(stopPipe_) == 0) thread_ = thread(&DeviceTable::watch, this);
+#endif
+}
+
+DeviceTable::~DeviceTable() {
+#ifndef _WIN32
+    if (thread_.joinable()) {
+        char stop = 0;
+        (void)!write(stopPipe_[1], &stop, 1);
+        thread_.join();
+    }
+    if (stopPipe_[0] >= 0) {
+        close(stopPipe_[0]);
+        close(stopPipe_[1]);
+    }
+#endif
+}
+
+vector<USBDevice> DeviceTable::devices() {
+    lock_guard<mutex> lock(mutex_);
+    return devices_;
+}
+
+bool DeviceTable::connected(string_view fingerprint) {
+    if (!enumerate_) return true;  // Платформа без перечисления: не проверяем
+    if (fingerprint.empty()) return false;
+
+    lock_guard<mutex> lock(mutex_);
+    return byFingerprint_.count(string(fingerprint)) > 0;
+}
+
+string DeviceTable::name(string_view fingerprint) {
+    lock_guard<mutex> lock(mutex_);
+    auto              it = byFingerprint_.find(string(fingerprint));
+    return it == byFingerprint_.end() ? "" : devices_[it->second].name;
+}
+
+void DeviceTable::refresh() {
+    if (!enumerate_) return;
+    vector<USBDevice> devices = enumerate_();
+
+    unordered_map<string, size_t> byFingerprint;
+    for (size_t i = 0; i < devices.size(); ++i) byFingerprint.emplace(devices[i].fingerprint, i);
+
+    vector<string> changed;
+    Listener       listener;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (const auto& [fingerprint, index] : byFingerprint) {
+            if (!byFingerprint_.count(fingerprint)) changed.push_back(fingerprint);
+        }
+        for (const auto& [fingerprint, index] : byFingerprint_) {
+            if (!byFingerprint.count(fingerprint)) changed.push_back(fingerprint);
+        }
+        devices_       = std::move(devices);
+        byFingerprint_ = std::move(byFingerprint);
+        listener       = listener_;
+    }
+
+    if (!changed.empty() && listener) listener(changed);
+}
+
+void DeviceTable::set_listener(Listener listener) {
+    lock_guard<mutex> lock(mutex_);
+    listener_ = std::move(listener);
+}
+
+#ifdef __linux__
+// Событие ядра: "ACTION@DEVPATH\0KEY=VALUE\0...". Нужны только целые USB устройства
+static bool is_usb_device_event(const char* message, size_t len) {
+    bool usb = false, device = false;
+    for (size_t pos = 0; pos < len;) {
+        string_view field(message + pos, strnlen(message + pos, len - pos));
+        usb    = usb || field == "SUBSYSTEM=usb";
+        device = device || field == "DEVTYPE=usb_device";
+        pos += field.size() + 1;
+    }
+    return usb && device;
+}
+
+// Подписка на события hotplug ядра, -1 если netlink недоступен (например, в песочнице)
+static int open_uevent_socket() {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) return -1;
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_pid    = 0;
+    addr.nl_groups = 1;  // События ядра (udev рассылает свои в группе 2)
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+#ifndef _WIN32
+void DeviceTable::watch() {
+    int uevents = -1;
+#ifdef __linux__
+    uevents = open_uevent_socket();
+#endif
+
+    pollfd fds[2] = {{stopPipe_[0], POLLIN, 0}, {uevents, POLLIN, 0}};
+    int    count  = uevents >= 0 ? 2 : 1;
+    // Без событий hotplug таблица перечитывается по таймеру
+    int timeout = uevents >= 0 ? -1
+                               : static_cast<int>(chrono::milliseconds(REFRESH_INTERVAL).count());
+
+    while (true) {
+        int ready = poll(fds, count, timeout);
+        if (ready < 0 && errno != EINTR) break;
+        if (fds[0].revents) break;
+
+        bool changed = ready == 0;
+#ifdef __linux__
+        if (count == 2 && (fds[1].revents & POLLIN)) {
+            // Одно подключение порождает пачку событий - разбираем все и перечитываем один раз
+            char buffer[8192];
+            for (ssize_t n; (n = recv(uevents, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0;) {
+                changed = changed || is_usb_device_event(buffer, static_cast<size_t>(n));
+            }
+        }
+#endif
+        if (changed) refresh();
+    }
+
+    if (uevents >= 0) close(uevents);
+}
+#else
+void DeviceTable::watch() {}
+#endif
+
+DeviceTable& device_table() {
+#if defined(__APPLE__)
+    static DeviceTable table(scan_iokit);
+#elif defined(__linux__)
+    static DeviceTable table([] { return scan_sysfs(); });
+#else
+    static DeviceTable table(nullptr);
+#endif
+    return table;
+}
+
+}  // namespace hardware_key
@@ -1,15 +1,15 @@
 #ifndef HARDWARE_KEY_H
 #define HARDWARE_KEY_H
 
+#include <chrono>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
-#ifdef __APPLE__
-#include <CoreFoundation/CoreFoundation.h>
-#include <IOKit/IOKitLib.h>
-#include <IOKit/usb/IOUSBLib.h>
-#endif
-
 namespace hardware_key {
 
 struct USBDevice {
@@ -20,150 +20,67 @@ struct USBDevice {
     std::string serial_number;
 };
 
-#ifdef __APPLE__
-// Получить строковое свойство USB устройства из IOKit
-inline std::string get_usb_string_property(io_service_t device, CFStringRef property) {
-    CFTypeRef property_ref = IORegistryEntryCreateCFProperty(device, property, kCFAllocatorDefault, 0);
-    if (!property_ref) return "";
-
-    std::string result;
-    if (CFGetTypeID(property_ref) == CFStringGetTypeID()) {
-        CFStringRef string_ref = (CFStringRef)property_ref;
-        char        buffer[256];
-        if (CFStringGetCString(string_ref, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
-            result = buffer;
-        }
-    } else if (CFGetTypeID(property_ref) == CFNumberGetTypeID()) {
-        CFNumberRef number_ref = (CFNumberRef)property_ref;
-        int         value;
-        if (CFNumberGetValue(number_ref, kCFNumberIntType, &value)) {
-            char buffer[32];
-            snprintf(buffer, sizeof(buffer), "%04x", value);
-            result = buffer;
-        }
-    }
-
-    CFRelease(property_ref);
-    return result;
-}
+// Перечисление USB устройств через sysfs (Linux): <root>/bus/usb/devices.
+// root подменяется поддельным деревом в hush_bench --selftest.
+std::vector<USBDevice> scan_sysfs(const std::string& root = "/sys");
 
-// Получить список всех подключенных USB устройств (съёмных носителей)
-inline std::vector<USBDevice> get_usb_devices() {
-    std::vector<USBDevice> devices;
-
-    // Создаём словарь для поиска USB устройств
-    CFMutableDictionaryRef matching_dict = IOServiceMatching(kIOUSBDeviceClassName);
-    if (!matching_dict) return devices;
-
-    io_iterator_t iterator;
-    #pragma clang diagnostic push
-    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-    kern_return_t kr =
-        IOServiceGetMatchingServices(kIOMasterPortDefault, matching_dict, &iterator);
-    #pragma clang diagnostic pop
-    if (kr != KERN_SUCCESS) return devices;
-
-    io_service_t device;
-    while ((device = IOIteratorNext(iterator))) {
-        USBDevice usb_device;
-
-        // Получаем основные свойства
-        usb_device.vendor_id  = get_usb_string_property(device, CFSTR("idVendor"));
-        usb_device.product_id = get_usb_string_property(device, CFSTR("idProduct"));
-        usb_device.serial_number = get_usb_string_property(device, CFSTR("USB Serial Number"));
-        usb_device.name          = get_usb_string_property(device, CFSTR("USB Product Name"));
-
-        // Если имени нет, пробуем другие варианты
-        if (usb_device.name.empty()) {
-            usb_device.name = get_usb_string_property(device, CFSTR("kUSBProductString"));
-        }
-        if (usb_device.name.empty()) {
-            usb_device.name = "Unknown USB Device";
-        }
-
-        // Создаём fingerprint из vendor_id, product_id и serial_number
-        // Это уникальный идентификатор конкретного устройства
-        if (!usb_device.vendor_id.empty() && !usb_device.product_id.empty()) {
-            usb_device.fingerprint =
-                usb_device.vendor_id + ":" + usb_device.product_id;
-
-            // Если есть серийный номер, добавляем его для большей уникальности
-            if (!usb_device.serial_number.empty()) {
-                usb_device.fingerprint += ":" + usb_device.serial_number;
-            }
-
-            // Фильтруем встроенные устройства (hub, bluetooth, камеры и т.д.)
-            // Оставляем только массовые накопители
-            std::string name_lower = usb_device.name;
-            std::transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
-
-            bool is_storage_device =
-                name_lower.find("storage") != std::string::npos ||
-                name_lower.find("disk") != std::string::npos ||
-                name_lower.find("flash") != std::string::npos ||
-                name_lower.find("card reader") != std::string::npos ||
-                name_lower.find("mass storage") != std::string::npos;
-
-            bool is_excluded =
-                name_lower.find("hub") != std::string::npos ||
-                name_lower.find("bluetooth") != std::string::npos ||
-                name_lower.find("camera") != std::string::npos ||
-                name_lower.find("keyboard") != std::string::npos ||
-                name_lower.find("mouse") != std::string::npos;
-
-            // Добавляем только потенциальные накопители или устройства с серийником
-            if ((is_storage_device || !usb_device.serial_number.empty()) && !is_excluded) {
-                devices.push_back(usb_device);
-            }
-        }
-
-        IOObjectRelease(device);
-    }
-
-    IOObjectRelease(iterator);
-    return devices;
-}
+// Таблица подключённых устройств. Перечисление делается один раз на всех, а проверка
+// ключа - поиск в хэше по fingerprint. Таблицу обновляет фоновый поток: на Linux - по
+// событиям hotplug (netlink uevent), иначе - перечислением раз в REFRESH_INTERVAL.
+class DeviceTable {
+   public:
+    using Enumerate = std::function<std::vector<USBDevice>()>;
+    // Вызывается из фонового потока с fingerprint'ами подключённых и отключённых устройств
+    using Listener = std::function<void(const std::vector<std::string>& changed)>;
 
-// Проверить, подключено ли устройство с данным fingerprint
-inline bool is_device_connected(const std::string& fingerprint) {
-    if (fingerprint.empty()) return false;
-
-    std::vector<USBDevice> devices = get_usb_devices();
-    for (const auto& device : devices) {
-        if (device.fingerprint == fingerprint) {
-            return true;
-        }
-    }
-    return false;
-}
+    static constexpr auto REFRESH_INTERVAL = std::chrono::seconds(2);
 
-// Получить имя устройства по fingerprint (если подключено)
-inline std::string get_device_name(const std::string& fingerprint) {
-    if (fingerprint.empty()) return "";
-
-    std::vector<USBDevice> devices = get_usb_devices();
-    for (const auto& device : devices) {
-        if (device.fingerprint == fingerprint) {
-            return device.name;
-        }
-    }
-    return "";
-}
+    // enumerate == nullptr - платформа не умеет перечислять устройства, ключи не проверяются.
+    // hotplug == false - таблица обновляется только через refresh()
+    explicit DeviceTable(Enumerate enumerate, bool hotplug = true);
+    ~DeviceTable();
+
+    DeviceTable(const DeviceTable&)            = delete;
+    DeviceTable& operator=(const DeviceTable&) = delete;
 
-#else
-// Заглушки для не-macOS платформ
+    std::vector<USBDevice> devices();
+    bool                   connected(std::string_view fingerprint);
+    std::string            name(std::string_view fingerprint);
+
+    // Перечисляет устройства заново и сообщает слушателю об изменениях
+    void refresh();
+    void set_listener(Listener listener);
+
+   private:
+    void watch();
+
+    Enumerate enumerate_;
+    Listener  listener_;
+
+    std::mutex                              mutex_;
+    std::vector<USBDevice>                  devices_;
+    std::unordered_map<std::string, size_t> byFingerprint_;  // fingerprint -> индекс в devices_
+    std::thread                             thread_;
+    int                                     stopPipe_[2] = {-1, -1};  // Будит поток при закрытии
+};
+
+// Общая таблица устройств этой машины
+DeviceTable& device_table();
+
+// Получить список всех подключенных USB устройств (съёмных носителей)
 inline std::vector<USBDevice> get_usb_devices() {
-    return {};
+    return device_table().devices();
 }
 
-inline bool is_device_connected(const std::string& fingerprint) {
-    return true;  // На других платформах не проверяем
+// Проверить, подключено ли устройство с данным fingerprint
+inline bool is_device_connected(std::string_view fingerprint) {
+    return device_table().connected(fingerprint);
 }
 
-inline std::string get_device_name(const std::string& fingerprint) {
-    return "";
+// Получить имя устройства по fingerprint (если подключено)
+inline std::string get_device_name(std::string_view fingerprint) {
+    return device_table().name(fingerprint);
 }
-#endif
 
 }  // namespace hardware_key
 
@@ -0,0 +1,207 @@
+#include "journal.h"
+
+#include <advobfuscator/string.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "file_sync.h"
+#include "vault_format.h"
+
+using namespace std;
+using namespace andrivet::advobfuscator;
+
+// Формат журнала:
+//   заголовок  "HSHJ", версия, отпечаток заголовка файла хранилища
+//   записи     длина, запечатанный {контрольная сумма, операция, индекс, номер, запись}
+// Записи запечатаны ChaCha20-Poly1305 на ключе файла, как блоки формата v2 (seal_payload);
+// код подлинности покрывает и отпечаток заголовка, так что запись не перенести в чужой журнал.
+static constexpr auto     MAGIC_JOURNAL       = "HSHJ"_obf;
+static constexpr uint32_t JOURNAL_VERSION     = 1;
+static constexpr size_t   JOURNAL_HEADER_SIZE = 16;
+static constexpr size_t   RECORD_FIXED_SIZE   = sizeof(uint32_t) + 1 + 2 * sizeof(uint64_t);
+
+string journal_path(const string& vaultPath) {
+    return vaultPath + ".journal";
+}
+
+bool db_journal_usable(const Vault& vault) {
+    return vault.layout.version == VAULT_FORMAT_V2 && vault.layout.index_capacity > 0 &&
+           !vault.path.empty() && vault.key && !vault.journal.stale;
+}
+
+static void encode_record(string& out, const JournalRecord& record, const uint8_t* fileKey,
+                          uint64_t headerHash) {
+    size_t bodySize = record.op != JournalOp::Remove ? entry_size(record.entry) : 0;
+    string sealed;
+    sealed.reserve(SEALED_OVERHEAD + RECORD_FIXED_SIZE + bodySize);
+    sealed.resize(CHACHA_NONCE_SIZE + sizeof(uint32_t));  // Место под nonce и контрольную сумму
+    sealed.push_back(static_cast<char>(record.op));
+    put_u64(sealed, record.index);
+    put_u64(sealed, record.entry.id);
+    if (record.op != JournalOp::Remove) write_entry(sealed, record.entry);
+
+    size_t   body     = CHACHA_NONCE_SIZE + sizeof(uint32_t);
+    uint32_t checksum = static_cast<uint32_t>(fnv1a64(sealed.data() + body, sealed.size() - body));
+    memcpy(sealed.data() + CHACHA_NONCE_SIZE, &checksum, sizeof(checksum));
+
+    seal_payload(sealed, fileKey, (const uint8_t*)&headerHash, sizeof(headerHash));
+    put_u32(out, static_cast<uint32_t>(sealed.size()));
+    out.append(sealed);
+}
+
+// Расшифровывает запись на месте. Строки записи ссылаются в data
+static bool decode_record(uint8_t* data, size_t size, const uint8_t* fileKey, uint64_t headerHash,
+                          JournalRecord& record) {
+    uint8_t* payload;
+    size_t   payloadSize;
+    if (!open_payload(data, size, fileKey, (const uint8_t*)&headerHash, sizeof(headerHash),
+                      payload, payloadSize) ||
+        payloadSize < RECORD_FIXED_SIZE) {
+        return false;
+    }
+
+    uint32_t checksum = static_cast<uint32_t>(
+        fnv1a64(payload + sizeof(uint32_t), payloadSize - sizeof(uint32_t)));
+    if (get_u32(payload) != checksum) return false;
+
+    uint8_t op = payload[sizeof(uint32_t)];
+    if (op < static_cast<uint8_t>(JournalOp::Add) || op > static_cast<uint8_t>(JournalOp::Remove)) {
+        return false;
+    }
+    record.op       = static_cast<JournalOp>(op);
+    record.index    = get_u64(payload + sizeof(uint32_t) + 1);
+    record.entry.id = get_u64(payload + sizeof(uint32_t) + 1 + sizeof(uint64_t));
+
+    size_t pos = RECORD_FIXED_SIZE;
+    return record.op == JournalOp::Remove || read_entry(payload, payloadSize, pos, record.entry);
+}
+
+bool db_journal_take(Vault& vault, JournalBatch& batch) {
+    if (!db_journal_usable(vault)) return false;
+
+    batch.records = std::move(vault.journal.pending);
+    vault.journal.pending.clear();
+    batch.path = vault.path;
+    batch.key         = vault.key;
+    batch.header_hash = vault.layout.header_hash;
+    batch.offset      = vault.journal.bytes;
+    batch.written     = 0;
+    return true;
+}
+
+bool db_journal_write(JournalBatch& batch) {
+    if (batch.records.empty()) return true;
+    if (!batch.key) return false;
+    const uint8_t* fileKey = batch.key->data();
+
+    string out;
+    if (batch.offset == 0) {
+        auto magic = MAGIC_JOURNAL;
+        out.append((const char*)magic, 4);
+        put_u32(out, JOURNAL_VERSION);
+        put_u64(out, batch.header_hash);
+    }
+    for (const auto& record : batch.records) {
+        encode_record(out, record, fileKey, batch.header_hash);
+    }
+
+    // Новый журнал пишется с нуля: старый файл мог остаться от другого снимка
+    if (!file_sync::append_file_synced(journal_path(batch.path), out, batch.offset == 0)) {
+        return false;
+    }
+    batch.written = out.size();
+    return true;
+}
+
+void db_journal_commit(Vault& vault, const JournalBatch& batch, bool written) {
+    VaultJournal& journal = vault.journal;
+    if (!written) {
+        // В журнале мог остаться обрывок, а изменения пачки уже не в pending
+        journal.stale = true;
+        return;
+    }
+    if (batch.written == 0) return;
+
+    if (journal.bytes == 0) journal.started = chrono::steady_clock::now();
+    journal.bytes += batch.written;
+}
+
+bool db_journal_append(Vault& vault) {
+    if (vault.journal.pending.empty()) return true;
+
+    JournalBatch batch;
+    if (!db_journal_take(vault, batch)) return false;
+    bool written = db_journal_write(batch);
+    db_journal_commit(vault, batch, written);
+    return written;
+}
+
+void db_journal_replay(Vault& vault) {
+    string   path = journal_path(vault.path);
+    ifstream is(path, ios::binary);
+    if (!is) return;
+
+    string data((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+    is.close();
+
+    error_code ec;
+    auto       magic = MAGIC_JOURNAL;
+    if (!db_journal_usable(vault) || data.size() < JOURNAL_HEADER_SIZE ||
+        memcmp(data.data(), (const char*)magic, 4) != 0 ||
+        get_u32((const uint8_t*)data.data() + 4) != JOURNAL_VERSION ||
+        get_u64((const uint8_t*)data.data() + 8) != vault.layout.header_hash) {
+        // Журнал от другого снимка файла: его изменения уже записаны в файл
+        filesystem::remove(path, ec);
+        return;
+    }
+
+    const uint8_t* fileKey = vault.key->data();
+
+    // Записи ссылаются на расшифрованный журнал, поэтому он расшифровывается
+    // в закреплённом пуле хранилища, а data остаётся шифротекстом
+    size_t   size = data.size();
+    uint8_t* base = vault.arena.allocate(size);
+    memcpy(base, data.data(), size);
+    size_t pos = JOURNAL_HEADER_SIZE;
+
+    while (pos + sizeof(uint32_t) <= size) {
+        uint32_t len = get_u32(base + pos);
+        if (len > size - pos - sizeof(uint32_t)) break;
+
+        JournalRecord record;
+        if (!decode_record(base + pos + sizeof(uint32_t), len, fileKey, vault.layout.header_hash,
+                           record) ||
+            !vault.apply(record)) {
+            break;
+        }
+        pos += sizeof(uint32_t) + len;
+    }
+
+    // Обрезанный хвост от сбоя посреди записи отбрасываем, чтобы дописывать после целых записей
+    if (pos < size) filesystem::resize_file(path, pos, ec);
+
+    vault.journal.bytes   = pos;
+    vault.journal.started = chrono::steady_clock::now();
+}
+
+void db_journal_remove(const string& vaultPath) {
+    error_code ec;
+    filesystem::remove(journal_path(vaultPath), ec);
+}
+
+bool db_journal_needs_compaction(const Vault& vault) {
+    const VaultJournal& journal = vault.journal;
+    if (journal.bytes == 0) return false;
+    return journal.bytes >= JOURNAL_COMPACT_BYTES ||
+           chrono::steady_clock::now() - journal.started >= JOURNAL_COMPACT_AGE;
+}
+
+bool db_autosave(Vault& vault) {
+    if (vault.path.empty() || !vault.key) return false;
+
+    // Если дописать журнал не вышло, в нём мог остаться обрывок - пишем файл целиком
+    if (db_journal_usable(vault) && db_journal_append(vault)) return true;
+    return db_save_file(vault, vault.path);
+}
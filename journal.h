@@ -0,0 +1,57 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "database.h"
+
+// Журнал автосохранения: каждое изменение записи дописывается в <файл>.journal
+// отдельной зашифрованной записью, поэтому сохранение правки стоит O(размер записи).
+// Журнал привязан к отпечатку заголовка файла и воспроизводится в db_load_file.
+// Когда журнал разрастается или стареет, он сворачивается в основной файл:
+// db_save_file переписывает изменённые блоки и удаляет журнал.
+// Каждая пачка записей сбрасывается на диск (fsync) до того, как считается сохранённой.
+
+constexpr uint64_t JOURNAL_COMPACT_BYTES = 1 << 20;
+constexpr auto     JOURNAL_COMPACT_AGE   = std::chrono::minutes(10);
+
+std::string journal_path(const std::string& vaultPath);
+
+// Журнал ведётся для файлов v2, уже записанных на диск, пока он покрывает все изменения
+bool db_journal_usable(const Vault& vault);
+
+// Изменения, снятые с хранилища для записи в журнал без удержания блокировки
+struct JournalBatch {
+    std::vector<JournalRecord> records;
+    std::string                path;              // Файл хранилища
+    VaultKeyPtr                key;
+    uint64_t                   header_hash = 0;
+    uint64_t                   offset      = 0;  // Длина журнала на диске, 0 - создать заново
+    uint64_t                   written     = 0;
+};
+
+// Дописывание в журнал по шагам, как db_snapshot/db_write_snapshot/db_commit_snapshot:
+// take и commit под блокировкой хранилища, write - без неё
+bool db_journal_take(Vault& vault, JournalBatch& batch);
+bool db_journal_write(JournalBatch& batch);
+void db_journal_commit(Vault& vault, const JournalBatch& batch, bool written);
+
+// Дописывает накопленные изменения (vault.journal.pending) в журнал
+bool db_journal_append(Vault& vault);
+
+// Применяет журнал к только что загруженному файлу (ключом vault.key). Устаревший журнал
+// удаляется, обрезанный хвост (сбой посреди записи) отбрасывается
+void db_journal_replay(Vault& vault);
+
+// Удаляет журнал рядом с файлом хранилища после записи файла
+void db_journal_remove(const std::string& vaultPath);
+
+bool db_journal_needs_compaction(const Vault& vault);
+
+// Сохранение после правки: журнал для хранилищ v2, полная запись для остальных
+bool db_autosave(Vault& vault);
+
+#endif
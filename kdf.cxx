@@ -0,0 +1,429 @@
+#include "kdf.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "secure_arena.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// BLAKE2b (RFC 7693), без ключа
+
+namespace {
+
+constexpr uint64_t BLAKE2B_IV[8] = {0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+                                    0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+                                    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+                                    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL};
+
+constexpr uint8_t BLAKE2B_SIGMA[12][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3}};
+
+constexpr size_t BLAKE2B_BLOCK = 128;
+constexpr size_t BLAKE2B_OUT   = 64;
+
+inline uint64_t rotr64(uint64_t x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;  // Формат файла и так little-endian (put_u64), BLAKE2b - тоже
+}
+
+inline void store32(uint8_t* p, uint32_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+class Blake2b {
+   public:
+    explicit Blake2b(size_t outLen) : outLen_(outLen) {
+        memcpy(h_, BLAKE2B_IV, sizeof(h_));
+        h_[0] ^= 0x01010000ULL ^ outLen;
+    }
+
+    void update(const void* in, size_t len) {
+        const uint8_t* p = static_cast<const uint8_t*>(in);
+        while (len > 0) {
+            // Последний блок сжимается только в final: у него другой флаг
+            if (used_ == BLAKE2B_BLOCK) {
+                compress(false);
+                used_ = 0;
+            }
+            size_t n = min(len, BLAKE2B_BLOCK - used_);
+            memcpy(buffer_ + used_, p, n);
+            used_ += n;
+            p += n;
+            len -= n;
+        }
+    }
+
+    void update_u32(uint32_t v) {
+        uint8_t bytes[4];
+        store32(bytes, v);
+        update(bytes, sizeof(bytes));
+    }
+
+    void final(uint8_t* out) {
+        memset(buffer_ + used_, 0, BLAKE2B_BLOCK - used_);
+        compress(true);
+
+        uint8_t full[BLAKE2B_OUT];
+        memcpy(full, h_, sizeof(full));
+        memcpy(out, full, outLen_);
+        secure_zero(full, sizeof(full));
+    }
+
+   private:
+    void compress(bool last) {
+        counter_ += used_;
+
+        uint64_t m[16], v[16];
+        for (int i = 0; i < 16; ++i) m[i] = load64(buffer_ + i * 8);
+        for (int i = 0; i < 8; ++i) {
+            v[i]     = h_[i];
+            v[i + 8] = BLAKE2B_IV[i];
+        }
+        v[12] ^= counter_;
+        if (last) v[14] = ~v[14];
+
+        auto g = [&](int a, int b, int c, int d, uint64_t x, uint64_t y) {
+            v[a] = v[a] + v[b] + x;
+            v[d] = rotr64(v[d] ^ v[a], 32);
+            v[c] = v[c] + v[d];
+            v[b] = rotr64(v[b] ^ v[c], 24);
+            v[a] = v[a] + v[b] + y;
+            v[d] = rotr64(v[d] ^ v[a], 16);
+            v[c] = v[c] + v[d];
+            v[b] = rotr64(v[b] ^ v[c], 63);
+        };
+
+        for (int r = 0; r < 12; ++r) {
+            const uint8_t* s = BLAKE2B_SIGMA[r];
+            g(0, 4, 8, 12, m[s[0]], m[s[1]]);
+            g(1, 5, 9, 13, m[s[2]], m[s[3]]);
+            g(2, 6, 10, 14, m[s[4]], m[s[5]]);
+            g(3, 7, 11, 15, m[s[6]], m[s[7]]);
+            g(0, 5, 10, 15, m[s[8]], m[s[9]]);
+            g(1, 6, 11, 12, m[s[10]], m[s[11]]);
+            g(2, 7, 8, 13, m[s[12]], m[s[13]]);
+            g(3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+        for (int i = 0; i < 8; ++i) h_[i] ^= v[i] ^ v[i + 8];
+    }
+
+    uint64_t h_[8];
+    uint8_t  buffer_[BLAKE2B_BLOCK];
+    size_t   used_    = 0;
+    uint64_t counter_ = 0;  // Хватает для входов короче 2^64 байт
+    size_t   outLen_;
+};
+
+// Argon2id (RFC 9106)
+
+constexpr uint32_t ARGON2_VERSION     = 0x13;
+constexpr uint32_t ARGON2_TYPE_ID     = 2;
+constexpr size_t   ARGON2_BLOCK_WORDS = 128;  // Блок памяти - 1 КиБ
+constexpr uint32_t ARGON2_SYNC_POINTS = 4;    // Срезов в проходе
+constexpr size_t   ARGON2_ADDRESSES   = ARGON2_BLOCK_WORDS;
+
+struct Block {
+    uint64_t v[ARGON2_BLOCK_WORDS];
+};
+
+// H' из RFC 9106: хэш произвольной длины
+void blake2b_long(uint8_t* out, size_t outLen, const void* in, size_t inLen) {
+    uint8_t outLenBytes[4];
+    store32(outLenBytes, static_cast<uint32_t>(outLen));
+
+    if (outLen <= BLAKE2B_OUT) {
+        Blake2b h(outLen);
+        h.update(outLenBytes, sizeof(outLenBytes));
+        h.update(in, inLen);
+        h.final(out);
+        return;
+    }
+
+    uint8_t v[BLAKE2B_OUT];
+    Blake2b h(BLAKE2B_OUT);
+    h.update(outLenBytes, sizeof(outLenBytes));
+    h.update(in, inLen);
+    h.final(v);
+
+    // Из каждого промежуточного хэша берётся первая половина, последний - целиком
+    size_t pos = 0;
+    while (outLen - pos > BLAKE2B_OUT) {
+        memcpy(out + pos, v, BLAKE2B_OUT / 2);
+        pos += BLAKE2B_OUT / 2;
+        size_t  next = min(outLen - pos, BLAKE2B_OUT);
+        Blake2b round(next);
+        round.update(v, sizeof(v));
+        round.final(v);
+    }
+    memcpy(out + pos, v, outLen - pos);
+    secure_zero(v, sizeof(v));
+}
+
+inline uint64_t blamka(uint64_t x, uint64_t y) {
+    return x + y + 2 * (x & 0xffffffffULL) * (y & 0xffffffffULL);
+}
+
+inline void blamka_g(uint64_t& a, uint64_t& b, uint64_t& c, uint64_t& d) {
+    a = blamka(a, b);
+    d = rotr64(d ^ a, 32);
+    c = blamka(c, d);
+    b = rotr64(b ^ c, 24);
+    a = blamka(a, b);
+    d = rotr64(d ^ a, 16);
+    c = blamka(c, d);
+    b = rotr64(b ^ c, 63);
+}
+
+// Перестановка P над 16 словами, взятыми с шагом
+inline void permute(uint64_t* w, size_t i0, size_t step, size_t pair) {
+    auto at = [&](size_t k) -> uint64_t& { return w[i0 + (k / 2) * step + (k % 2) * pair]; };
+    blamka_g(at(0), at(4), at(8), at(12));
+    blamka_g(at(1), at(5), at(9), at(13));
+    blamka_g(at(2), at(6), at(10), at(14));
+    blamka_g(at(3), at(7), at(11), at(15));
+    blamka_g(at(0), at(5), at(10), at(15));
+    blamka_g(at(1), at(6), at(11), at(12));
+    blamka_g(at(2), at(7), at(8), at(13));
+    blamka_g(at(3), at(4), at(9), at(14));
+}
+
+// Функция сжатия G: next = P(prev ^ ref) ^ prev ^ ref, с xor - ещё и ^ старый next
+void fill_block(const Block& prev, const Block& ref, Block& next, bool withXor) {
+    Block r, z;
+    for (size_t i = 0; i < ARGON2_BLOCK_WORDS; ++i) r.v[i] = prev.v[i] ^ ref.v[i];
+    z = r;
+
+    // Строки: 8 строк по 16 слов подряд
+    for (size_t row = 0; row < 8; ++row) permute(z.v, row * 16, 2, 1);
+    // Столбцы: 8 столбцов по 2 слова, строки через 16 слов
+    for (size_t col = 0; col < 8; ++col) permute(z.v, col * 2, 16, 1);
+
+    for (size_t i = 0; i < ARGON2_BLOCK_WORDS; ++i) {
+        uint64_t value = z.v[i] ^ r.v[i];
+        next.v[i]      = withXor ? next.v[i] ^ value : value;
+    }
+}
+
+struct Argon2State {
+    Block*   memory;
+    uint32_t blocks;
+    uint32_t passes;
+    uint32_t lanes;
+    uint32_t laneLength;
+    uint32_t segmentLength;
+};
+
+// Номер опорного блока внутри полосы (RFC 9106, раздел 3.4.1.2)
+uint32_t reference_index(const Argon2State& s, uint32_t pass, uint32_t slice, uint32_t index,
+                         uint32_t pseudoRand, bool sameLane) {
+    uint32_t area;
+    if (pass == 0) {
+        if (slice == 0) {
+            area = index - 1;
+        } else if (sameLane) {
+            area = slice * s.segmentLength + index - 1;
+        } else {
+            area = slice * s.segmentLength - (index == 0 ? 1 : 0);
+        }
+    } else if (sameLane) {
+        area = s.laneLength - s.segmentLength + index - 1;
+    } else {
+        area = s.laneLength - s.segmentLength - (index == 0 ? 1 : 0);
+    }
+
+    uint64_t x        = (static_cast<uint64_t>(pseudoRand) * pseudoRand) >> 32;
+    uint64_t relative = area - 1 - ((static_cast<uint64_t>(area) * x) >> 32);
+    uint32_t start    = 0;
+    if (pass != 0 && slice != ARGON2_SYNC_POINTS - 1) start = (slice + 1) * s.segmentLength;
+    return static_cast<uint32_t>((start + relative) % s.laneLength);
+}
+
+void fill_segment(const Argon2State& s, uint32_t pass, uint32_t lane, uint32_t slice) {
+    // Argon2id: первая половина первого прохода адресуется независимо от данных
+    bool dataIndependent = pass == 0 && slice < ARGON2_SYNC_POINTS / 2;
+
+    Block zero{}, input{}, addresses{};
+    if (dataIndependent) {
+        input.v[0] = pass;
+        input.v[1] = lane;
+        input.v[2] = slice;
+        input.v[3] = s.blocks;
+        input.v[4] = s.passes;
+        input.v[5] = ARGON2_TYPE_ID;
+    }
+    auto next_addresses = [&] {
+        input.v[6]++;
+        fill_block(zero, input, addresses, false);
+        fill_block(zero, addresses, addresses, false);
+    };
+
+    uint32_t start = 0;
+    if (pass == 0 && slice == 0) {
+        start = 2;  // Первые два блока полосы заполнены из H0
+        if (dataIndependent) next_addresses();
+    }
+
+    uint32_t offset = lane * s.laneLength + slice * s.segmentLength + start;
+    for (uint32_t i = start; i < s.segmentLength; ++i, ++offset) {
+        uint32_t prev = offset % s.laneLength == 0 ? offset + s.laneLength - 1 : offset - 1;
+
+        uint64_t pseudoRand;
+        if (dataIndependent) {
+            if (i % ARGON2_ADDRESSES == 0) next_addresses();
+            pseudoRand = addresses.v[i % ARGON2_ADDRESSES];
+        } else {
+            pseudoRand = s.memory[prev].v[0];
+        }
+
+        uint32_t refLane = static_cast<uint32_t>((pseudoRand >> 32) % s.lanes);
+        if (pass == 0 && slice == 0) refLane = lane;
+        bool     sameLane = refLane == lane;
+        uint32_t refIndex = reference_index(s, pass, slice, i, static_cast<uint32_t>(pseudoRand),
+                                            sameLane);
+
+        const Block& ref = s.memory[refLane * s.laneLength + refIndex];
+        fill_block(s.memory[prev], ref, s.memory[offset], pass != 0);
+    }
+}
+
+}  // namespace
+
+bool kdf_params_valid(const KdfParams& params) {
+    return params.t_cost >= 1 && params.t_cost <= KDF_MAX_T_COST && params.lanes >= 1 &&
+           params.lanes <= KDF_MAX_LANES && params.m_cost >= 8 * params.lanes &&
+           params.m_cost <= KDF_MAX_M_COST;
+}
+
+void blake2b(const void* in, size_t inLen, uint8_t* out, size_t outLen) {
+    Blake2b h(outLen);
+    h.update(in, inLen);
+    h.final(out);
+}
+
+bool argon2id(const void* password, size_t passwordLen, const void* salt, size_t saltLen,
+              const KdfParams& params, uint8_t* out, size_t outLen, const void* secret,
+              size_t secretLen, const void* ad, size_t adLen) {
+    if (!kdf_params_valid(params) || outLen < 4 || saltLen < 8) return false;
+
+    // H0 - хэш всех входов и параметров
+    uint8_t h0[BLAKE2B_OUT + 8];
+    {
+        Blake2b h(BLAKE2B_OUT);
+        h.update_u32(params.lanes);
+        h.update_u32(static_cast<uint32_t>(outLen));
+        h.update_u32(params.m_cost);
+        h.update_u32(params.t_cost);
+        h.update_u32(ARGON2_VERSION);
+        h.update_u32(ARGON2_TYPE_ID);
+        h.update_u32(static_cast<uint32_t>(passwordLen));
+        h.update(password, passwordLen);
+        h.update_u32(static_cast<uint32_t>(saltLen));
+        h.update(salt, saltLen);
+        h.update_u32(static_cast<uint32_t>(secretLen));
+        h.update(secret, secretLen);
+        h.update_u32(static_cast<uint32_t>(adLen));
+        h.update(ad, adLen);
+        h.final(h0);
+    }
+
+    uint32_t segmentLength = params.m_cost / (ARGON2_SYNC_POINTS * params.lanes);
+    uint32_t laneLength    = segmentLength * ARGON2_SYNC_POINTS;
+
+    // Память не обнуляется: каждый блок записывается раньше, чем читается
+    uint32_t           blocks = laneLength * params.lanes;
+    unique_ptr<Block[]> memory(new Block[blocks]);
+    Argon2State state{memory.get(), blocks, params.t_cost, params.lanes, laneLength, segmentLength};
+    ThreadPool& pool = ThreadPool::shared();
+
+    // Первые два блока каждой полосы
+    pool.run(params.lanes, [&](size_t lane) {
+        uint8_t seed[sizeof(h0)];
+        memcpy(seed, h0, BLAKE2B_OUT);
+        store32(seed + BLAKE2B_OUT + 4, static_cast<uint32_t>(lane));
+        for (uint32_t j = 0; j < 2; ++j) {
+            store32(seed + BLAKE2B_OUT, j);
+            blake2b_long(reinterpret_cast<uint8_t*>(memory[lane * laneLength + j].v),
+                         sizeof(Block), seed, sizeof(seed));
+        }
+        secure_zero(seed, sizeof(seed));
+    });
+
+    // Полосы одного среза не ссылаются друг на друга: срез считается параллельно,
+    // между срезами - синхронизация
+    for (uint32_t pass = 0; pass < params.t_cost; ++pass) {
+        for (uint32_t slice = 0; slice < ARGON2_SYNC_POINTS; ++slice) {
+            pool.run(params.lanes, [&](size_t lane) {
+                fill_segment(state, pass, static_cast<uint32_t>(lane), slice);
+            });
+        }
+    }
+
+    // Итог - xor последних блоков всех полос
+    Block last = memory[laneLength - 1];
+    for (uint32_t lane = 1; lane < params.lanes; ++lane) {
+        const Block& block = memory[lane * laneLength + laneLength - 1];
+        for (size_t i = 0; i < ARGON2_BLOCK_WORDS; ++i) last.v[i] ^= block.v[i];
+    }
+    blake2b_long(out, outLen, last.v, sizeof(Block));
+
+    secure_zero(&last, sizeof(last));
+    secure_zero(h0, sizeof(h0));
+    secure_zero(memory.get(), static_cast<size_t>(blocks) * sizeof(Block));
+    return true;
+}
+
+KdfParams kdf_calibrate(chrono::milliseconds target, uint32_t lanes) {
+    if (lanes == 0) lanes = max(1u, thread::hardware_concurrency());
+    lanes = min(lanes, KDF_MAX_LANES);
+
+    KdfParams params{KDF_DEFAULT.t_cost, max<uint32_t>(KDF_CALIBRATION_START_M_COST, 8 * lanes),
+                     lanes};
+    const char    password[] = "calibration";
+    const uint8_t salt[16]   = {};
+    uint8_t       key[32];
+
+    while (true) {
+        auto start = chrono::steady_clock::now();
+        argon2id(password, sizeof(password), salt, sizeof(salt), params, key, sizeof(key));
+        double elapsed =
+            chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        double goal = static_cast<double>(target.count());
+        if (elapsed >= goal * 0.9 ||
+            (params.m_cost >= KDF_CALIBRATION_MAX_M_COST && params.t_cost >= KDF_MAX_T_COST)) {
+            break;
+        }
+
+        // Время растёт линейно и по памяти, и по проходам. Шаг ограничен, чтобы
+        // первый короткий замер не увёл далеко за цель
+        double scale = min(goal / max(elapsed, 1.0), 8.0);
+        if (params.m_cost < KDF_CALIBRATION_MAX_M_COST) {
+            double memory = min<double>(params.m_cost * scale, KDF_CALIBRATION_MAX_M_COST);
+            params.m_cost = static_cast<uint32_t>(memory) / (4 * lanes) * (4 * lanes);
+        } else {
+            double passes = min<double>(params.t_cost * scale + 0.5, KDF_MAX_T_COST);
+            params.t_cost = max(params.t_cost + 1, static_cast<uint32_t>(passes));
+        }
+    }
+    return params;
+}
@@ -0,0 +1,47 @@
+#ifndef KDF_H
+#define KDF_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Выработка ключа файла из мастер-пароля: Argon2id (RFC 9106) поверх BLAKE2b.
+// Параметры хранятся в заголовке файла, поэтому их можно поднимать со временем,
+// не ломая старые хранилища.
+struct KdfParams {
+    uint32_t t_cost = 0;  // Проходы по памяти; 0 - параметры не заданы
+    uint32_t m_cost = 0;  // Память в КиБ
+    uint32_t lanes  = 0;  // Полосы, считаются параллельно
+
+    bool argon2() const { return t_cost != 0; }
+    bool operator==(const KdfParams&) const = default;
+};
+
+// Параметры по умолчанию (RFC 9106, второй рекомендованный набор) и пределы,
+// которые принимаются из файла: больше не даём выделить чужому заголовку
+constexpr KdfParams KDF_DEFAULT    = {3, 64 * 1024, 4};
+constexpr uint32_t  KDF_MAX_T_COST = 64;
+constexpr uint32_t  KDF_MAX_M_COST = 4 * 1024 * 1024;
+constexpr uint32_t  KDF_MAX_LANES  = 64;
+
+// Калибровка: целевое время разблокировки и память, с которой начинается и до которой растёт
+constexpr auto     KDF_UNLOCK_TARGET            = std::chrono::milliseconds(500);
+constexpr uint32_t KDF_CALIBRATION_START_M_COST = 16 * 1024;
+constexpr uint32_t KDF_CALIBRATION_MAX_M_COST   = 512 * 1024;
+
+bool kdf_params_valid(const KdfParams& params);
+
+void blake2b(const void* in, size_t inLen, uint8_t* out, size_t outLen);
+
+// Argon2id v1.3. Полосы считаются на ThreadPool::shared(). secret и ad - необязательные
+// ключ и связанные данные из RFC 9106. false - параметры вне допустимых пределов.
+bool argon2id(const void* password, size_t passwordLen, const void* salt, size_t saltLen,
+              const KdfParams& params, uint8_t* out, size_t outLen, const void* secret = nullptr,
+              size_t secretLen = 0, const void* ad = nullptr, size_t adLen = 0);
+
+// Подбирает параметры, при которых выработка ключа на этой машине занимает около target:
+// при KDF_DEFAULT.t_cost проходах растёт память до KDF_CALIBRATION_MAX_M_COST, после этого -
+// число проходов. lanes = 0 - по числу ядер: чем больше ядер, тем больше памяти успеваем пройти.
+KdfParams kdf_calibrate(std::chrono::milliseconds target = KDF_UNLOCK_TARGET, uint32_t lanes = 0);
+
+#endif
@@ -0,0 +1,171 @@
+#include "lz_codec.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t MIN_MATCH    = 4;
+constexpr size_t MAX_OFFSET   = 65535;
+constexpr size_t END_LITERALS = 5;   // Последние байты входа всегда идут литералами
+constexpr size_t MATCH_LIMIT  = 12;  // Совпадение не начинается ближе к концу входа
+constexpr int    HASH_BITS    = 14;
+
+inline uint32_t load32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t hash4(const uint8_t* p) {
+    return (load32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Длина общего начала a и b, не дальше end (a < b). Сравнение словами по 8 байт:
+// в little-endian первый отличающийся байт - младший ненулевой байт XOR
+inline size_t common_length(const uint8_t* a, const uint8_t* b, const uint8_t* end) {
+    const uint8_t* start = b;
+    while (b + sizeof(uint64_t) <= end) {
+        uint64_t diff = load64(a) ^ load64(b);
+        if (diff) return b - start + (countr_zero(diff) >> 3);
+        a += sizeof(uint64_t);
+        b += sizeof(uint64_t);
+    }
+    while (b < end && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return b - start;
+}
+
+// Продолжение длины, которая не поместилась в 4 бита токена: байты 255 и остаток
+uint8_t* put_length(uint8_t* op, size_t len) {
+    for (; len >= 255; len -= 255) *op++ = 255;
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+// matchLen == 0 - последняя последовательность, только литералы
+uint8_t* put_sequence(uint8_t* op, const uint8_t* literals, size_t litLen, size_t offset,
+                      size_t matchLen) {
+    size_t matchCode = matchLen ? matchLen - MIN_MATCH : 0;
+    *op++ = static_cast<uint8_t>((min<size_t>(litLen, 15) << 4) | min<size_t>(matchCode, 15));
+    if (litLen >= 15) op = put_length(op, litLen - 15);
+    memcpy(op, literals, litLen);
+    op += litLen;
+    if (!matchLen) return op;
+
+    *op++ = static_cast<uint8_t>(offset & 0xff);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    if (matchCode >= 15) op = put_length(op, matchCode - 15);
+    return op;
+}
+
+}  // namespace
+
+size_t lz_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+// Сжатые данные пишутся прямо в out, расширенную до lz_bound, и лишнее потом отрезается
+void lz_compress(const uint8_t* src, size_t size, string& out) {
+    size_t start = out.size();
+    out.resize(start + lz_bound(size));
+    uint8_t* op = reinterpret_cast<uint8_t*>(out.data()) + start;
+    uint8_t* o0 = op;
+
+    vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+    size_t           anchor = 0;
+    size_t           ip     = 0;
+    size_t           limit  = size > MATCH_LIMIT ? size - MATCH_LIMIT : 0;
+    size_t           end    = size > END_LITERALS ? size - END_LITERALS : 0;
+
+    while (ip < limit) {
+        uint32_t h   = hash4(src + ip);
+        size_t   ref = table[h];
+        table[h]     = static_cast<uint32_t>(ip);
+
+        if (ref >= ip || ip - ref > MAX_OFFSET || load32(src + ref) != load32(src + ip)) {
+            // На несжимаемых данных шаг растёт, чтобы не искать совпадение в каждом байте
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        size_t len = MIN_MATCH + common_length(src + ref + MIN_MATCH, src + ip + MIN_MATCH,
+                                               src + end);
+        while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+            --ip;
+            --ref;
+            ++len;
+        }
+
+        op = put_sequence(op, src + anchor, ip - anchor, ip - ref, len);
+        ip += len;
+        anchor = ip;
+    }
+    op = put_sequence(op, src + anchor, size - anchor, 0, 0);
+    out.resize(start + (op - o0));
+}
+
+// Поток всегда кончается последовательностью из одних литералов, хотя бы токеном,
+// поэтому пустой вход - обрезанные данные, даже при dstSize == 0
+bool lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize) {
+    if (size == 0) return false;
+
+    const uint8_t* ip   = src;
+    const uint8_t* iend = src + size;
+    uint8_t*       op   = dst;
+    uint8_t*       oend = dst + dstSize;
+
+    auto read_length = [&](size_t& len) {
+        uint8_t b;
+        do {
+            if (ip == iend) return false;
+            b = *ip++;
+            len += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t litLen = token >> 4;
+        if (litLen == 15 && !read_length(litLen)) return false;
+        if (litLen > size_t(iend - ip) || litLen > size_t(oend - op)) return false;
+        memcpy(op, ip, litLen);
+        op += litLen;
+        ip += litLen;
+        if (ip == iend) break;  // Последняя последовательность - без совпадения
+
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > size_t(op - dst)) return false;
+
+        size_t matchLen = token & 15;
+        if (matchLen == 15 && !read_length(matchLen)) return false;
+        matchLen += MIN_MATCH;
+        if (matchLen > size_t(oend - op)) return false;
+
+        // При offset < matchLen совпадение перекрывает само себя и копируется по байту
+        const uint8_t* ref = op - offset;
+        if (offset >= matchLen) {
+            memcpy(op, ref, matchLen);
+        } else {
+            for (size_t i = 0; i < matchLen; ++i) op[i] = ref[i];
+        }
+        op += matchLen;
+    }
+    return op == oend;
+}
@@ -0,0 +1,23 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Сжатие LZ77 в формате блока LZ4: последовательности {токен, литералы, смещение
+// совпадения (2 байта), продолжение длины}. Без энтропийного кодирования, поэтому
+// распаковка - только копирование и стоит меньше расшифровки тех же данных.
+// Хорошо сжимает то, что повторяется в пределах 64 КиБ: логины, домены, длины полей.
+
+// Наибольший размер сжатых данных для size байт на входе
+size_t lz_bound(size_t size);
+
+// Дописывает сжатые src в конец out
+void lz_compress(const uint8_t* src, size_t size, std::string& out);
+
+// Распаковывает ровно dstSize байт. Вход проверяется целиком: false - данные
+// повреждены или распаковываются не в dstSize байт
+bool lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize);
+
+#endif
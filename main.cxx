@@ -8,28 +8,40 @@
 #include <FL/Fl_Pixmap.H>
 #include <FL/Fl_Secret_Input.H>
 #include <FL/fl_ask.H>
+#include <FL/fl_draw.H>
 
-#include <atomic>
-#include <chrono>
+#include <algorithm>
 #include <format>
 #include <fstream>
-#include <thread>
+#include <memory>
+#include <mutex>
 
+#include "breach_corpus.h"
+#include "clipboard.h"
 #include "database.h"
+#include "entry_list.h"
+#include "entry_view.h"
 #include "hardware_key.h"
 #include "icons/add.xpm"
 #include "icons/delete.xpm"
 #include "icons/edit.xpm"
 #include "password_utils.h"
+#include "search_worker.h"
+#include "secure_arena.h"
+#include "vault_audit.h"
+#include "vault_export.h"
+#include "vault_import.h"
+#include "vault_writer.h"
 
 using namespace std;
 
-const char* const DEFAULT_DB_NAME       = "keepit.hush";
-const int         CLIPBOARD_TIMEOUT_SEC = 10;
+const char* const DEFAULT_DB_NAME            = "keepit.hush";
+const int         CLIPBOARD_TIMEOUT_SEC      = 10;
+const double      JOURNAL_CHECK_INTERVAL_SEC = 60.0;
 
 // UI Components
 Fl_Double_Window* mainWindow          = nullptr;
-Fl_Hold_Browser*  entriesBrowser      = nullptr;
+EntryList*        entriesList         = nullptr;
 Fl_Double_Window* editorWindow        = nullptr;
 Fl_Input*         titleInput          = nullptr;
 Fl_Input*         loginInput          = nullptr;
@@ -44,20 +56,38 @@ Fl_Check_Button*  hardwareKeyCheckbox   = nullptr;
 Fl_Choice*        hardwareKeyChoice     = nullptr;
 Fl_Box*           hardwareKeyStatus     = nullptr;
 Fl_Box*           clipboardTimerLabel   = nullptr;
-
-// Application State
-string g_masterPassword    = "";
-bool   g_passwordVisible   = false;
-int    g_editingEntryIndex = -1;
-
-std::atomic<bool> g_clipboardTimerActive{false};
-std::atomic<int>  g_clipboardSecondsLeft{0};
+Fl_Double_Window* auditWindow           = nullptr;
+Fl_Box*           auditSummary          = nullptr;
+Fl_Hold_Browser*  auditBrowser          = nullptr;
+
+// Application State. Мастер-пароль не хранится: после открытия остаётся только g_vault.key
+Vault             g_vault;
+bool              g_passwordVisible = false;
+uint64_t          g_editingEntryId  = 0;  // Постоянный номер редактируемой записи, 0 - новая запись
+StrengthEstimator g_strengthEstimator;    // Состояние оценки пароля в редакторе
+AuditReport       g_auditReport;          // Последняя проверка, её сохраняет Export
+BreachCorpus      g_breachCorpus;         // Файл утечек, если выбран (Database/Breach Corpus)
+
+// Изменения хранилища идут под g_vaultMutex: фоновая запись берёт с него снимки
+mutex g_vaultMutex;
+bool  g_unsavedChanges = false;  // Правки, ещё не подтверждённые g_writer
+
+void        onVaultWritten(bool saved, const string& error);
+VaultWriter g_writer(g_vault, g_vaultMutex, onVaultWritten);
+
+// Фильтр списка считается в фоне; в списке показывается только последний запрос
+void         onSearchResult(SearchResult result);
+SearchWorker g_searchWorker(g_vault, g_vaultMutex, onSearchResult);
+uint64_t     g_searchGeneration = 0;
+string       g_searchQuery;
+
+// Скопированный пароль стирается из буфера обмена через CLIPBOARD_TIMEOUT_SEC
+void      onClipboardTimer(int secondsLeft);
+Clipboard g_clipboard(CLIPBOARD_TIMEOUT_SEC, onClipboardTimer);
 
 // Forward declarations
 void updateTitle();
 void updatePasswordStrength();
-void updateClipboardTimer(void*);
-void startClipboardTimer();
 void togglePasswordVisibility(Fl_Widget*, void*);
 void generateNewPassword(Fl_Widget*, void*);
 void copyPasswordFromEditor(Fl_Widget*, void*);
@@ -69,10 +99,15 @@ void editEntry(Fl_Widget*, void*);
 void deleteEntry(Fl_Widget*, void*);
 void saveEntry(Fl_Widget*, void*);
 void showAbout(Fl_Widget*, void*);
+void auditDatabase(Fl_Widget*, void*);
+void importEntries(Fl_Widget*, void*);
+void exportEntries(Fl_Widget*, void*);
+void exportAudit(Fl_Widget*, void*);
+void chooseBreachCorpus(Fl_Widget*, void*);
 void exitApplication(Fl_Widget*, void*);
 void openDatabase(Fl_Widget*, void*);
 void tryOpenLastDatabase();
-int  findActualIndex(int displayIndex);
+int  selectedEntry();
 void toggleHardwareKey(Fl_Widget*, void*);
 void updateHardwareKeyUI();
 
@@ -84,66 +119,128 @@ void updateTitle() {
     if (!mainWindow) return;
 
     string label;
-    if (!g_currentDatabasePath.empty()) {
-        size_t lastSlash = g_currentDatabasePath.find_last_of("/\\");
-        string filename  = (lastSlash == string::npos) ? g_currentDatabasePath
-                                                       : g_currentDatabasePath.substr(lastSlash + 1);
+    if (!g_vault.path.empty()) {
+        size_t lastSlash = g_vault.path.find_last_of("/\\");
+        string filename =
+            (lastSlash == string::npos) ? g_vault.path : g_vault.path.substr(lastSlash + 1);
         label            = format("Hush - {}", filename);
     } else {
         label = format("Hush - {}", DEFAULT_DB_NAME);
     }
+    if (g_unsavedChanges) label += " *";
     mainWindow->copy_label(label.c_str());
 }
 
-void updateBrowser(const char* filter = nullptr) {
-    if (!entriesBrowser) return;
-
-    entriesBrowser->clear();
-    string filterText = filter ? filter : "";
-
-    // Add favorites first
-    for (const auto& entry : g_passwordEntries) {
-        if (entry.is_favorite &&
-            (filterText.empty() || entry.title.find(filterText) != string::npos)) {
-            string display = format("* {}", entry.title);
-            if (!entry.login.empty()) {
-                display += format("  {}", entry.login);
-            }
-            // Индикатор физического ключа
-            if (entry.requires_hardware_key) {
-                bool connected = hardware_key::is_device_connected(entry.hardware_key_fingerprint);
-                display += connected ? "  [Hardware ON]" : "  [Hardware OFF]";
-            }
-            entriesBrowser->add(display.c_str());
+// Подпись строки списка: EntryList запрашивает её только для видимых строк
+string entryLabel(uint64_t id) {
+    int index = g_vault.index_of(id);
+    if (index < 0) return "";
+
+    const auto& entry = g_vault.entries[index];
+    string      display;
+    if (entry.is_favorite) {
+        display = format("* {}", entry.title);
+        if (!entry.login.empty()) {
+            display += format("  {}", entry.login);
         }
+    } else {
+        display = format("'{}'", entry.title);
+        if (!entry.login.empty()) {
+            display += format(" - {}", entry.login);
+        }
+    }
+    // Индикатор физического ключа
+    if (entry.requires_hardware_key) {
+        bool connected = hardware_key::is_device_connected(entry.hardware_key_fingerprint);
+        display += connected ? "  [Hardware ON]" : "  [Hardware OFF]";
     }
+    return display;
+}
 
-    // Add regular entries
-    for (const auto& entry : g_passwordEntries) {
-        if (!entry.is_favorite &&
-            (filterText.empty() || entry.title.find(filterText) != string::npos)) {
-            string display = format("'{}'", entry.title);
-            if (!entry.login.empty()) {
-                display += format(" - {}", entry.login);
-            }
-            // Индикатор физического ключа
-            if (entry.requires_hardware_key) {
-                bool connected = hardware_key::is_device_connected(entry.hardware_key_fingerprint);
-                display += connected ? "  [Hardware ON]" : "  [Hardware OFF]";
-            }
-            entriesBrowser->add(display.c_str());
-        }
+// Поиск идёт в фоне, строки придут в showSearchResult
+void updateBrowser(const char* filter = nullptr) {
+    if (!entriesList) return;
+
+    g_searchQuery      = filter ? filter : "";
+    g_searchGeneration = g_searchWorker.submit(g_searchQuery);
+}
+
+void showSearchResult(void* data) {
+    unique_ptr<SearchResult> result(static_cast<SearchResult*>(data));
+    // Пока шёл поиск, набран более новый запрос
+    if (!entriesList || result->generation != g_searchGeneration) return;
+
+    // Хранилище изменилось во время поиска: индексы строк устарели, ищем заново
+    if (result->revision != g_vault.revision) {
+        if (result->complete) updateBrowser(g_searchQuery.c_str());
+        return;
     }
+    entriesList->rows(std::move(result->ids), result->revision);
+}
+
+void onSearchResult(SearchResult result) {
+    Fl::awake(showSearchResult, new SearchResult(std::move(result)));
+}
+
+// Ключ подключили или отключили: перестраиваются подписи только записей с этим ключом
+void showHardwareKeyChange(void* data) {
+    unique_ptr<vector<string>> changed(static_cast<vector<string>*>(data));
+    if (!entriesList) return;
+
+    entriesList->invalidate_labels([&](uint64_t id) {
+        int index = g_vault.index_of(id);
+        if (index < 0) return true;
+        const auto& entry = g_vault.entries[index];
+        return entry.requires_hardware_key &&
+               find(changed->begin(), changed->end(), entry.hardware_key_fingerprint) !=
+                   changed->end();
+    });
+    if (editorWindow && editorWindow->shown()) updateHardwareKeyUI();
+}
+
+void onHardwareKeyChange(const vector<string>& changed) {
+    Fl::awake(showHardwareKeyChange, new vector<string>(changed));
 }
 
 void search(Fl_Widget* widget, void*) {
     updateBrowser(((Fl_Input*)widget)->value());
 }
 
+// Правка уходит на диск в фоне: g_writer дописывает журнал и сворачивает его в файл
 void autosave() {
-    if (!g_currentDatabasePath.empty() && !g_masterPassword.empty()) {
-        db_save_file(g_currentDatabasePath, g_masterPassword);
+    if (g_vault.path.empty()) return;
+
+    g_unsavedChanges = true;
+    updateTitle();
+    g_writer.schedule();
+}
+
+// Результат фоновой записи передаётся в поток GUI через Fl::awake
+struct SaveNotice {
+    bool   saved;
+    string error;
+};
+
+void showSaveNotice(void* data) {
+    unique_ptr<SaveNotice> notice(static_cast<SaveNotice*>(data));
+    if (!notice->saved) {
+        fl_alert("%s", notice->error.c_str());
+        return;
     }
+    if (g_writer.idle()) {
+        g_unsavedChanges = false;
+        updateTitle();
+    }
+}
+
+void onVaultWritten(bool saved, const string& error) {
+    Fl::awake(showSaveNotice, new SaveNotice{saved, error});
+}
+
+// Журнал сворачивается и по возрасту, даже если правок давно не было
+void compactJournalTimer(void*) {
+    if (!g_vault.path.empty()) g_writer.schedule();
+    Fl::repeat_timeout(JOURNAL_CHECK_INTERVAL_SEC, compactJournalTimer);
 }
 
 void saveDatabase(Fl_Widget*, void*) {
@@ -165,8 +262,23 @@ void saveDatabase(Fl_Widget*, void*) {
         return;
     }
 
-    g_masterPassword = password;
-    if (db_save_file(file, password)) {
+    // Новый пароль - новые параметры Argon2id, подобранные под эту машину, и новый ключ.
+    // Калибровка и выработка ключа занимают около секунды, поэтому идут до захвата хранилища
+    fl_cursor(FL_CURSOR_WAIT);
+    Fl::check();
+    VaultKeyPtr key = VaultKey::generate(password, kdf_calibrate());
+    fl_cursor(FL_CURSOR_DEFAULT);
+
+    g_writer.flush();
+    lock_guard<mutex> lock(g_vaultMutex);
+    if (!db_set_key(g_vault, std::move(key))) {
+        fl_alert("Failed to save database: some passwords could not be decrypted.\n"
+                 "The database may be damaged; nothing was written.");
+        return;
+    }
+    if (db_save_file(g_vault, file)) {
+        g_unsavedChanges = false;
+        save_last_db_path(g_vault.path);
         updateTitle();
     } else {
         fl_alert("Failed to save database.");
@@ -174,17 +286,45 @@ void saveDatabase(Fl_Widget*, void*) {
 }
 
 bool databaseExists() {
-    if (!g_currentDatabasePath.empty()) return true;
+    if (!g_vault.path.empty()) return true;
 
     int choice = fl_choice("No database is open. Would you like to create a new one?", "Cancel",
                            "New", nullptr);
     if (choice == 1) {
         saveDatabase(nullptr, nullptr);
-        return !g_currentDatabasePath.empty();
+        return !g_vault.path.empty();
     }
     return false;
 }
 
+// Хранилища старого формата переписываются целиком при каждом сохранении.
+// Миграция вырабатывает новый ключ, поэтому нужен пароль, которым файл только что открыт
+void offerMigration(const string& password) {
+    if (g_vault.layout.version != VAULT_FORMAT_V1) return;
+
+    int choice = fl_choice(
+        "This database uses the old file format, which is rewritten completely on every "
+        "change.\nUpgrade it to the block format? Older versions of Hush will not open it.",
+        "Later", "Upgrade", nullptr);
+    if (choice != 1) return;
+
+    lock_guard<mutex> lock(g_vaultMutex);
+    if (!db_migrate_file(g_vault, g_vault.path, password)) {
+        fl_alert("Failed to upgrade database.");
+    }
+}
+
+// Файл загружается во временное хранилище без блокировки: выработка ключа занимает до
+// секунды, и фоновый поиск не должен её ждать. В g_vault оно переносится под g_vaultMutex
+bool loadVault(const string& path, const string& password) {
+    Vault loaded;
+    if (!db_load_file(loaded, path, password)) return false;
+
+    lock_guard<mutex> lock(g_vaultMutex);
+    g_vault = std::move(loaded);
+    return true;
+}
+
 void openDatabase(Fl_Widget*, void*) {
     const char* file = fl_file_chooser("Open database", "*.hush", nullptr);
     if (!file) return;
@@ -202,10 +342,13 @@ void openDatabase(Fl_Widget*, void*) {
 
         string password = passwordPtr;
 
-        if (db_load_file(file, password)) {
-            g_masterPassword = password;
+        g_writer.flush();
+        if (loadVault(file, password)) {
+            g_unsavedChanges = false;
+            save_last_db_path(g_vault.path);
             updateBrowser();
             updateTitle();
+            offerMigration(password);
             return;
         } else {
             int choice = fl_choice("Incorrect password. Try again?", "Cancel", "Retry", nullptr);
@@ -231,10 +374,12 @@ void tryOpenLastDatabase() {
 
             string password = passwordPtr;
 
-            if (db_load_file(lastDb, password)) {
-                g_masterPassword = password;
+            g_writer.flush();
+            if (loadVault(lastDb, password)) {
+                g_unsavedChanges = false;
                 updateBrowser();
                 updateTitle();
+                offerMigration(password);
                 return;
             } else {
                 int retryChoice =
@@ -253,11 +398,13 @@ void tryOpenLastDatabase() {
 void updatePasswordStrength() {
     if (!passwordInput || !strengthIndicator) return;
 
-    string password     = passwordInput->value();
-    int    strength     = password_utils::password_strength(password);
-    string strengthText = password_utils::password_strength_text(strength);
-    string label        = format("Strength: {} ({}%)", strengthText, strength);
+    // Оценщик пересчитывает только изменённый хвост пароля, а не весь на каждое нажатие
+    const StrengthResult& result       = g_strengthEstimator.update(passwordInput->value());
+    int                   strength     = result.percent;
+    string                strengthText = password_utils::password_strength_text(strength);
+    string                label        = format("Strength: {} ({}%)", strengthText, strength);
     strengthIndicator->copy_label(label.c_str());
+    strengthIndicator->copy_tooltip(result.warning.empty() ? nullptr : result.warning.c_str());
 
     if (strength < 40) {
         strengthIndicator->labelcolor(FL_RED);
@@ -269,56 +416,19 @@ void updatePasswordStrength() {
     strengthIndicator->redraw();
 }
 
-void updateClipboardTimer(void*) {
+void onClipboardTimer(int secondsLeft) {
     if (!clipboardTimerLabel) return;
 
-    int seconds = g_clipboardSecondsLeft.load();
-    if (seconds > 0) {
-        string label = format("Clipboard clears in {}s", seconds);
+    if (secondsLeft > 0) {
+        string label = format("Clipboard clears in {}s", secondsLeft);
         clipboardTimerLabel->copy_label(label.c_str());
         clipboardTimerLabel->show();
         clipboardTimerLabel->redraw();
     } else {
         clipboardTimerLabel->hide();
-        g_clipboardTimerActive = false;
-    }
-
-    if (g_clipboardTimerActive) {
-        Fl::repeat_timeout(1.0, updateClipboardTimer);
     }
 }
 
-void startClipboardTimer() {
-    g_clipboardSecondsLeft = CLIPBOARD_TIMEOUT_SEC;
-    g_clipboardTimerActive = true;
-
-    if (clipboardTimerLabel) {
-        string label = format("Clipboard clears in {}s", CLIPBOARD_TIMEOUT_SEC);
-        clipboardTimerLabel->copy_label(label.c_str());
-        clipboardTimerLabel->show();
-        clipboardTimerLabel->redraw();
-    }
-
-    Fl::add_timeout(1.0, updateClipboardTimer);
-
-    thread([]() {
-        while (g_clipboardSecondsLeft > 0 && g_clipboardTimerActive) {
-            this_thread::sleep_for(chrono::seconds(1));
-            g_clipboardSecondsLeft--;
-        }
-
-        if (g_clipboardTimerActive) {
-            password_utils::clear_clipboard();
-            g_clipboardTimerActive = false;
-            Fl::awake(
-                [](void*) {
-                    if (clipboardTimerLabel) clipboardTimerLabel->hide();
-                },
-                nullptr);
-        }
-    }).detach();
-}
-
 void togglePasswordVisibility(Fl_Widget*, void*) {
     if (!passwordInput) return;
     g_passwordVisible = !g_passwordVisible;
@@ -349,20 +459,18 @@ void copyPasswordFromEditor(Fl_Widget*, void*) {
         fl_alert("No password to copy.");
         return;
     }
-    password_utils::copy_to_clipboard(password);
-    startClipboardTimer();
+    g_clipboard.copy(password);
 }
 
 void copyPasswordFromBrowser(Fl_Widget*, void*) {
-    int displayIndex = entriesBrowser->value();
-    if (displayIndex <= 0) {
+    if (entriesList->value() <= 0) {
         fl_alert("Please select an entry.");
         return;
     }
 
-    int actualIndex = findActualIndex(displayIndex);
+    int actualIndex = selectedEntry();
     if (actualIndex >= 0) {
-        const auto& entry = g_passwordEntries[actualIndex];
+        const auto& entry = g_vault.entries[actualIndex];
 
         // Проверяем наличие физического ключа
         if (entry.requires_hardware_key && !entry.hardware_key_fingerprint.empty()) {
@@ -372,51 +480,49 @@ void copyPasswordFromBrowser(Fl_Widget*, void*) {
             }
         }
 
-        password_utils::copy_to_clipboard(entry.password);
-        startClipboardTimer();
-    }
-}
-
-int findActualIndex(int displayIndex) {
-    int actualIndex    = 0;
-    int currentDisplay = 1;
-
-    // Search in favorites
-    for (size_t i = 0; i < g_passwordEntries.size(); ++i) {
-        if (g_passwordEntries[i].is_favorite) {
-            if (currentDisplay == displayIndex) return i;
-            currentDisplay++;
+        // Расшифровывается только пароль этой записи. Ключ хранилища меняет фоновая
+        // запись, поэтому под блокировкой
+        string password;
+        bool   revealed;
+        {
+            lock_guard<mutex> lock(g_vaultMutex);
+            revealed = g_vault.reveal_password(actualIndex, password);
         }
-    }
-
-    // Search in regular entries
-    for (size_t i = 0; i < g_passwordEntries.size(); ++i) {
-        if (!g_passwordEntries[i].is_favorite) {
-            if (currentDisplay == displayIndex) return i;
-            currentDisplay++;
+        if (!revealed) {
+            fl_alert("Failed to decrypt the password. The database may be damaged.");
+            return;
         }
+
+        g_clipboard.copy(password);
+        secure_wipe(password);
     }
+}
 
-    return -1;
+// Строка списка хранит постоянный номер записи, поэтому выбор верен и под фильтром
+int selectedEntry() {
+    return g_vault.index_of(entriesList->entry(entriesList->value()));
 }
 
 void createNewDatabase(Fl_Widget*, void*) {
-    if (!g_currentDatabasePath.empty()) {
+    if (!g_vault.path.empty()) {
         int choice =
             fl_choice("Current database will be closed. Continue?", "Cancel", "Continue", nullptr);
         if (choice != 1) return;
     }
 
-    g_passwordEntries.clear();
-    g_currentDatabasePath = "";
-    g_masterPassword      = "";
+    g_writer.flush();
+    {
+        lock_guard<mutex> lock(g_vaultMutex);
+        g_vault.clear();
+    }
+    g_unsavedChanges = false;
     updateBrowser();
     saveDatabase(nullptr, nullptr);
 }
 
 void addEntry(Fl_Widget*, void*) {
     if (!databaseExists()) return;
-    g_editingEntryIndex = -1;
+    g_editingEntryId = 0;
     titleInput->value("");
     loginInput->value("");
     passwordInput->value("");
@@ -429,29 +535,40 @@ void addEntry(Fl_Widget*, void*) {
 
 void editEntry(Fl_Widget*, void*) {
     if (!databaseExists()) return;
-    int displayIndex = entriesBrowser->value();
-    if (displayIndex <= 0) {
+    if (entriesList->value() <= 0) {
         fl_alert("Please select an entry to edit.");
         return;
     }
 
-    int actualIndex = findActualIndex(displayIndex);
+    int actualIndex = selectedEntry();
     if (actualIndex < 0) return;
 
-    g_editingEntryIndex  = actualIndex;
-    PasswordEntry& entry = g_passwordEntries[actualIndex];
+    const EntryRef& ref = g_vault.entries[actualIndex];
+    g_editingEntryId    = ref.id;
 
-    // Проверяем наличие физического ключа при редактировании
-    if (entry.requires_hardware_key && !entry.hardware_key_fingerprint.empty()) {
-        if (!hardware_key::is_device_connected(entry.hardware_key_fingerprint)) {
+    // Проверяем наличие физического ключа при редактировании, до расшифровки пароля
+    if (ref.requires_hardware_key && !ref.hardware_key_fingerprint.empty()) {
+        if (!hardware_key::is_device_connected(ref.hardware_key_fingerprint)) {
             fl_alert("Hardware key is required but not connected!");
             return;
         }
     }
 
+    PasswordEntry entry;
+    bool          revealed;
+    {
+        lock_guard<mutex> lock(g_vaultMutex);
+        revealed = g_vault.reveal(actualIndex, entry);
+    }
+    if (!revealed) {
+        fl_alert("Failed to decrypt the password. The database may be damaged.");
+        return;
+    }
+
     titleInput->value(entry.title.c_str());
     loginInput->value(entry.login.c_str());
     passwordInput->value(entry.password.c_str());
+    secure_wipe(entry.password);  // Дальше пароль есть только в поле редактора
     favoriteCheckbox->value(entry.is_favorite ? 1 : 0);
     hardwareKeyCheckbox->value(entry.requires_hardware_key ? 1 : 0);
     updateHardwareKeyUI();
@@ -462,17 +579,19 @@ void editEntry(Fl_Widget*, void*) {
 
 void deleteEntry(Fl_Widget*, void*) {
     if (!databaseExists()) return;
-    int displayIndex = entriesBrowser->value();
-    if (displayIndex <= 0) {
+    if (entriesList->value() <= 0) {
         fl_alert("Error! Attempt to delete non-existing entry.");
         return;
     }
 
     if (fl_choice("Are you sure you want to delete this entry?", "Cancel", "Delete", nullptr) ==
         1) {
-        int actualIndex = findActualIndex(displayIndex);
+        int actualIndex = selectedEntry();
         if (actualIndex >= 0) {
-            g_passwordEntries.erase(g_passwordEntries.begin() + actualIndex);
+            {
+                lock_guard<mutex> lock(g_vaultMutex);
+                g_vault.remove(actualIndex);
+            }
             updateBrowser(searchInput->value());
             autosave();
         }
@@ -546,11 +665,28 @@ void saveEntry(Fl_Widget*, void*) {
         entry.hardware_key_fingerprint = "";
     }
 
-    if (g_editingEntryIndex >= 0) {
-        g_passwordEntries[g_editingEntryIndex] = entry;
-    } else {
-        g_passwordEntries.push_back(entry);
+    // Пароль из известной утечки сохраняется только после подтверждения
+    if (uint32_t seen = g_breachCorpus.check(entry.password)) {
+        string prompt = format("This password appears in {} known data breaches.\nSave it anyway?",
+                               seen);
+        if (fl_choice("%s", "Cancel", "Save", nullptr, prompt.c_str()) != 1) {
+            secure_wipe(entry.password);
+            return;
+        }
+    }
+
+    {
+        lock_guard<mutex> lock(g_vaultMutex);
+        // Запись могли удалить, пока открыт редактор: тогда правка сохраняется новой записью
+        int index = g_vault.index_of(g_editingEntryId);
+        if (index >= 0) {
+            g_vault.update(index, entry);
+        } else {
+            g_vault.add(entry);
+        }
     }
+    // Пароль скопирован в закреплённый пул хранилища, копия в куче не нужна
+    secure_wipe(entry.password);
 
     updateBrowser(searchInput->value());
     editorWindow->hide();
@@ -566,9 +702,146 @@ void showAbout(Fl_Widget*, void*) {
         "Made by Roman Sokolovsky, Ruslan Kutorgin.");
 }
 
+// Строка отчёта: название, логин, стойкость и найденные проблемы через табуляцию
+string auditLine(const AuditFinding& finding) {
+    string issues;
+    auto   add = [&](const string& issue) {
+        if (!issues.empty()) issues += ", ";
+        issues += issue;
+    };
+    if (finding.unreadable) add("cannot decrypt");
+    if (finding.breached) add(format("found in {} breaches", finding.breached));
+    if (finding.weak()) add(finding.warning.empty() ? "weak" : format("weak: {}", finding.warning));
+    if (finding.reuse_group) {
+        add(format("reused in {} more (group {})", finding.reused_with, finding.reuse_group));
+    }
+    if (finding.duplicate_group) add(format("duplicate (group {})", finding.duplicate_group));
+
+    string strength = finding.unreadable ? "-" : format("{}%", finding.strength);
+    return format("{}\t{}\t{}\t{}", finding.title, finding.login, strength, issues);
+}
+
+// Проверка идёт под g_vaultMutex: на 100 тысячах записей она занимает доли секунды
+void auditDatabase(Fl_Widget*, void*) {
+    if (!databaseExists()) return;
+
+    fl_cursor(FL_CURSOR_WAIT);
+    Fl::check();
+    {
+        lock_guard<mutex> lock(g_vaultMutex);
+        g_auditReport = db_audit(g_vault.entries, g_vault.key.get(), &g_breachCorpus);
+    }
+    fl_cursor(FL_CURSOR_DEFAULT);
+
+    const AuditReport& report = g_auditReport;
+
+    string summary =
+        format("{} entries checked in {:.0f} ms: {} weak, {} reused in {} groups, "
+               "{} duplicated in {} groups",
+               report.entries, report.elapsed_ms, report.weak, report.reused,
+               report.reuse_groups, report.duplicates, report.duplicate_groups);
+    if (g_breachCorpus.is_open()) summary += format(", {} found in breaches", report.breached);
+    if (report.unreadable) summary += format(", {} cannot be decrypted", report.unreadable);
+    auditSummary->copy_label(summary.c_str());
+
+    auditBrowser->clear();
+    for (const auto& finding : report.findings) auditBrowser->add(auditLine(finding).c_str());
+    auditWindow->show();
+}
+
+void exportAudit(Fl_Widget*, void*) {
+    const char* file = fl_file_chooser("Export audit", "*.csv", "hush-audit.csv");
+    if (!file) return;
+    if (!db_export_audit(g_auditReport, file)) fl_alert("Failed to export audit report.");
+}
+
+// Импорт идёт пачками под g_vaultMutex, поэтому фоновый поиск и запись не ждут его целиком
+void importEntries(Fl_Widget*, void*) {
+    if (!databaseExists()) return;
+
+    const char* file = fl_file_chooser("Import entries", "*.{csv,xml,json}", nullptr);
+    if (!file) return;
+    ifstream in(file, ios::binary);
+    if (!in) {
+        fl_alert("Failed to open %s", file);
+        return;
+    }
+
+    fl_cursor(FL_CURSOR_WAIT);
+    Fl::check();
+    ImportReport report = db_import(g_vault, g_vaultMutex, in);
+    fl_cursor(FL_CURSOR_DEFAULT);
+
+    if (report.imported) {
+        updateBrowser(searchInput->value());
+        autosave();
+    }
+
+    string summary = format("{} entries imported from {} export", report.imported,
+                            db_import_format_name(report.format));
+    if (report.duplicates) summary += format(", {} duplicates skipped", report.duplicates);
+    if (report.untitled) summary += format(", {} without a title skipped", report.untitled);
+    if (!report.error.empty()) {
+        fl_alert("%s.\nThe export is damaged: %s", summary.c_str(), report.error.c_str());
+    } else {
+        fl_message("%s.", summary.c_str());
+    }
+}
+
+// Выгрузка пишется потоком под g_vaultMutex; формат - по расширению выбранного файла
+void exportEntries(Fl_Widget*, void*) {
+    if (!databaseExists()) return;
+
+    const char* file = fl_file_chooser("Export entries", "*.{csv,json}", "hush-export.csv");
+    if (!file) return;
+    if (g_vault.path == file) {
+        fl_alert("Choose a file other than the open database.");
+        return;
+    }
+    if (fl_choice("The export contains every password in plain text.\n"
+                  "Anyone who can read %s will see them.",
+                  "Cancel", "Export", nullptr, file) != 1) {
+        return;
+    }
+
+    fl_cursor(FL_CURSOR_WAIT);
+    Fl::check();
+    bool exported;
+    {
+        lock_guard<mutex> lock(g_vaultMutex);
+        exported = db_export(g_vault.entries, g_vault.key.get(), file, db_export_format_for(file));
+    }
+    fl_cursor(FL_CURSOR_DEFAULT);
+
+    if (!exported) fl_alert("Failed to export entries to %s", file);
+}
+
+// Файл собирается из выгрузки SHA-1 утилитой breach_compile; отмена выбора отключает проверку
+void chooseBreachCorpus(Fl_Widget*, void*) {
+    const char* file = fl_file_chooser("Breach corpus", "*.hbc", g_breachCorpus.path().c_str());
+    if (!file) {
+        if (g_breachCorpus.is_open() &&
+            fl_choice("Stop checking passwords against %s?", "Keep", "Stop", nullptr,
+                      g_breachCorpus.path().c_str()) == 1) {
+            g_breachCorpus.close();
+            save_breach_corpus_path("");
+        }
+        return;
+    }
+
+    if (!g_breachCorpus.open(file)) {
+        fl_alert("Failed to open breach corpus. Build it with breach_compile.");
+        save_breach_corpus_path("");
+        return;
+    }
+    save_breach_corpus_path(file);
+    fl_message("%llu breached password hashes loaded.",
+               static_cast<unsigned long long>(g_breachCorpus.size()));
+}
+
 void exitApplication(Fl_Widget*, void*) {
-    g_clipboardTimerActive = false;
-    password_utils::clear_clipboard();
+    g_writer.flush();
+    g_clipboard.clear();
     exit(0);
 }
 
@@ -616,12 +889,35 @@ int main(int argc, char** argv) {
     editorWindow->end();
     editorWindow->set_modal();
 
+    // Отчёт проверки: записи с проблемами, самые слабые сверху
+    static const int auditColumns[] = {150, 130, 50, 0};
+    auditWindow                     = new Fl_Double_Window(640, 400, "Vault Audit");
+    auditSummary                    = new Fl_Box(10, 5, 620, 30, "");
+    auditSummary->align(FL_ALIGN_LEFT | FL_ALIGN_INSIDE | FL_ALIGN_WRAP);
+    auditSummary->labelsize(12);
+
+    auditBrowser = new Fl_Hold_Browser(10, 40, 620, 315);
+    auditBrowser->column_widths(auditColumns);
+    auditBrowser->format_char(0);  // Названия и логины с @ выводятся как есть
+
+    Fl_Button* exportAuditBtn = new Fl_Button(450, 365, 85, 25, "Export...");
+    exportAuditBtn->callback(exportAudit);
+    Fl_Button* closeAuditBtn = new Fl_Button(545, 365, 85, 25, "Close");
+    closeAuditBtn->callback([](Fl_Widget*, void*) { auditWindow->hide(); });
+
+    auditWindow->resizable(auditBrowser);
+    auditWindow->end();
+
     mainWindow = new Fl_Double_Window(480, 320, "Hush - no database");
 
     Fl_Menu_Bar* menu = new Fl_Menu_Bar(0, 0, 480, 25);
     menu->add("&Database/&New       ", FL_META + 'n', createNewDatabase);
     menu->add("&Database/&Open      ", FL_META + 'o', openDatabase);
     menu->add("&Database/&Save As   ", FL_META + 's', saveDatabase);
+    menu->add("&Database/&Import...  ", FL_META + 'i', importEntries);
+    menu->add("&Database/&Export...  ", 0, exportEntries);
+    menu->add("&Database/A&udit...  ", FL_META + 'u', auditDatabase);
+    menu->add("&Database/&Breach Corpus...", 0, chooseBreachCorpus);
     menu->add("&Database/&Quit      ", FL_META + 'q', exitApplication);
     menu->add("&Entry/&Add       ", FL_META + FL_SHIFT + 'n', addEntry);
     menu->add("&Entry/&Edit      ", FL_META + 'e', editEntry);
@@ -645,9 +941,7 @@ int main(int argc, char** argv) {
     searchInput->when(FL_WHEN_CHANGED);
     toolbar->end();
 
-    entriesBrowser      = new Fl_Hold_Browser(0, 50, 480, 245);
-    static int widths[] = {250, 0};
-    entriesBrowser->column_widths(widths);
+    entriesList = new EntryList(0, 50, 480, 245, entryLabel);
 
     clipboardTimerLabel = new Fl_Box(0, 295, 480, 25, "");
     clipboardTimerLabel->align(FL_ALIGN_CENTER | FL_ALIGN_INSIDE);
@@ -657,11 +951,19 @@ int main(int argc, char** argv) {
     clipboardTimerLabel->color(FL_BACKGROUND_COLOR);
     clipboardTimerLabel->hide();
 
-    mainWindow->resizable(entriesBrowser);
+    mainWindow->resizable(entriesList);
     mainWindow->end();
     mainWindow->show(argc, argv);
 
+    // Фоновые потоки (запись хранилища, поиск, hotplug ключей) будят GUI через Fl::awake.
+    // Блокировка включается до того, как их может запустить открытие последнего хранилища
+    Fl::lock();
+
+    string breachCorpusPath = get_breach_corpus_path();
+    if (!breachCorpusPath.empty()) g_breachCorpus.open(breachCorpusPath);
     tryOpenLastDatabase();
+    Fl::add_timeout(JOURNAL_CHECK_INTERVAL_SEC, compactJournalTimer);
 
+    hardware_key::device_table().set_listener(onHardwareKeyChange);
     return Fl::run();
 }
@@ -0,0 +1,136 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#ifndef NOMINMAX
+#define NOMINMAX  // windows.h иначе определяет макросы min и max
+#endif
+#include <windows.h>
+#endif
+
+// Файл, отображённый в память с копированием при записи (MAP_PRIVATE).
+// Запись в data() меняет только нашу копию страниц, файл на диске не трогается,
+// поэтому хранилище можно расшифровывать прямо на месте.
+// Без mmap (Windows) файл читается в один буфер того же размера.
+//
+// readOnly - только чтение: страницы подгружаются при обращении и не копируются, так
+// отображаются справочные файлы больше памяти (в Windows тоже, через MapViewOfFile).
+class MappedFile {
+   public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, bool readOnly = false) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+
+        size_      = static_cast<size_t>(st.st_size);
+        int   prot = readOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* addr = mmap(nullptr, size_, prot, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<uint8_t*>(addr);
+        return true;
+#else
+        if (readOnly) return map_view(path);
+
+        std::ifstream is(path, std::ios::binary | std::ios::ate);
+        if (!is) return false;
+        std::streamoff len = is.tellg();
+        if (len <= 0) return false;
+
+        buffer_.reset(new uint8_t[len]);
+        is.seekg(0);
+        if (!is.read(reinterpret_cast<char*>(buffer_.get()), len)) {
+            buffer_.reset();
+            return false;
+        }
+        data_ = buffer_.get();
+        size_ = static_cast<size_t>(len);
+        return true;
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (data_) munmap(data_, size_);
+#else
+        if (view_) UnmapViewOfFile(data_);
+        buffer_.reset();
+        view_ = false;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    // Обращения вразнобой: ядро не читает страницы наперёд
+    void advise_random() const {
+#ifndef _WIN32
+        if (data_) madvise(data_, size_, MADV_RANDOM);
+#endif
+    }
+
+    uint8_t* data() const { return data_; }
+    size_t   size() const { return size_; }
+
+   private:
+#ifdef _WIN32
+    bool map_view(const std::string& path) {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER len;
+        HANDLE        mapping = nullptr;
+        if (GetFileSizeEx(file, &len) && len.QuadPart > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        CloseHandle(file);
+        if (!mapping) return false;
+
+        // Отображение держит файл открытым и после закрытия дескрипторов
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view) return false;
+
+        data_ = static_cast<uint8_t*>(view);
+        size_ = static_cast<size_t>(len.QuadPart);
+        view_ = true;
+        return true;
+    }
+#endif
+
+    uint8_t* data_ = nullptr;
+    size_t   size_ = 0;
+#ifdef _WIN32
+    std::unique_ptr<uint8_t[]> buffer_;
+    bool                       view_ = false;
+#endif
+};
+
+#endif
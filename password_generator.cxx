@@ -0,0 +1,144 @@
+#include "password_generator.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "secure_arena.h"
+#include "vault_format.h"
+
+#ifdef __linux__
+#include <sys/random.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const char LOWER[]   = "abcdefghijklmnopqrstuvwxyz";
+const char UPPER[]   = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+const char DIGITS[]  = "0123456789";
+const char SPECIAL[] = "!@#$%^&*()-_=+[]{}|;:,.<>?";
+
+}  // namespace
+
+// Классы политики с их минимумами и общий алфавит включённых классов
+struct PasswordGenerator::Alphabet {
+    struct Class {
+        string_view chars;
+        size_t      min;
+    };
+
+    vector<Class> classes;
+    string        all;
+    size_t        required = 0;
+
+    bool parse(const PasswordPolicy& policy) {
+        auto add = [&](bool used, string_view chars, size_t min) {
+            if (!used) return;
+            classes.push_back({chars, min});
+            all += chars;
+            required += min;
+        };
+        add(policy.use_lower, LOWER, policy.min_lower);
+        add(policy.use_upper, UPPER, policy.min_upper);
+        add(policy.use_digits, DIGITS, policy.min_digits);
+        add(policy.use_special, SPECIAL, policy.min_special);
+        return !all.empty() && policy.length > 0 && required <= policy.length;
+    }
+};
+
+PasswordGenerator::PasswordGenerator() : pool_(secure_alloc(POOL_SIZE)) {}
+
+PasswordGenerator::~PasswordGenerator() {
+    secure_free(pool_, POOL_SIZE);
+}
+
+// getrandom отдаёт до 32 МиБ за вызов, но может вернуть меньше или прерваться сигналом
+void PasswordGenerator::refill() {
+#ifdef __linux__
+    size_t filled = 0;
+    while (filled < POOL_SIZE) {
+        ssize_t n = getrandom(pool_ + filled, POOL_SIZE - filled, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            abort();
+        }
+        filled += static_cast<size_t>(n);
+    }
+#else
+    fill_random(pool_, POOL_SIZE);
+#endif
+    pos_  = 0;
+    used_ = 0;
+}
+
+uint8_t PasswordGenerator::next_byte() {
+    if (pos_ == POOL_SIZE) refill();
+    return pool_[pos_++];
+}
+
+void PasswordGenerator::wipe_used() {
+    secure_zero(pool_ + used_, pos_ - used_);
+    used_ = pos_;
+}
+
+uint32_t PasswordGenerator::uniform(uint32_t bound) {
+    // Алфавиты короче 256 символов: хватает одного байта на попытку
+    if (bound <= 256) {
+        uint32_t limit = 256 - 256 % bound;
+        uint32_t r;
+        do {
+            r = next_byte();
+        } while (r >= limit);
+        return r % bound;
+    }
+
+    uint64_t limit = (uint64_t(1) << 32) - (uint64_t(1) << 32) % bound;
+    uint64_t r;
+    do {
+        r = 0;
+        for (int i = 0; i < 4; ++i) r = r << 8 | next_byte();
+    } while (r >= limit);
+    return static_cast<uint32_t>(r % bound);
+}
+
+// Сначала обязательные символы каждого класса, затем остальные из общего алфавита,
+// и перестановка Фишера-Йетса, чтобы обязательные не стояли в начале
+void PasswordGenerator::fill(const Alphabet& alphabet, size_t length, string& password) {
+    secure_wipe(password);
+    password.reserve(length);
+    for (const auto& cls : alphabet.classes) {
+        for (size_t i = 0; i < cls.min; ++i) {
+            password += cls.chars[uniform(static_cast<uint32_t>(cls.chars.size()))];
+        }
+    }
+    while (password.size() < length) {
+        password += alphabet.all[uniform(static_cast<uint32_t>(alphabet.all.size()))];
+    }
+    if (alphabet.required > 0) {
+        for (size_t i = length - 1; i > 0; --i) {
+            swap(password[i], password[uniform(static_cast<uint32_t>(i + 1))]);
+        }
+    }
+}
+
+bool PasswordGenerator::generate(const PasswordPolicy& policy, string& password) {
+    Alphabet alphabet;
+    if (!alphabet.parse(policy)) return false;
+
+    fill(alphabet, policy.length, password);
+    wipe_used();
+    return true;
+}
+
+bool PasswordGenerator::generate_batch(const PasswordPolicy& policy, size_t count,
+                                       vector<string>& passwords) {
+    Alphabet alphabet;
+    if (!alphabet.parse(policy)) return false;
+
+    passwords.resize(count);
+    for (auto& password : passwords) fill(alphabet, policy.length, password);
+    wipe_used();
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef PASSWORD_GENERATOR_H
+#define PASSWORD_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Требования к паролю: длина и классы символов. У включённого класса можно задать
+// минимум символов; остальные позиции берутся из объединения включённых классов
+struct PasswordPolicy {
+    size_t length      = 16;
+    bool   use_lower   = true;
+    bool   use_upper   = true;
+    bool   use_digits  = true;
+    bool   use_special = true;
+    size_t min_lower   = 0;
+    size_t min_upper   = 0;
+    size_t min_digits  = 0;
+    size_t min_special = 0;
+};
+
+// Генератор паролей на системном CSPRNG (getrandom). Случайные байты берутся из ядра
+// блоками по POOL_SIZE в закреплённый буфер (secure_alloc), а не системным вызовом на
+// каждый символ. Индекс символа выбирается отбраковкой: байты из неполного последнего
+// диапазона отбрасываются, поэтому распределение по алфавиту равномерное.
+// Объект не потокобезопасен: на поток - свой генератор.
+class PasswordGenerator {
+   public:
+    static constexpr size_t POOL_SIZE = 4096;
+
+    PasswordGenerator();
+    ~PasswordGenerator();
+
+    PasswordGenerator(const PasswordGenerator&)            = delete;
+    PasswordGenerator& operator=(const PasswordGenerator&) = delete;
+
+    // false - политика невыполнима: нет ни одного класса, длина 0 или сумма минимумов
+    // больше длины
+    bool generate(const PasswordPolicy& policy, std::string& password);
+    // count паролей за один вызов: алфавит разбирается один раз на весь пакет
+    bool generate_batch(const PasswordPolicy& policy, size_t count,
+                        std::vector<std::string>& passwords);
+
+    // Равномерное число в [0, bound), bound > 0
+    uint32_t uniform(uint32_t bound);
+
+   private:
+    struct Alphabet;
+
+    void    fill(const Alphabet& alphabet, size_t length, std::string& password);
+    uint8_t next_byte();
+    void    refill();
+    // Затирает уже выданные байты: по ним восстанавливаются символы пароля
+    void wipe_used();
+
+    uint8_t* pool_;
+    size_t   pos_  = POOL_SIZE;  // Следующий невыданный байт; POOL_SIZE - буфер пуст
+    size_t   used_ = 0;          // Начало ещё не затёртых выданных байт
+};
+
+#endif
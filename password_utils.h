@@ -2,65 +2,41 @@
 #define PASSWORD_UTILS_H
 
 #include <algorithm>
-#include <random>
 #include <string>
 
+#include "password_generator.h"
+#include "strength_estimator.h"
+
 namespace password_utils {
 
-// Генерация случайного пароля
+// Генерация случайного пароля: по символу каждого включённого класса и остальные из
+// их объединения. Генератор свой у каждого потока и держит буфер системной энтропии
 inline std::string generate_password(int length = 16, bool use_upper = true, bool use_lower = true,
                                      bool use_digits = true, bool use_special = true) {
-    std::string chars;
-    if (use_lower) chars += "abcdefghijklmnopqrstuvwxyz";
-    if (use_upper) chars += "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    if (use_digits) chars += "0123456789";
-    if (use_special) chars += "!@#$%^&*()-_=+[]{}|;:,.<>?";
-
-    if (chars.empty()) chars = "abcdefghijklmnopqrstuvwxyz";
-
-    std::random_device              rd;
-    std::mt19937                    gen(rd());
-    std::uniform_int_distribution<> dis(0, chars.length() - 1);
-
-    std::string password;
-    password.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        password += chars[dis(gen)];
+    PasswordPolicy policy;
+    policy.length      = static_cast<size_t>(std::max(length, 1));
+    policy.use_lower   = use_lower || (!use_upper && !use_digits && !use_special);
+    policy.use_upper   = use_upper;
+    policy.use_digits  = use_digits;
+    policy.use_special = use_special;
+
+    size_t classes = policy.use_lower + policy.use_upper + policy.use_digits + policy.use_special;
+    if (classes <= policy.length) {
+        policy.min_lower   = policy.use_lower;
+        policy.min_upper   = policy.use_upper;
+        policy.min_digits  = policy.use_digits;
+        policy.min_special = policy.use_special;
     }
 
+    thread_local PasswordGenerator generator;
+    std::string                    password;
+    generator.generate(policy, password);
     return password;
 }
 
-// Оценка силы пароля (0-100)
+// Оценка силы пароля (0-100) по числу попыток до подбора (StrengthEstimator)
 inline int password_strength(const std::string& password) {
-    if (password.empty()) return 0;
-
-    int score = 0;
-
-    // Длина
-    if (password.length() >= 8) score += 20;
-    if (password.length() >= 12) score += 10;
-    if (password.length() >= 16) score += 10;
-
-    // Разнообразие символов
-    bool has_lower = false, has_upper = false, has_digit = false, has_special = false;
-    for (char c : password) {
-        if (islower(c))
-            has_lower = true;
-        else if (isupper(c))
-            has_upper = true;
-        else if (isdigit(c))
-            has_digit = true;
-        else
-            has_special = true;
-    }
-
-    if (has_lower) score += 15;
-    if (has_upper) score += 15;
-    if (has_digit) score += 15;
-    if (has_special) score += 15;
-
-    return std::min(score, 100);
+    return StrengthEstimator::estimate(password).percent;
 }
 
 // Описание силы пароля
@@ -70,21 +46,6 @@ inline std::string password_strength_text(int strength) {
     return "Strong";
 }
 
-// Копирование в буфер обмена (macOS)
-inline void copy_to_clipboard(const std::string& text) {
-#ifdef __APPLE__
-    std::string cmd = "echo '" + text + "' | pbcopy";
-    system(cmd.c_str());
-#endif
-}
-
-// Очистка буфера обмена (macOS)
-inline void clear_clipboard() {
-#ifdef __APPLE__
-    system("echo '' | pbcopy");
-#endif
-}
-
 }  // namespace password_utils
 
 #endif
@@ -0,0 +1,190 @@
+#include "search_index.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+// Триграмма: первый символ в старшем байте, недостающие символы в конце поля - нули
+static uint32_t byte_at(string_view s, size_t i) {
+    return i < s.size() ? static_cast<uint8_t>(s[i]) : 0;
+}
+
+void SearchIndex::collect_grams(string_view field, vector<Gram>& grams) {
+    for (size_t i = 0; i < field.size(); ++i) {
+        grams.push_back(byte_at(field, i) << 16 | byte_at(field, i + 1) << 8 |
+                        byte_at(field, i + 2));
+    }
+}
+
+void SearchIndex::grams_of(string_view title, string_view login, vector<Gram>& grams) {
+    grams.clear();
+    collect_grams(title, grams);
+    collect_grams(login, grams);
+    sort(grams.begin(), grams.end());
+    grams.erase(unique(grams.begin(), grams.end()), grams.end());
+}
+
+void SearchIndex::clear() {
+    postings_.clear();
+    indexToSlot_.clear();
+    slotToIndex_.clear();
+}
+
+// Слот больше всех уже добавленных, поэтому он дописывается в конец списков,
+// а повтор триграммы в той же записи виден по последнему элементу списка
+void SearchIndex::append_slot(uint32_t slot, string_view field, vector<GramCache>& cache) {
+    for (size_t i = 0; i < field.size(); ++i) {
+        Gram gram = byte_at(field, i) << 16 | byte_at(field, i + 1) << 8 | byte_at(field, i + 2);
+
+        // Узлы unordered_map не перемещаются, указатели на списки остаются действительными
+        GramCache& cached = cache[(gram * 2654435761u) >> 20];
+        if (cached.gram != gram) cached = {gram, &postings_[gram]};
+
+        auto& slots = *cached.slots;
+        if (slots.empty() || slots.back() != slot) slots.push_back(slot);
+    }
+}
+
+void SearchIndex::reset_slots(size_t count) {
+    indexToSlot_.resize(count);
+    slotToIndex_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        indexToSlot_[i] = static_cast<uint32_t>(i);
+        slotToIndex_[i] = static_cast<int32_t>(i);
+    }
+}
+
+void SearchIndex::add_slot(uint32_t slot, const vector<Gram>& grams) {
+    for (Gram gram : grams) {
+        auto& slots = postings_[gram];
+        // Новые записи получают самый большой слот, и вставка сводится к push_back
+        if (slots.empty() || slots.back() < slot) {
+            slots.push_back(slot);
+        } else {
+            slots.insert(lower_bound(slots.begin(), slots.end(), slot), slot);
+        }
+    }
+}
+
+void SearchIndex::remove_slot(uint32_t slot, const vector<Gram>& grams) {
+    for (Gram gram : grams) {
+        auto it = postings_.find(gram);
+        if (it == postings_.end()) continue;
+
+        auto& slots = it->second;
+        auto  pos   = lower_bound(slots.begin(), slots.end(), slot);
+        if (pos != slots.end() && *pos == slot) slots.erase(pos);
+        if (slots.empty()) postings_.erase(it);
+    }
+}
+
+void SearchIndex::insert(string_view title, string_view login) {
+    grams_of(title, login, grams_);
+
+    uint32_t slot = static_cast<uint32_t>(slotToIndex_.size());
+    slotToIndex_.push_back(static_cast<int32_t>(indexToSlot_.size()));
+    indexToSlot_.push_back(slot);
+    add_slot(slot, grams_);
+}
+
+void SearchIndex::update(size_t index, string_view oldTitle, string_view oldLogin,
+                         string_view title, string_view login) {
+    if (index >= indexToSlot_.size()) return;
+
+    vector<Gram> before, after, removed, added;
+    grams_of(oldTitle, oldLogin, before);
+    grams_of(title, login, after);
+    set_difference(before.begin(), before.end(), after.begin(), after.end(),
+                   back_inserter(removed));
+    set_difference(after.begin(), after.end(), before.begin(), before.end(),
+                   back_inserter(added));
+
+    uint32_t slot = indexToSlot_[index];
+    remove_slot(slot, removed);
+    add_slot(slot, added);
+}
+
+void SearchIndex::erase(size_t index, string_view title, string_view login) {
+    if (index >= indexToSlot_.size()) return;
+
+    vector<Gram> grams;
+    grams_of(title, login, grams);
+
+    uint32_t slot = indexToSlot_[index];
+    remove_slot(slot, grams);
+    slotToIndex_[slot] = -1;
+
+    // Записи после удалённой сдвигаются на одну позицию, их слоты остаются прежними
+    indexToSlot_.erase(indexToSlot_.begin() + index);
+    for (size_t i = index; i < indexToSlot_.size(); ++i) {
+        slotToIndex_[indexToSlot_[i]] = static_cast<int32_t>(i);
+    }
+
+    if (slotToIndex_.size() > 2 * indexToSlot_.size() + 1024) compact();
+}
+
+// Слоты удалённых записей больше не нужны: слотом снова становится индекс записи.
+// Порядок слотов совпадает с порядком записей, поэтому списки остаются отсортированными.
+void SearchIndex::compact() {
+    for (auto& [gram, slots] : postings_) {
+        for (auto& slot : slots) slot = static_cast<uint32_t>(slotToIndex_[slot]);
+    }
+
+    slotToIndex_.resize(indexToSlot_.size());
+    for (size_t i = 0; i < indexToSlot_.size(); ++i) {
+        indexToSlot_[i] = static_cast<uint32_t>(i);
+        slotToIndex_[i] = static_cast<int32_t>(i);
+    }
+}
+
+vector<uint32_t> SearchIndex::candidates(string_view text) const {
+    vector<uint32_t> result;
+    if (text.empty()) return result;
+
+    if (text.size() < GRAM) {
+        // Объединение списков всех триграмм, начинающихся с text.
+        // Различных триграмм немного (десятки тысяч), поэтому ключи просто перебираются.
+        Gram prefix = byte_at(text, 0) << 16 | byte_at(text, 1) << 8;
+        Gram mask   = text.size() == 1 ? 0xFF0000 : 0xFFFF00;
+
+        vector<bool> seen(slotToIndex_.size());
+        for (const auto& [gram, slots] : postings_) {
+            if ((gram & mask) != prefix) continue;
+            for (uint32_t slot : slots) seen[slot] = true;
+        }
+        for (uint32_t slot = 0; slot < seen.size(); ++slot) {
+            if (seen[slot]) result.push_back(static_cast<uint32_t>(slotToIndex_[slot]));
+        }
+        return result;
+    }
+
+    // Пересечение списков всех триграмм запроса, начиная с самого короткого
+    vector<Gram> grams;
+    for (size_t i = 0; i + GRAM <= text.size(); ++i) {
+        grams.push_back(byte_at(text, i) << 16 | byte_at(text, i + 1) << 8 | byte_at(text, i + 2));
+    }
+    sort(grams.begin(), grams.end());
+    grams.erase(unique(grams.begin(), grams.end()), grams.end());
+
+    vector<const vector<uint32_t>*> lists;
+    for (Gram gram : grams) {
+        auto it = postings_.find(gram);
+        if (it == postings_.end()) return result;
+        lists.push_back(&it->second);
+    }
+    sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+
+    vector<uint32_t> slots = *lists[0];
+    vector<uint32_t> next;
+    for (size_t l = 1; l < lists.size() && !slots.empty(); ++l) {
+        next.clear();
+        set_intersection(slots.begin(), slots.end(), lists[l]->begin(), lists[l]->end(),
+                         back_inserter(next));
+        slots.swap(next);
+    }
+
+    result.reserve(slots.size());
+    for (uint32_t slot : slots) result.push_back(static_cast<uint32_t>(slotToIndex_[slot]));
+    return result;
+}
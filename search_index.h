@@ -0,0 +1,80 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Триграммный индекс по названиям и логинам для фильтра в списке записей.
+// Каждая запись получает слот; слоты выдаются по возрастанию и не переиспользуются,
+// поэтому порядок слотов всегда совпадает с порядком записей в хранилище.
+// Поле дополняется нулями в конце, так что любая подстрока длиной 1-2 байта -
+// начало какой-то триграммы, а подстрока от 3 байт содержит все свои триграммы.
+// Запись не знает о Vault: поля передаются строками, entries - любым контейнером
+// с полями title и login.
+class SearchIndex {
+   public:
+    static constexpr size_t GRAM = 3;
+
+    void clear();
+
+    // Строит индекс заново по всем записям
+    template <typename Entries>
+    void assign(const Entries& entries) {
+        clear();
+        std::vector<GramCache> cache(GRAM_CACHE_SIZE);
+        uint32_t               slot = 0;
+        for (const auto& entry : entries) {
+            append_slot(slot, entry.title, cache);
+            append_slot(slot, entry.login, cache);
+            ++slot;
+        }
+        reset_slots(entries.size());
+    }
+
+    // Запись добавлена в конец хранилища
+    void insert(std::string_view title, std::string_view login);
+
+    // Запись index изменена или удалена; old* - её поля до изменения
+    void update(size_t index, std::string_view oldTitle, std::string_view oldLogin,
+                std::string_view title, std::string_view login);
+    void erase(size_t index, std::string_view title, std::string_view login);
+
+    // Индексы записей по возрастанию, в названии или логине которых может быть text.
+    // Для запросов короче GRAM ответ точный, для длинных его надо проверить.
+    // Для пустого запроса индекс не нужен: подходят все записи.
+    std::vector<uint32_t> candidates(std::string_view text) const;
+
+    size_t size() const { return indexToSlot_.size(); }
+
+   private:
+    using Gram = uint32_t;
+
+    // Кэш списков при построении: различных триграмм мало, а поиск в хэш-таблице дорог
+    struct GramCache {
+        Gram                   gram  = ~Gram(0);
+        std::vector<uint32_t>* slots = nullptr;
+    };
+    static constexpr size_t GRAM_CACHE_SIZE = 1 << 12;
+
+    static void collect_grams(std::string_view field, std::vector<Gram>& grams);
+    static void grams_of(std::string_view title, std::string_view login,
+                         std::vector<Gram>& grams);
+
+    void append_slot(uint32_t slot, std::string_view field, std::vector<GramCache>& cache);
+    void reset_slots(size_t count);
+    void add_slot(uint32_t slot, const std::vector<Gram>& grams);
+    void remove_slot(uint32_t slot, const std::vector<Gram>& grams);
+    void compact();
+
+    // Триграмма -> слоты по возрастанию
+    std::unordered_map<Gram, std::vector<uint32_t>> postings_;
+
+    std::vector<uint32_t> indexToSlot_;  // Параллельно Vault::entries
+    std::vector<int32_t>  slotToIndex_;  // -1 для удалённых записей
+    std::vector<Gram>     grams_;        // Триграммы добавляемой записи
+};
+
+#endif
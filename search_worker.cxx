@@ -0,0 +1,132 @@
+#include "search_worker.h"
+
+#include "entry_view.h"
+
+using namespace std;
+
+// Как часто поиск проверяет, не пришёл ли более новый запрос
+static constexpr size_t CANCEL_CHECK_MASK = 4095;
+
+SearchWorker::SearchWorker(const Vault& vault, mutex& vaultMutex, Listener listener)
+    : vault_(vault), vaultMutex_(vaultMutex), listener_(std::move(listener)) {}
+
+SearchWorker::~SearchWorker() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+        ++latest_;  // Отменяет идущий поиск
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+uint64_t SearchWorker::submit(const string& query) {
+    uint64_t generation;
+    {
+        lock_guard<mutex> lock(mutex_);
+        query_     = query;
+        generation = ++latest_;
+        if (!thread_.joinable()) thread_ = thread(&SearchWorker::run, this);
+    }
+    wake_.notify_one();
+    return generation;
+}
+
+void SearchWorker::run() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || latest_ != taken_; });
+        if (stopping_) break;
+
+        taken_              = latest_;
+        uint64_t generation = taken_;
+        string   query      = query_;
+        lock.unlock();
+
+        search(generation, query);
+        lock.lock();
+    }
+}
+
+// Индексы строк -> постоянные номера записей (вызывается под блокировкой хранилища)
+vector<uint64_t> SearchWorker::row_ids(const vector<int>& rows) const {
+    vector<uint64_t> ids(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) ids[i] = vault_.entries.id(rows[i]);
+    return ids;
+}
+
+void SearchWorker::emit_first_screen(uint64_t generation, const vector<int>& rows,
+                                     bool& emitted) {
+    if (emitted || rows.size() < FIRST_SCREEN_ROWS) return;
+    emitted = true;
+
+    SearchResult partial;
+    partial.generation = generation;
+    partial.revision   = vault_.revision;
+    partial.ids        = row_ids(rows);
+    listener_(std::move(partial));
+}
+
+bool SearchWorker::search(uint64_t generation, const string& query) {
+    SearchResult result;
+    result.generation = generation;
+    vector<int> rows;
+    bool        emitted = false;
+
+    {
+        lock_guard<mutex> lock(vaultMutex_);
+        const auto& entries = vault_.entries;
+        result.revision     = vault_.revision;
+
+        // Всё, что подходит под новый запрос, подходило и под тот, что в нём содержится
+        bool refine = haveLast_ && lastRevision_ == vault_.revision && !lastQuery_.empty() &&
+                      query.find(lastQuery_) != string::npos;
+
+        if (refine) {
+            // Прошлые строки уже в порядке отображения, подмножество его сохраняет
+            for (size_t i = 0; i < lastRows_.size(); ++i) {
+                if ((i & CANCEL_CHECK_MASK) == 0 && cancelled(generation)) return false;
+                if (entry_view::matches(entries, lastRows_[i], query)) {
+                    rows.push_back(lastRows_[i]);
+                    emit_first_screen(generation, rows, emitted);
+                }
+            }
+        } else if (query.empty()) {
+            // Без фильтра порядок даёт скан по битам избранного, без обхода записей
+            rows.reserve(entries.size());
+            entries.collect(true, rows);
+            entries.collect(false, rows);
+        } else {
+            vector<int> matched;
+            bool        exact      = query.size() < SearchIndex::GRAM;
+            auto        candidates = vault_.search.candidates(query);
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if ((i & CANCEL_CHECK_MASK) == 0 && cancelled(generation)) return false;
+                if (exact || entry_view::matches(entries, candidates[i], query)) {
+                    matched.push_back(static_cast<int>(candidates[i]));
+                }
+            }
+
+            // Сначала избранные, затем остальные
+            rows.reserve(matched.size());
+            for (bool favorites : {true, false}) {
+                for (size_t i = 0; i < matched.size(); ++i) {
+                    if ((i & CANCEL_CHECK_MASK) == 0 && cancelled(generation)) return false;
+                    if (entries.is_favorite(matched[i]) == favorites) {
+                        rows.push_back(matched[i]);
+                        emit_first_screen(generation, rows, emitted);
+                    }
+                }
+            }
+        }
+        result.ids = row_ids(rows);
+    }
+
+    result.complete = true;
+    lastQuery_      = query;
+    lastRevision_   = result.revision;
+    lastRows_       = std::move(rows);
+    haveLast_       = true;
+    listener_(std::move(result));
+    return true;
+}
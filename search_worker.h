@@ -0,0 +1,72 @@
+#ifndef SEARCH_WORKER_H
+#define SEARCH_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "database.h"
+
+// Строки списка для одного запроса: постоянные номера записей в порядке отображения.
+// По номерам строки находят свои записи, даже если хранилище успело измениться.
+struct SearchResult {
+    uint64_t              generation = 0;  // Номер запроса из SearchWorker::submit
+    uint64_t              revision   = 0;  // Vault::revision, по которому найдены строки
+    std::vector<uint64_t> ids;
+    bool                  complete = false;  // false - пока только первый экран
+};
+
+// Фильтрация списка в фоновом потоке. Каждый новый запрос отменяет идущий поиск.
+// Если новый запрос содержит предыдущий, а хранилище не менялось, поток уточняет
+// прошлый результат вместо поиска по всему хранилищу. Первый экран строк
+// отдаётся сразу, как только найден, полный результат - следом.
+class SearchWorker {
+   public:
+    // Вызывается из фонового потока, первый экран - ещё под блокировкой хранилища,
+    // поэтому брать vaultMutex в Listener нельзя
+    using Listener = std::function<void(SearchResult result)>;
+
+    static constexpr size_t FIRST_SCREEN_ROWS = 64;
+
+    SearchWorker(const Vault& vault, std::mutex& vaultMutex, Listener listener);
+    ~SearchWorker();
+
+    SearchWorker(const SearchWorker&)            = delete;
+    SearchWorker& operator=(const SearchWorker&) = delete;
+
+    // Ставит запрос в работу и возвращает его номер
+    uint64_t submit(const std::string& query);
+
+   private:
+    void run();
+    // false - поиск отменён более новым запросом
+    bool search(uint64_t generation, const std::string& query);
+    bool cancelled(uint64_t generation) const { return latest_ != generation; }
+    void emit_first_screen(uint64_t generation, const std::vector<int>& rows, bool& emitted);
+    std::vector<uint64_t> row_ids(const std::vector<int>& rows) const;
+
+    const Vault& vault_;
+    std::mutex&  vaultMutex_;
+    Listener     listener_;
+
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    std::thread             thread_;
+    std::string             query_;
+    std::atomic<uint64_t>   latest_{0};
+    uint64_t                taken_    = 0;  // Последний запрос, взятый потоком
+    bool                    stopping_ = false;
+
+    // Последний полный результат: из него уточняются расширенные запросы
+    std::string      lastQuery_;
+    uint64_t         lastRevision_ = 0;
+    std::vector<int> lastRows_;
+    bool             haveLast_ = false;
+};
+
+#endif
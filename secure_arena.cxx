@@ -0,0 +1,130 @@
+#include "secure_arena.h"
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+size_t page_round(size_t len) {
+#ifndef _WIN32
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    size_t page = 4096;
+#endif
+    return (len + page - 1) / page * page;
+}
+
+// Без затирания: вызывающий затёр всё, что успел записать
+void release_pages(uint8_t* p, size_t len) {
+#ifndef _WIN32
+    munlock(p, len);
+    munmap(p, len);
+#else
+    delete[] p;
+#endif
+}
+
+size_t align_up(size_t n) {
+    constexpr size_t ALIGN = alignof(max_align_t);
+    return (n + ALIGN - 1) & ~(ALIGN - 1);
+}
+
+}  // namespace
+
+void secure_zero(void* p, size_t len) {
+    static void* (*const volatile wipe)(void*, int, size_t) = memset;
+    wipe(p, 0, len);
+}
+
+void secure_wipe(string& s) {
+    secure_zero(s.data(), s.capacity());
+    s.clear();
+}
+
+// Отдельные страницы: mlock работает страницами, и соседние данные не должны
+// закреплять лишнее или делить страницу с секретами
+uint8_t* secure_alloc(size_t len) {
+    len = page_round(len);
+#ifndef _WIN32
+    void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) throw bad_alloc();
+
+    (void)mlock(p, len);
+#ifdef MADV_DONTDUMP
+    (void)madvise(p, len, MADV_DONTDUMP);
+#endif
+    return static_cast<uint8_t*>(p);
+#else
+    return new uint8_t[len];
+#endif
+}
+
+void secure_free(uint8_t* p, size_t len) {
+    if (!p) return;
+    len = page_round(len);
+    secure_zero(p, len);
+    release_pages(p, len);
+}
+
+SecureArena::~SecureArena() {
+    clear();
+}
+
+SecureArena::SecureArena(SecureArena&& other) noexcept : chunks_(std::move(other.chunks_)) {
+    other.chunks_.clear();
+}
+
+SecureArena& SecureArena::operator=(SecureArena&& other) noexcept {
+    if (this != &other) {
+        clear();
+        chunks_ = std::move(other.chunks_);
+        other.chunks_.clear();
+    }
+    return *this;
+}
+
+uint8_t* SecureArena::allocate(size_t size) {
+    size = align_up(max<size_t>(size, 1));
+    if (chunks_.empty() || chunks_.back().size - chunks_.back().used < size) {
+        // Остаток прежнего блока пропадает до clear: большие запросы редки (журнал)
+        Chunk chunk;
+        chunk.size = page_round(max(size, CHUNK_SIZE));
+        chunk.data = secure_alloc(chunk.size);
+        chunks_.push_back(chunk);
+    }
+
+    Chunk&   chunk = chunks_.back();
+    uint8_t* p     = chunk.data + chunk.used;
+    chunk.used += size;
+    return p;
+}
+
+string_view SecureArena::store(string_view s) {
+    if (s.empty()) return {};
+    uint8_t* p = allocate(s.size());
+    memcpy(p, s.data(), s.size());
+    return string_view(reinterpret_cast<const char*>(p), s.size());
+}
+
+void SecureArena::clear() {
+    for (const auto& chunk : chunks_) {
+        // Затирается только занятое: остаток блока не трогали с mmap, он и так нулевой
+        secure_zero(chunk.data, chunk.used);
+        release_pages(chunk.data, chunk.size);
+    }
+    chunks_.clear();
+}
+
+size_t SecureArena::used() const {
+    size_t total = 0;
+    for (const auto& chunk : chunks_) total += chunk.used;
+    return total;
+}
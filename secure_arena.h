@@ -0,0 +1,80 @@
+#ifndef SECURE_ARENA_H
+#define SECURE_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Память под секреты: страницы закреплены (mlock), чтобы не попасть в swap, исключены
+// из дампа процесса и перед освобождением затираются нулями. Без прав на mlock
+// (RLIMIT_MEMLOCK) память всё равно выделяется, только может уйти в swap.
+// len округляется вверх до размера страницы
+uint8_t* secure_alloc(size_t len);
+void     secure_free(uint8_t* p, size_t len);
+
+// Затирание, которое компилятор не выбросит как запись в уже ненужную память
+void secure_zero(void* p, size_t len);
+// Затирает содержимое строки (не только до size) и очищает её
+void secure_wipe(std::string& s);
+
+// Аллокатор для контейнеров с секретами (столбцы EntryTable): память от secure_alloc,
+// при росте и освобождении старый буфер затирается. Каждое выделение - целые страницы,
+// поэтому он для немногих больших буферов, а не для множества мелких строк
+template <typename T>
+struct SecureAllocator {
+    using value_type = T;
+
+    SecureAllocator() = default;
+    template <typename U>
+    SecureAllocator(const SecureAllocator<U>&) {}
+
+    T*   allocate(size_t n) { return reinterpret_cast<T*>(secure_alloc(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { secure_free(reinterpret_cast<uint8_t*>(p), n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const SecureAllocator<U>&) const {
+        return true;
+    }
+};
+
+// Пул строк хранилища: выделение - сдвиг указателя внутри закреплённого блока,
+// освобождение - только всё сразу в clear (закрытие хранилища), с затиранием.
+// Ссылки на выделенное действительны до clear и переживают перемещение пула.
+class SecureArena {
+   public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    SecureArena() = default;
+    ~SecureArena();
+
+    SecureArena(SecureArena&& other) noexcept;
+    SecureArena& operator=(SecureArena&& other) noexcept;
+
+    SecureArena(const SecureArena&)            = delete;
+    SecureArena& operator=(const SecureArena&) = delete;
+
+    // size байт с выравниванием alignof(max_align_t); больше CHUNK_SIZE - отдельным блоком
+    uint8_t* allocate(size_t size);
+
+    // Копирует s в пул и возвращает ссылку на копию
+    std::string_view store(std::string_view s);
+
+    void clear();
+
+    // Занято байт во всех блоках и число закреплённых блоков (для hush_bench)
+    size_t used() const;
+    size_t chunks() const { return chunks_.size(); }
+
+   private:
+    struct Chunk {
+        uint8_t* data = nullptr;
+        size_t   size = 0;
+        size_t   used = 0;
+    };
+
+    std::vector<Chunk> chunks_;  // Выделяется из последнего
+};
+
+#endif
@@ -0,0 +1,1102 @@
+#include "selftest.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "breach_corpus.h"
+#include "cipher.h"
+#include "database.h"
+#include "entry_table.h"
+#include "hardware_key.h"
+#include "journal.h"
+#include "kdf.h"
+#include "lz_codec.h"
+#include "password_generator.h"
+#include "secure_arena.h"
+#include "strength_estimator.h"
+#include "vault_audit.h"
+#include "vault_export.h"
+#include "vault_import.h"
+#include "vault_format.h"
+
+using namespace std;
+
+namespace {
+
+const char* const SELFTEST_PASSWORD = "selftest password";
+// Дешёвые параметры Argon2id: проверяется формат, а не стойкость ключа
+constexpr KdfParams SELFTEST_KDF = {1, 64, 1};
+
+vector<uint8_t> from_hex(const char* hex) {
+    vector<uint8_t> out;
+    for (; hex[0] && hex[1]; hex += 2) out.push_back(stoi(string(hex, 2), nullptr, 16));
+    return out;
+}
+
+bool report_check(const string& name, const char* path, bool ok) {
+    printf("{\"selftest\":\"%s\",\"path\":\"%s\",\"ok\":%s}\n", name.c_str(), path,
+           ok ? "true" : "false");
+    return ok;
+}
+
+// Временный файл хранилища; удаляется вместе со всеми файлами рядом с тем же именем
+struct TempVaultFile {
+    string path;
+
+    explicit TempVaultFile(const char* name)
+        : path((filesystem::temp_directory_path() / name).string()) {
+        cleanup();
+    }
+    ~TempVaultFile() { cleanup(); }
+
+    void cleanup() const {
+        error_code ec;
+        for (const char* suffix : {"", ".tmp", ".journal"}) {
+            filesystem::remove(path + suffix, ec);
+        }
+    }
+};
+
+vector<PasswordEntry> make_entries(size_t count, uint32_t seed) {
+    mt19937               gen(seed);
+    vector<PasswordEntry> entries(count);
+    for (size_t i = 0; i < count; ++i) {
+        entries[i].title       = "site-" + to_string(i) + "-" + to_string(gen() % 1000);
+        entries[i].login       = "user" + to_string(gen() % 100000) + "@example.com";
+        entries[i].password    = "pw" + to_string(gen());
+        entries[i].is_favorite = gen() % 7 == 0;
+        if (gen() % 20 == 0) {
+            entries[i].requires_hardware_key    = true;
+            entries[i].hardware_key_fingerprint = "0781:5567:" + to_string(gen());
+        }
+    }
+    return entries;
+}
+
+// Пароли сравниваются после расшифровки: из файла они загружаются запечатанными
+bool same_entries(const Vault& vault, const vector<PasswordEntry>& expected) {
+    if (vault.entries.size() != expected.size()) return false;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        PasswordEntry        got;
+        const PasswordEntry& want = expected[i];
+        if (!vault.reveal(i, got)) return false;
+        if (got.title != want.title || got.login != want.login || got.password != want.password ||
+            got.is_favorite != want.is_favorite ||
+            got.requires_hardware_key != want.requires_hardware_key ||
+            got.hardware_key_fingerprint != want.hardware_key_fingerprint) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Новое хранилище с ключом сеанса, как после createNewDatabase
+void fill_vault(Vault& vault, const vector<PasswordEntry>& entries) {
+    db_set_key(vault, VaultKey::generate(SELFTEST_PASSWORD, SELFTEST_KDF));
+    for (const auto& entry : entries) vault.add(entry);
+}
+
+bool reload_matches(const string& path, const vector<PasswordEntry>& expected) {
+    Vault loaded;
+    return db_load_file(loaded, path, SELFTEST_PASSWORD) && same_entries(loaded, expected);
+}
+
+// RFC 8439, 2.4.2 (ChaCha20), 2.5.2 (Poly1305) и 2.8.2 (AEAD)
+bool selftest_chacha20_poly1305(const char* path) {
+    const string sunscreen =
+        "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the "
+        "future, sunscreen would be it.";
+    bool ok = true;
+
+    vector<uint8_t> key = from_hex("000102030405060708090a0b0c0d0e0f"
+                                   "101112131415161718191a1b1c1d1e1f");
+    vector<uint8_t> nonce = from_hex("000000000000004a00000000");
+    vector<uint8_t> data(sunscreen.begin(), sunscreen.end());
+    chacha20_xor(key.data(), nonce.data(), 1, data.data(), data.size());
+    ok &= report_check("rfc8439_2.4.2_chacha20", path,
+                       data == from_hex("6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afcc"
+                                        "fd9fae0bf91b65c5524733ab8f593dabcd62b3571639d624e65152ab"
+                                        "8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc514d"
+                                        "16ccf806818ce91ab77937365af90bbf74a35be6b40b8eedf2785e42"
+                                        "874d"));
+
+    const string    forum  = "Cryptographic Forum Research Group";
+    vector<uint8_t> polKey = from_hex("85d6be7857556d337f4452fe42d506a8"
+                                      "0103808afb0db2fd4abff6af4149f51b");
+    uint8_t         tag[POLY1305_TAG_SIZE];
+    poly1305(polKey.data(), (const uint8_t*)forum.data(), forum.size(), tag);
+    ok &= report_check("rfc8439_2.5.2_poly1305", path,
+                       memcmp(tag, from_hex("a8061dc1305136c6c22b8baf0c0127a9").data(),
+                              sizeof(tag)) == 0);
+
+    vector<uint8_t> aeadKey = from_hex("808182838485868788898a8b8c8d8e8f"
+                                       "909192939495969798999a9b9c9d9e9f");
+    vector<uint8_t> aeadNonce = from_hex("070000004041424344454647");
+    vector<uint8_t> ad        = from_hex("50515253c0c1c2c3c4c5c6c7");
+    vector<uint8_t> sealed(sunscreen.begin(), sunscreen.end());
+    aead_seal(aeadKey.data(), aeadNonce.data(), ad.data(), ad.size(), sealed.data(),
+              sealed.size(), tag);
+    bool sealedOk =
+        sealed == from_hex("d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+                           "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+                           "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+                           "3ff4def08e4b7a9de576d26586cec64b6116") &&
+        memcmp(tag, from_hex("1ae10b594f09e26a7e902ecbd0600691").data(), sizeof(tag)) == 0;
+    bool opened = aead_open(aeadKey.data(), aeadNonce.data(), ad.data(), ad.size(),
+                            sealed.data(), sealed.size(), tag) &&
+                  sealed == vector<uint8_t>(sunscreen.begin(), sunscreen.end());
+    ok &= report_check("rfc8439_2.8.2_aead", path, sealedOk && opened);
+
+    // Испорченный код не должен открываться
+    tag[0] ^= 1;
+    ok &= report_check("rfc8439_2.8.2_aead_forged", path,
+                       !aead_open(aeadKey.data(), aeadNonce.data(), ad.data(), ad.size(),
+                                  sealed.data(), sealed.size(), tag));
+    return ok;
+}
+
+// Векторы RFC короче четырёх блоков и не доходят до циклов SSE2 и AVX2, поэтому
+// шифротекст и код длинного буфера на каждом ядре сравниваются со скалярными
+vector<uint8_t> seal_long_buffer() {
+    uint8_t         key[CHACHA_KEY_SIZE]     = {7};
+    uint8_t         nonce[CHACHA_NONCE_SIZE] = {9};
+    vector<uint8_t> data(3 * 8 * 64 + 100 + POLY1305_TAG_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint8_t>(i * 31);
+    size_t len = data.size() - POLY1305_TAG_SIZE;
+    aead_seal(key, nonce, nullptr, 0, data.data(), len, data.data() + len);
+    return data;
+}
+
+bool selftest_cipher_paths() {
+    bool            ok = true;
+    vector<uint8_t> reference;
+    for (CipherPath path : {CipherPath::Scalar, CipherPath::SSE2, CipherPath::AVX2}) {
+        if (!cipher_set_path(path)) continue;
+        ok &= selftest_chacha20_poly1305(cipher_path_name(path));
+        if (path == CipherPath::Scalar) {
+            reference = seal_long_buffer();
+        } else {
+            ok &= report_check("long_buffer_matches_scalar", cipher_path_name(path),
+                               seal_long_buffer() == reference);
+        }
+    }
+    cipher_set_path(cipher_best_path());
+    return ok;
+}
+
+// RFC 9106, 5.3: Argon2id с секретом и связанными данными
+bool selftest_argon2id() {
+    vector<uint8_t> password(32, 0x01);
+    vector<uint8_t> salt(16, 0x02);
+    vector<uint8_t> secret(8, 0x03);
+    vector<uint8_t> ad(12, 0x04);
+    uint8_t         tag[32];
+    bool derived = argon2id(password.data(), password.size(), salt.data(), salt.size(),
+                            KdfParams{3, 32, 4}, tag, sizeof(tag), secret.data(), secret.size(),
+                            ad.data(), ad.size());
+    return report_check("rfc9106_5.3_argon2id", "-",
+                        derived && memcmp(tag,
+                                          from_hex("0d640df58d78766c08c037a34a8b53c9"
+                                                   "d01ef0452d75b65eb52520e96b01e659")
+                                              .data(),
+                                          sizeof(tag)) == 0);
+}
+
+// Полная запись и чтение, дописывание блоков после правки и удаления, удаление
+// целого блока, неверный пароль, оборванный новый слот заголовка
+bool selftest_vault_v2() {
+    TempVaultFile file("hush_selftest_v2.hush");
+    bool          ok = true;
+
+    vector<PasswordEntry> expected = make_entries(3 * VAULT_BLOCK_ENTRIES + 17, 1);
+    Vault                 vault;
+    fill_vault(vault, expected);
+    bool saved = db_save_file(vault, file.path);
+    ok &= report_check("vault_full_roundtrip", "v2", saved && reload_matches(file.path, expected));
+
+    Vault reopened;
+    bool  loaded     = db_load_file(reopened, file.path, SELFTEST_PASSWORD);
+    auto  sizeBefore = filesystem::file_size(file.path);
+
+    PasswordEntry changed = expected[5];
+    changed.password      = "changed";
+    expected[5]           = changed;
+    reopened.update(5, changed);
+    reopened.remove(VAULT_BLOCK_ENTRIES + 3);
+    expected.erase(expected.begin() + VAULT_BLOCK_ENTRIES + 3);
+
+    // Дописывание: файл растёт на два блока, а не переписывается, поколение слота растёт
+    saved     = loaded && db_save_file(reopened, file.path);
+    bool grew = saved && filesystem::file_size(file.path) > sizeBefore &&
+                reopened.layout.generation == 1;
+    ok &= report_check("vault_incremental_update_remove", "v2",
+                       grew && reload_matches(file.path, expected));
+
+    // Второй блок уходит целиком: индекс сдвигается, остальные блоки остаются прежними
+    size_t blocksBefore = reopened.layout.blocks.size();
+    for (size_t i = 0; i < VAULT_BLOCK_ENTRIES - 1; ++i) {
+        reopened.remove(VAULT_BLOCK_ENTRIES);
+    }
+    expected.erase(expected.begin() + VAULT_BLOCK_ENTRIES,
+                   expected.begin() + 2 * VAULT_BLOCK_ENTRIES - 1);
+    saved = db_save_file(reopened, file.path);
+    ok &= report_check("vault_remove_whole_block", "v2",
+                       saved && reopened.layout.blocks.size() == blocksBefore - 1 &&
+                           reload_matches(file.path, expected));
+
+    Vault wrong;
+    ok &= report_check("vault_wrong_password", "v2",
+                       !db_load_file(wrong, file.path, "not the password") &&
+                           wrong.entries.empty());
+
+    // Порча слота с последним поколением: загрузка берёт предыдущее поколение из другого
+    // слота. Размер слота - заголовок 56 байт, параметры 16, индекс по 16 байт и хвост
+    // 44 (поколение, код подлинности, сумма); портится число блоков в заголовке слота
+    vector<PasswordEntry> previous = expected;
+    PasswordEntry         last     = expected[0];
+    last.title                     = "torn";
+    reopened.update(0, last);
+    expected[0]     = last;
+    saved           = db_save_file(reopened, file.path);
+    bool     newest = saved && reload_matches(file.path, expected);
+    uint64_t gen    = reopened.layout.generation;
+    uint64_t slot   = 56 + 16 + uint64_t(reopened.layout.index_capacity) * 16 + 44;
+    {
+        fstream fs(file.path, ios::in | ios::out | ios::binary);
+        fs.seekp((gen % 2) * slot + 48);
+        fs.put('\x7f');
+    }
+    ok &= report_check("vault_torn_slot_fallback", "v2",
+                       newest && reload_matches(file.path, previous));
+    return ok;
+}
+
+// Подмена в файле: блоки, переставленные в индексе с пересчитанной суммой слота,
+// и испорченный байт шифротекста блока не должны загружаться
+bool selftest_vault_tamper() {
+    TempVaultFile file("hush_selftest_tamper.hush");
+
+    vector<PasswordEntry> expected = make_entries(2 * VAULT_BLOCK_ENTRIES, 6);
+    Vault                 vault;
+    fill_vault(vault, expected);
+    bool saved = db_save_file(vault, file.path) &&
+                 reload_matches(file.path, expected);
+
+    ifstream is(file.path, ios::binary);
+    string   original((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+    is.close();
+    auto rejected = [&](const string& image) {
+        ofstream(file.path, ios::binary | ios::trunc) << image;
+        Vault loaded;
+        return !db_load_file(loaded, file.path, SELFTEST_PASSWORD);
+    };
+
+    // Полная запись кладёт поколение 0 в первый слот
+    size_t slot    = 56 + 16 + size_t(vault.layout.index_capacity) * 16 + 44;
+    string swapped = original;
+    swap_ranges(swapped.begin() + 72, swapped.begin() + 88, swapped.begin() + 88);
+    uint64_t checksum = fnv1a64(swapped.data(), slot - sizeof(uint64_t));
+    memcpy(swapped.data() + slot - sizeof(uint64_t), &checksum, sizeof(checksum));
+    bool ok = report_check("vault_index_swap_rejected", "v2", saved && rejected(swapped));
+
+    string flipped = original;
+    flipped[vault.layout.blocks[1].offset + 40] ^= 1;
+    ok &= report_check("vault_block_tamper_rejected", "v2", saved && rejected(flipped));
+    return ok;
+}
+
+// Ключ сеанса: проверка пароля, повторная выработка по соли и параметрам, смена пароля.
+// После db_set_key файл переписывается новым ключом, старый пароль его больше не открывает
+bool selftest_vault_key() {
+    TempVaultFile file("hush_selftest_key.hush");
+
+    VaultKeyPtr key = VaultKey::generate(SELFTEST_PASSWORD, SELFTEST_KDF);
+    bool        ok  = key && key->verify(SELFTEST_PASSWORD) && !key->verify("other password");
+    if (ok) {
+        VaultKeyPtr again = VaultKey::derive(SELFTEST_PASSWORD, key->salt(), key->kdf());
+        ok = again && again->matches(key->salt(), key->kdf()) &&
+             memcmp(again->data(), key->data(), VaultKey::SIZE) == 0;
+    }
+    ok = report_check("vault_key_verify", "-", ok);
+
+    vector<PasswordEntry> expected = make_entries(VAULT_BLOCK_ENTRIES + 1, 7);
+    Vault                 vault;
+    fill_vault(vault, expected);
+    bool saved = db_save_file(vault, file.path);
+
+    db_set_key(vault, VaultKey::generate("new password", SELFTEST_KDF));
+    saved = saved && db_save_file(vault, file.path);
+    Vault reopened, stale;
+    ok &= report_check("vault_rekey", "v2",
+                       saved && db_load_file(reopened, file.path, "new password") &&
+                           same_entries(reopened, expected) &&
+                           !db_load_file(stale, file.path, SELFTEST_PASSWORD));
+    return ok;
+}
+
+// Пароли после загрузки остаются запечатанными и открываются по одному; в файле их
+// открытого текста нет. Испорченный пароль не открывается, а db_set_key тогда
+// отказывается менять ключ и оставляет хранилище как было
+bool selftest_sealed_passwords() {
+    TempVaultFile file("hush_selftest_sealed.hush");
+
+    vector<PasswordEntry> expected = make_entries(VAULT_BLOCK_ENTRIES + 9, 8);
+    Vault                 vault;
+    fill_vault(vault, expected);
+    bool saved = db_save_file(vault, file.path);
+
+    ifstream is(file.path, ios::binary);
+    string   image((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+    is.close();
+
+    Vault loaded;
+    bool  sealed = saved && db_load_file(loaded, file.path, SELFTEST_PASSWORD);
+    for (size_t i = 0; sealed && i < loaded.entries.size(); ++i) {
+        string password;
+        sealed = loaded.entries[i].password.empty() && !loaded.entries[i].sealed_password.empty() &&
+                 loaded.reveal_password(i, password) && password == expected[i].password &&
+                 image.find(expected[i].password) == string::npos;
+    }
+    bool ok = report_check("sealed_passwords_on_demand", "v2", sealed);
+
+    // Первый пароль первого блока лежит сразу за заголовком блока
+    uint64_t block = loaded.layout.blocks[0].offset;
+    uint32_t head;
+    memcpy(&head, image.data() + block, sizeof(head));
+    image[block + sizeof(head) + head + CHACHA_NONCE_SIZE] ^= 1;
+    ofstream(file.path, ios::binary | ios::trunc) << image;
+
+    Vault       damaged;
+    string      password;
+    bool        opened = db_load_file(damaged, file.path, SELFTEST_PASSWORD);
+    VaultKeyPtr before = damaged.key;
+    ok &= report_check("sealed_password_tamper_keeps_key", "v2",
+                       opened && !damaged.reveal_password(0, password) &&
+                           damaged.reveal_password(1, password) &&
+                           !db_set_key(damaged, VaultKey::generate("other", SELFTEST_KDF)) &&
+                           damaged.key == before && !damaged.entries[1].sealed_password.empty());
+    return ok;
+}
+
+// Пул строк: выравнивание, запрос больше блока отдельным блоком, ссылки переживают
+// перемещение пула; secure_wipe очищает строку
+bool selftest_secure_arena() {
+    SecureArena         arena;
+    vector<string_view> stored;
+    for (size_t i = 0; i < 5000; ++i) stored.push_back(arena.store("entry-" + to_string(i)));
+    string   big(SecureArena::CHUNK_SIZE + 1, 'x');
+    uint8_t* large = arena.allocate(big.size());
+    memcpy(large, big.data(), big.size());
+
+    SecureArena moved = std::move(arena);
+    bool        ok    = arena.chunks() == 0 && moved.chunks() >= 2 && moved.store("").empty();
+    for (size_t i = 0; ok && i < stored.size(); ++i) {
+        ok = stored[i] == "entry-" + to_string(i) &&
+             reinterpret_cast<uintptr_t>(stored[i].data()) % alignof(max_align_t) == 0;
+    }
+    ok = ok && memcmp(large, big.data(), big.size()) == 0;
+    moved.clear();
+
+    string secret = "secret";
+    secure_wipe(secret);
+    return report_check("secure_arena_store", "-",
+                        ok && moved.chunks() == 0 && moved.used() == 0 && secret.empty());
+}
+
+// EntryTable против вектора записей на случайных вставках, правках (короче - на месте,
+// длиннее - в конец столбца с уплотнением) и удалениях: поля, флаги по битам,
+// поиск названия и отбор избранных должны совпадать
+bool selftest_entry_table() {
+    mt19937               gen(9);
+    EntryTable            table;
+    vector<PasswordEntry> model;
+    auto                  random_entry = [&] {
+        PasswordEntry entry = make_entries(1, gen())[0];
+        entry.title += string(gen() % 40, 't');
+        return entry;
+    };
+    auto as_ref = [](const PasswordEntry& entry, uint64_t id) {
+        EntryRef ref;
+        ref.id                       = id;
+        ref.title                    = entry.title;
+        ref.login                    = entry.login;
+        ref.password                 = entry.password;
+        ref.is_favorite              = entry.is_favorite;
+        ref.requires_hardware_key    = entry.requires_hardware_key;
+        ref.hardware_key_fingerprint = entry.hardware_key_fingerprint;
+        return ref;
+    };
+
+    vector<uint64_t> ids;
+    for (uint64_t step = 1; step <= 3000; ++step) {
+        uint32_t op = gen() % 4;
+        if (op == 0 || model.size() < 100) {
+            model.push_back(random_entry());
+            ids.push_back(step);
+            table.push_back(as_ref(model.back(), step));
+        } else if (op == 3) {
+            size_t index = gen() % model.size();
+            model.erase(model.begin() + index);
+            ids.erase(ids.begin() + index);
+            table.erase(index);
+        } else {
+            size_t index = gen() % model.size();
+            model[index] = random_entry();
+            table.set(index, as_ref(model[index], ids[index]));
+        }
+    }
+
+    bool        ok = table.size() == model.size();
+    vector<int> favorites, others, expectedFavorites, expectedOthers;
+    for (size_t i = 0; ok && i < model.size(); ++i) {
+        const PasswordEntry& want = model[i];
+        ok = table.id(i) == ids[i] && table.title(i) == want.title &&
+             table.login(i) == want.login && table.password(i) == want.password &&
+             table.is_favorite(i) == want.is_favorite &&
+             table.requires_hardware_key(i) == want.requires_hardware_key &&
+             table.hardware_key_fingerprint(i) == want.hardware_key_fingerprint &&
+             table.find_title(want.title) <= int(i);
+        (want.is_favorite ? expectedFavorites : expectedOthers).push_back(int(i));
+    }
+    table.collect(true, favorites);
+    table.collect(false, others);
+    return report_check("entry_table_columns", "-",
+                        ok && favorites == expectedFavorites && others == expectedOthers &&
+                            table.find_title("no such title") == -1);
+}
+
+// Пакет паролей с минимумом по каждому классу: длина, все классы в каждом пароле,
+// весь алфавит из 88 символов в пакете; невыполнимые политики отклоняются, а uniform
+// не выходит за границу и распределён ровно
+bool selftest_password_generator() {
+    PasswordGenerator generator;
+    PasswordPolicy    policy;
+    policy.length    = 20;
+    policy.min_lower = policy.min_upper = policy.min_digits = policy.min_special = 1;
+
+    vector<string> passwords;
+    vector<bool>   seen(256);
+    bool ok = generator.generate_batch(policy, 20000, passwords) && passwords.size() == 20000;
+    for (const auto& password : passwords) {
+        bool lower = false, upper = false, digit = false, special = false;
+        for (unsigned char c : password) {
+            seen[c] = true;
+            lower |= islower(c) != 0;
+            upper |= isupper(c) != 0;
+            digit |= isdigit(c) != 0;
+            special |= ispunct(c) != 0;
+        }
+        ok = ok && password.size() == 20 && lower && upper && digit && special;
+    }
+    ok = ok && count(seen.begin(), seen.end(), true) == 88;
+    ok = report_check("generator_policy_batch", "-", ok);
+
+    PasswordPolicy none = policy;
+    none.use_lower      = false;
+    none.use_upper      = false;
+    none.use_digits     = false;
+    none.use_special    = false;
+
+    PasswordPolicy empty = policy;
+    empty.length         = 0;
+    PasswordPolicy tight = policy;  // Четыре обязательных символа в трёх позициях
+    tight.length         = 3;
+
+    string password;
+    ok &= report_check("generator_rejects_impossible", "-",
+                       !generator.generate(none, password) &&
+                           !generator.generate(empty, password) &&
+                           !generator.generate(tight, password));
+
+    // 10 корзин по 10000 ожидаемых: отклонение больше 5% у честного генератора
+    // практически невозможно
+    vector<uint32_t> buckets(10);
+    bool             inRange = true;
+    for (size_t i = 0; i < 100000; ++i) {
+        uint32_t v = generator.uniform(10);
+        inRange &= v < 10;
+        if (v < 10) ++buckets[v];
+    }
+    bool even = all_of(buckets.begin(), buckets.end(),
+                       [](uint32_t n) { return n > 9500 && n < 10500; });
+    ok &= report_check("generator_uniform", "-", inRange && even);
+    return ok;
+}
+
+// Оценка стойкости: update на случайных трассах набора и стирания должен давать то же,
+// что оценка с нуля; словарный пароль, дорожка и последовательность - слабые, а длинный
+// случайный - стойкий
+bool selftest_strength() {
+    const string      alphabet = "abcdefghijklmnopqrstuvwxyz0123456789!@#$QWERTY";
+    const string      seeds[]  = {"password", "qwerty", "dragon19", "P@ssw0rd", "abc123", "1987"};
+    mt19937           gen(10);
+    StrengthEstimator estimator;
+    bool              same = true;
+    for (size_t trace = 0; same && trace < 3000; ++trace) {
+        string password;
+        estimator.clear();
+        for (size_t step = 0; same && step < 30; ++step) {
+            uint32_t op = gen() % 6;
+            if (op == 0 && !password.empty()) {
+                password.erase(gen() % password.size(), 1);
+            } else if (op == 1) {
+                password += seeds[gen() % size(seeds)];
+            } else if (op == 2 && !password.empty()) {
+                password.pop_back();
+            } else {
+                password.insert(password.begin() + gen() % (password.size() + 1),
+                                alphabet[gen() % alphabet.size()]);
+            }
+            password.resize(min(password.size(), StrengthEstimator::MAX_LENGTH + 10));
+
+            const StrengthResult& incremental = estimator.update(password);
+            StrengthResult        full        = StrengthEstimator::estimate(password);
+            same = incremental.guesses == full.guesses && incremental.score == full.score &&
+                   incremental.warning == full.warning &&
+                   incremental.sequence.size() == full.sequence.size();
+        }
+    }
+    bool ok = report_check("strength_incremental_matches_full", "-", same);
+
+    bool weak = true;
+    for (const char* password : {"password", "qwertyuiop", "abcdefgh", "11111111", "19871987"}) {
+        weak = weak && StrengthEstimator::estimate(password).score <= 1;
+    }
+    ok &= report_check("strength_known_patterns", "-",
+                       weak && StrengthEstimator::estimate("x7#Kp2!vQz9@mW4s").score == 4);
+    return ok;
+}
+
+// Проверка хранилища сверяется с подсчётом в лоб по исходным записям: повторы паролей,
+// дубли названия и логина и слабые пароли; без ключа все запечатанные пароли нечитаемы
+bool selftest_audit() {
+    TempVaultFile file("hush_selftest_audit.hush");
+
+    const char* common[]  = {"password", "qwerty123", "letmein", "dragon", "monkey2020"};
+    const char  symbols[] = "abcdefghijkmnpqrstuvwxyzABCDEFGHJKLMNPQRSTUVWXYZ23456789!#%&*+=?@";
+    mt19937     gen(12);
+
+    vector<PasswordEntry> expected = make_entries(4 * 512 + 100, 13);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (i % 4 == 0) {
+            expected[i].password = common[gen() % size(common)];
+        } else if (i % 11 == 0) {
+            expected[i].password = expected[i - 3].password;
+        } else {
+            expected[i].password.clear();
+            for (int c = 0; c < 16; ++c) {
+                expected[i].password += symbols[gen() % (sizeof(symbols) - 1)];
+            }
+        }
+        if (i % 9 == 0 && i > 0) {
+            expected[i].title = expected[i - 1].title;
+            expected[i].login = expected[i - 1].login;
+        }
+    }
+
+    map<string, size_t>               passwordCount;
+    map<pair<string, string>, size_t> nameCount;
+    for (const auto& entry : expected) {
+        ++passwordCount[entry.password];
+        ++nameCount[{entry.title, entry.login}];
+    }
+
+    Vault vault;
+    fill_vault(vault, expected);
+    Vault loaded;
+    bool  audited = db_save_file(vault, file.path) &&
+                   db_load_file(loaded, file.path, SELFTEST_PASSWORD);
+
+    AuditReport           report = db_audit(loaded.entries, loaded.key.get());
+    map<uint64_t, size_t> rows;
+    for (size_t i = 0; i < loaded.entries.size(); ++i) rows[loaded.entries[i].id] = i;
+
+    size_t problems = 0, weak = 0, reused = 0, duplicates = 0;
+    for (const auto& entry : expected) {
+        bool isWeak      = StrengthEstimator::estimate(entry.password).score <= AUDIT_WEAK_SCORE;
+        bool isReused    = passwordCount[entry.password] > 1;
+        bool isDuplicate = nameCount[{entry.title, entry.login}] > 1;
+        weak += isWeak;
+        reused += isReused;
+        duplicates += isDuplicate;
+        problems += isWeak || isReused || isDuplicate;
+    }
+    audited = audited && report.entries == expected.size() && report.unreadable == 0 &&
+              report.weak == weak && report.reused == reused &&
+              report.duplicates == duplicates && report.findings.size() == problems;
+    for (size_t f = 0; audited && f < report.findings.size(); ++f) {
+        const AuditFinding&  finding = report.findings[f];
+        const PasswordEntry& want    = expected[rows[finding.id]];
+        audited = finding.title == want.title && finding.login == want.login &&
+                  finding.reused_with + 1 == passwordCount[want.password] &&
+                  (finding.duplicate_group != 0) == (nameCount[{want.title, want.login}] > 1);
+    }
+    bool ok = report_check("audit_matches_reference", "-", audited);
+
+    AuditReport locked = db_audit(loaded.entries, nullptr);
+    ok &= report_check("audit_without_key_unreadable", "-",
+                       locked.unreadable == expected.size() && locked.weak == 0 &&
+                           locked.reused == 0 && locked.findings.size() == expected.size());
+    return ok;
+}
+
+// SHA-1 по векторам FIPS 180-2 (один блок, пустая строка, хвост на два блока, миллион "a")
+// и поиск по собранному вручную файлу утечек с фильтром Блума: все записи находятся
+// со своими счётчиками, отсутствующие пароли - нет, обрезанный файл не открывается
+bool selftest_breach_corpus() {
+    using namespace breach_format;
+
+    struct Vector {
+        string      input;
+        const char* digest;
+    };
+    const Vector vectors[] = {
+        {"abc", "a9993e364706816aba3e25717850c26c9cd0d89d"},
+        {"", "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+         "84983e441c3bd26ebaae4aa1f95129e5e54670f1"},
+        {string(1000000, 'a'), "34aa973cd4c4daa4f61eeb2bdbad27316534016f"},
+    };
+    bool digests = true;
+    for (const auto& v : vectors) {
+        uint8_t digest[HASH_SIZE];
+        sha1(v.input.data(), v.input.size(), digest);
+        digests = digests && memcmp(digest, from_hex(v.digest).data(), HASH_SIZE) == 0;
+    }
+    bool ok = report_check("sha1_fips_vectors", "-", digests);
+
+    const uint32_t fanoutBits = 4;
+    const uint64_t blocks     = 16;
+    const uint32_t hashes     = 7;
+
+    vector<BreachRecord> records(1000);
+    for (size_t i = 0; i < records.size(); ++i) {
+        string password = "breached-" + to_string(i);
+        sha1(password.data(), password.size(), records[i].hash);
+        records[i].count = static_cast<uint32_t>(i + 1);
+    }
+    sort(records.begin(), records.end(), [](const BreachRecord& a, const BreachRecord& b) {
+        return memcmp(a.hash, b.hash, HASH_SIZE) < 0;
+    });
+
+    vector<uint64_t> fanout((size_t(1) << fanoutBits) + 1, 0);
+    vector<uint8_t>  bloom(blocks * BLOOM_BLOCK_BITS / 8, 0);
+    for (const auto& record : records) {
+        ++fanout[(record.hash[0] >> (8 - fanoutBits)) + 1];
+        uint8_t* block = bloom.data() + bloom_block(record.hash, blocks) * (BLOOM_BLOCK_BITS / 8);
+        for (uint32_t i = 0; i < hashes; ++i) {
+            uint32_t bit = bloom_bit(record.hash, i);
+            block[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+        }
+    }
+    for (size_t b = 1; b < fanout.size(); ++b) fanout[b] += fanout[b - 1];
+
+    Header header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version        = VERSION;
+    header.fanout_bits    = fanoutBits;
+    header.count          = records.size();
+    header.fanout_offset  = sizeof(Header);
+    header.records_offset = header.fanout_offset + fanout.size() * sizeof(uint64_t);
+    header.bloom_offset   = header.records_offset + records.size() * sizeof(BreachRecord);
+    header.bloom_blocks   = blocks;
+    header.bloom_hashes   = hashes;
+
+    TempVaultFile file("hush_selftest_breach.hbc");
+    {
+        ofstream os(file.path, ios::binary | ios::trunc);
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(fanout.data()), fanout.size() * sizeof(uint64_t));
+        os.write(reinterpret_cast<const char*>(records.data()),
+                 records.size() * sizeof(BreachRecord));
+        os.write(reinterpret_cast<const char*>(bloom.data()), bloom.size());
+    }
+
+    BreachCorpus corpus;
+    bool         found = corpus.open(file.path) && corpus.size() == records.size();
+    for (size_t i = 0; found && i < records.size(); ++i) {
+        found = corpus.check("breached-" + to_string(i)) == i + 1 &&
+                corpus.check("unbreached-" + to_string(i)) == 0;
+    }
+    corpus.close();
+    ok &= report_check("breach_corpus_lookup", "-", found);
+
+    filesystem::resize_file(file.path, header.bloom_offset - 1);
+    ok &= report_check("breach_corpus_truncated_rejected", "-", !corpus.open(file.path));
+    return ok;
+}
+
+// Разбор выгрузки из строки; записи копируются, пароль в entry после вызова стирается
+bool read_import(const string& text, ImportFormat& format, vector<PasswordEntry>& entries) {
+    istringstream in(text);
+    string        error;
+    entries.clear();
+    return db_read_import(in, format,
+                          [&](PasswordEntry& entry) {
+                              entries.push_back(entry);
+                              return true;
+                          },
+                          error) &&
+           error.empty();
+}
+
+bool imported_as(const vector<PasswordEntry>& entries,
+                 const vector<pair<string, string>>& titlesAndPasswords) {
+    if (entries.size() != titlesAndPasswords.size()) return false;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].title != titlesAndPasswords[i].first ||
+            entries[i].password != titlesAndPasswords[i].second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Импорт: BOM, поля CSV в кавычках с запятыми, "" и переводом строки, название по адресу;
+// сущности, CDATA и пропуск истории и корзины KeePass; суррогатные пары и экранирование
+// Bitwarden; обрезанные и повреждённые выгрузки отклоняются
+bool selftest_import() {
+    vector<PasswordEntry> entries;
+    ImportFormat          format = ImportFormat::Auto;
+
+    bool csv = read_import("\xef\xbb\xbfname,url,username,password\r\n"
+                           "\"Bank, Inc\",https://bank.example,\"al\"\"ice\",\"p,w\"\"1\nx\"\r\n"
+                           ",https://me@mail.example.com:443/x,bob,pw2\n",
+                           format, entries) &&
+               format == ImportFormat::Csv &&
+               imported_as(entries, {{"Bank, Inc", "p,w\"1\nx"}, {"mail.example.com", "pw2"}}) &&
+               entries[0].login == "al\"ice";
+    bool ok = report_check("import_csv_quoting", "csv", csv);
+
+    format      = ImportFormat::Auto;
+    bool keepass = read_import(
+        "\xef\xbb\xbf<?xml version=\"1.0\"?><KeePassFile><Meta>"
+        "<RecycleBinUUID>bin</RecycleBinUUID></Meta><Root><Group><UUID>root</UUID>"
+        "<Entry><String><Key>Title</Key><Value>A &amp; B &#x1F600;</Value></String>"
+        "<String><Key>Password</Key><Value><![CDATA[<p&w>]]></Value></String>"
+        "<History><Entry><String><Key>Title</Key><Value>old</Value></String>"
+        "<String><Key>Password</Key><Value>old</Value></String></Entry></History>"
+        "</Entry><Group><UUID>bin</UUID><Entry><String><Key>Password</Key>"
+        "<Value>deleted</Value></String></Entry></Group></Group></Root></KeePassFile>",
+        format, entries);
+    keepass = keepass && format == ImportFormat::KeePassXml &&
+              imported_as(entries, {{"A & B \xf0\x9f\x98\x80", "<p&w>"}});
+    ok &= report_check("import_keepass_history_skipped", "keepass", keepass);
+
+    format         = ImportFormat::Auto;
+    bool bitwarden = read_import(
+        "{\"encrypted\": false, \"items\": ["
+        "{\"type\": 1, \"name\": \"Smile \\ud83d\\ude00\", \"login\": "
+        "{\"username\": \"u\", \"password\": \"a\\\"b\\\\c\\ud83d\\n\\ude00\"}},"
+        "{\"type\": 2, \"name\": \"note\", \"login\": null}]}",
+        format, entries);
+    bitwarden = bitwarden && format == ImportFormat::BitwardenJson &&
+                imported_as(entries, {{"Smile \xf0\x9f\x98\x80",
+                                       "a\"b\\c\xef\xbf\xbd\n\xef\xbf\xbd"}});
+    ok &= report_check("import_bitwarden_surrogates", "bitwarden", bitwarden);
+
+    bool rejected = true;
+    for (const char* broken : {"title,password\n\"open,pw\n",
+                               "<KeePassFile><Root><Group><Entry><String><Value>&#xD800;",
+                               "<KeePassFile><Root><Group>",
+                               "{\"items\": [{\"type\": 1, \"name\": \"cut"}) {
+        format   = ImportFormat::Auto;
+        rejected = rejected && !read_import(broken, format, entries);
+    }
+    ok &= report_check("import_corrupt_rejected", "-", rejected);
+    return ok;
+}
+
+// v1 пишется кусками по 64 КиБ; пароль в 300 КБ даёт несколько полных кусков за одну
+// запись, и все они должны уйти в файл
+bool selftest_vault_v1_chunks() {
+    TempVaultFile file("hush_selftest_v1.hush");
+
+    vector<PasswordEntry> expected = make_entries(5000, 14);
+    mt19937               gen(15);
+    expected[2500].password.clear();
+    for (size_t i = 0; i < 300 * 1000; ++i) {
+        expected[2500].password += static_cast<char>('!' + gen() % 94);
+    }
+
+    Vault vault;
+    vault.layout.version = VAULT_FORMAT_V1;
+    vault.key            = VaultKey::generate(SELFTEST_PASSWORD, KdfParams());
+    for (const auto& entry : expected) vault.add(entry);
+
+    Vault loaded;
+    bool  ok = db_save_file(vault, file.path) &&
+               db_load_file(loaded, file.path, SELFTEST_PASSWORD) &&
+               loaded.layout.version == VAULT_FORMAT_V1 && same_entries(loaded, expected);
+    return report_check("vault_v1_chunked_save", "v1", ok);
+}
+
+// Выгрузка запечатанного хранилища в CSV и JSON и импорт обратно: те же записи, включая
+// кавычки, запятые, переводы строк и не-ASCII в полях
+bool selftest_export() {
+    TempVaultFile file("hush_selftest_export.hush");
+    TempVaultFile csv("hush_selftest_export.csv");
+    TempVaultFile json("hush_selftest_export.json");
+
+    vector<PasswordEntry> expected = make_entries(VAULT_BLOCK_ENTRIES + 3, 16);
+    expected[0].title              = "Quote \"and\", comma";
+    expected[1].password           = "line\nbreak\\ \xd0\xbf\xd0\xb0\xd1\x80\xd0\xbe\xd0\xbb";
+    expected[2].login              = "=cmd|' /C calc'!A0";
+
+    Vault vault;
+    fill_vault(vault, expected);
+    Vault loaded;
+    bool  ok = db_save_file(vault, file.path) && db_load_file(loaded, file.path, SELFTEST_PASSWORD);
+
+    for (const auto& [out, format] :
+         {pair{&csv, ExportFormat::Csv}, pair{&json, ExportFormat::Json}}) {
+        bool exported = ok && db_export(loaded.entries, loaded.key.get(), out->path, format);
+
+        Vault    imported;
+        mutex    importedMutex;
+        ifstream in(out->path, ios::binary);
+        imported.key        = loaded.key;
+        ImportReport report = db_import(imported, importedMutex, in);
+
+        bool same = exported && report.error.empty() && report.imported == expected.size();
+        for (size_t i = 0; same && i < expected.size(); ++i) {
+            PasswordEntry got;
+            same = imported.reveal(i, got) && got.title == expected[i].title &&
+                   got.login == expected[i].login && got.password == expected[i].password &&
+                   got.is_favorite == expected[i].is_favorite;
+        }
+        ok &= report_check("export_import_round_trip",
+                           format == ExportFormat::Csv ? "csv" : "json", same);
+    }
+    return ok;
+}
+
+// Сжатие: случайные входы разной сжимаемости (пустой, несжимаемый, повторы на коротком
+// и длинном расстоянии, длинные серии) распаковываются в исходные байты. Обрезанные
+// данные и неверная длина отклоняются, а испорченные не пишут за конец выхода
+bool selftest_lz_codec() {
+    mt19937 gen(17);
+
+    auto make_input = [&](size_t size, uint32_t kind) {
+        vector<uint8_t> src(size);
+        for (size_t i = 0; i < size; ++i) {
+            switch (kind) {
+                case 0:  // Несжимаемый
+                    src[i] = static_cast<uint8_t>(gen());
+                    break;
+                case 1:  // Малый алфавит: короткие совпадения
+                    src[i] = static_cast<uint8_t>('a' + gen() % 4);
+                    break;
+                case 2:  // Серии одного байта: совпадения, перекрывающие себя
+                    src[i] = i > 0 && gen() % 64 ? src[i - 1] : static_cast<uint8_t>(gen());
+                    break;
+                default:  // Куски, повторённые далеко позади, как домены и логины в блоке
+                    src[i] = i >= 1000 && gen() % 8 ? src[i - 1000 + gen() % 3]
+                                                    : static_cast<uint8_t>(gen() % 16);
+                    break;
+            }
+        }
+        return src;
+    };
+
+    bool round = true, rejected = true, bounded = true;
+    for (int trial = 0; trial < 400; ++trial) {
+        size_t          size = trial < 20 ? trial : gen() % (trial < 200 ? 300 : 70000);
+        vector<uint8_t> src  = make_input(size, trial % 4);
+
+        string packed;
+        lz_compress(src.data(), src.size(), packed);
+        round = round && packed.size() <= lz_bound(size);
+
+        // За концом выхода - сторожевые байты, которые распаковка не должна тронуть
+        const size_t    guard = 64;
+        vector<uint8_t> dst(size + guard, 0xa5);
+        auto            in = reinterpret_cast<const uint8_t*>(packed.data());
+
+        round = round && lz_decompress(in, packed.size(), dst.data(), size) &&
+                equal(src.begin(), src.end(), dst.begin());
+
+        rejected = rejected && !lz_decompress(in, packed.size(), dst.data(), size + 1) &&
+                   (size == 0 || !lz_decompress(in, packed.size(), dst.data(), size - 1));
+        for (int cut = 0; cut < 4 && !packed.empty(); ++cut) {
+            rejected = rejected && !lz_decompress(in, gen() % packed.size(), dst.data(), size);
+        }
+
+        for (int flip = 0; flip < 8 && !packed.empty(); ++flip) {
+            string damaged = packed;
+            damaged[gen() % damaged.size()] ^= static_cast<char>(1 + gen() % 255);
+            fill(dst.begin(), dst.end(), 0xa5);
+            lz_decompress(reinterpret_cast<const uint8_t*>(damaged.data()), damaged.size(),
+                          dst.data(), size);
+            bounded = bounded && all_of(dst.end() - guard, dst.end(),
+                                        [](uint8_t b) { return b == 0xa5; });
+        }
+    }
+    bool ok = report_check("lz_round_trip", "-", round);
+    ok &= report_check("lz_truncated_rejected", "-", rejected);
+    ok &= report_check("lz_corrupt_bounded", "-", bounded);
+    return ok;
+}
+
+// Две пачки правок через журнал, воспроизведение при загрузке, обрезанный хвост
+// последней записи и удаление журнала полной записью файла
+bool selftest_journal() {
+    TempVaultFile file("hush_selftest_journal.hush");
+    bool          ok = true;
+
+    vector<PasswordEntry> expected = make_entries(VAULT_BLOCK_ENTRIES + 5, 2);
+    Vault                 vault;
+    fill_vault(vault, expected);
+    bool saved = db_save_file(vault, file.path);
+
+    Vault reopened;
+    bool  loaded = saved && db_load_file(reopened, file.path, SELFTEST_PASSWORD);
+
+    PasswordEntry added = make_entries(1, 3)[0];
+    reopened.add(added);
+    expected.push_back(added);
+    PasswordEntry changed = expected[7];
+    changed.login         = "renamed@example.com";
+    expected[7]           = changed;
+    reopened.update(7, changed);
+    reopened.remove(2);
+    expected.erase(expected.begin() + 2);
+    bool appended   = loaded && db_autosave(reopened) &&
+                      filesystem::exists(journal_path(file.path));
+    auto firstBatch = filesystem::file_size(journal_path(file.path));
+
+    // Вторая пачка - одна запись, её хвост потом обрезается
+    vector<PasswordEntry> beforeLast = expected;
+    reopened.remove(0);
+    expected.erase(expected.begin());
+    appended &= db_autosave(reopened);
+
+    ok &= report_check("journal_append_replay", "v2",
+                       appended && reload_matches(file.path, expected));
+
+    filesystem::resize_file(journal_path(file.path),
+                            filesystem::file_size(journal_path(file.path)) - 3);
+    ok &= report_check("journal_torn_tail", "v2",
+                       reload_matches(file.path, beforeLast) &&
+                           filesystem::file_size(journal_path(file.path)) == firstBatch);
+
+    Vault folded;
+    bool  discarded = db_load_file(folded, file.path, SELFTEST_PASSWORD) &&
+                      db_save_file(folded, file.path) &&
+                      !filesystem::exists(journal_path(file.path));
+    ok &= report_check("journal_fold", "v2", discarded && reload_matches(file.path, beforeLast));
+    return ok;
+}
+
+// Постоянные номера записей переживают полную запись, журнал и дописывание блоков
+bool selftest_entry_ids() {
+    TempVaultFile file("hush_selftest_ids.hush");
+
+    Vault vault;
+    fill_vault(vault, make_entries(VAULT_BLOCK_ENTRIES + 40, 4));
+    bool ok = db_save_file(vault, file.path);
+
+    Vault reopened;
+    ok = ok && db_load_file(reopened, file.path, SELFTEST_PASSWORD);
+    reopened.remove(3);
+    reopened.add(make_entries(1, 5)[0]);
+    ok = ok && db_autosave(reopened);
+
+    vector<uint64_t> ids;
+    for (const auto& entry : reopened.entries) ids.push_back(entry.id);
+
+    auto same_ids = [&](const Vault& loaded) {
+        if (loaded.entries.size() != ids.size()) return false;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (loaded.entries[i].id != ids[i] || loaded.index_of(ids[i]) != int(i)) return false;
+        }
+        return true;
+    };
+
+    Vault replayed;
+    ok = ok && db_load_file(replayed, file.path, SELFTEST_PASSWORD) && same_ids(replayed);
+    ok = ok && db_save_file(replayed, file.path);
+
+    Vault folded;
+    ok = ok && db_load_file(folded, file.path, SELFTEST_PASSWORD) && same_ids(folded);
+    return report_check("entry_ids_persist", "v2", ok);
+}
+
+// scan_sysfs на поддельном дереве: корневой хаб, хаб, интерфейс в списке устройств,
+// клавиатура с серийным номером и устройство без серийного номера и накопителя
+// отбрасываются; флешка без серийного номера находится по интерфейсу класса 08
+bool selftest_sysfs() {
+    auto root    = filesystem::temp_directory_path() / "hush_selftest_sysfs";
+    auto devices = root / "bus/usb/devices";
+    auto device  = [&](const string& name, vector<pair<string, string>> attributes) {
+        filesystem::create_directories(devices / name);
+        for (const auto& [attribute, value] : attributes) {
+            ofstream(devices / name / attribute) << value << '\n';
+        }
+    };
+
+    filesystem::remove_all(root);
+    device("usb1", {{"idVendor", "1d6b"}, {"idProduct", "0002"}, {"serial", "0000:00:14.0"}});
+    device("1-1", {{"idVendor", "05e3"},
+                   {"idProduct", "0610"},
+                   {"bDeviceClass", "09"},
+                   {"serial", "HUB1"}});
+    device("1-1:1.0", {{"idVendor", "05e3"}, {"idProduct", "0610"}, {"serial", "IF"}});
+    device("1-2", {{"idVendor", "0781"}, {"idProduct", "5567"}, {"product", "Cruzer"}});
+    device("1-2/1-2:1.0", {{"bInterfaceClass", "08"}});
+    device("1-3", {{"idVendor", "046d"},
+                   {"idProduct", "c31c"},
+                   {"product", "USB Keyboard"},
+                   {"serial", "KB1"}});
+    device("1-4", {{"idVendor", "1050"},
+                   {"idProduct", "0407"},
+                   {"product", "YubiKey"},
+                   {"serial", "ABC"}});
+    device("1-5", {{"idVendor", "04f2"}, {"idProduct", "b6dd"}, {"product", "Integrated"}});
+    device("1-5/1-5:1.0", {{"bInterfaceClass", "0e"}});
+
+    vector<string> found;
+    for (const auto& usb : hardware_key::scan_sysfs(root.string())) {
+        found.push_back(usb.fingerprint);
+    }
+    filesystem::remove_all(root);
+    return report_check("scan_sysfs_filter", "-",
+                        found == vector<string>{"0781:5567", "1050:0407:ABC"});
+}
+
+}  // namespace
+
+int run_selftest() {
+    bool ok = true;
+    ok &= selftest_cipher_paths();
+    ok &= selftest_argon2id();
+    ok &= selftest_vault_v2();
+    ok &= selftest_vault_tamper();
+    ok &= selftest_vault_key();
+    ok &= selftest_sealed_passwords();
+    ok &= selftest_secure_arena();
+    ok &= selftest_entry_table();
+    ok &= selftest_password_generator();
+    ok &= selftest_strength();
+    ok &= selftest_audit();
+    ok &= selftest_breach_corpus();
+    ok &= selftest_import();
+    ok &= selftest_vault_v1_chunks();
+    ok &= selftest_export();
+    ok &= selftest_lz_codec();
+    ok &= selftest_journal();
+    ok &= selftest_entry_ids();
+    ok &= selftest_sysfs();
+    return ok ? 0 : 1;
+}
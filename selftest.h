@@ -0,0 +1,9 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+// Самопроверка ядра хранилища: hush_bench --selftest, в ctest - hush_selftest.
+// Каждая проверка печатает строку JSON {"selftest": имя, "path": вариант, "ok": итог};
+// возвращает код выхода процесса: 0 - все проверки прошли, 1 - хотя бы одна упала
+int run_selftest();
+
+#endif
@@ -0,0 +1,146 @@
+// strength_dict_compile - сборка словарей оценки стойкости в заголовок C++.
+//
+// Каждый словарь (по слову на строку, строки с # - комментарии, ранг - номер слова
+// по частоте) превращается в префиксное дерево по перевёрнутым словам: оценщик идёт
+// от конца пароля назад и сразу находит все слова, которые заканчиваются в этой позиции.
+// Дерево лежит в constexpr-массивах, поэтому при запуске ничего не разбирается.
+//
+//   strength_dict_compile <strength_dicts.h> <name>=<words.txt>...
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Node {
+    map<uint8_t, unique_ptr<Node>> children;
+    uint32_t                       rank = 0;  // 0 - здесь слово не заканчивается
+};
+
+struct Dictionary {
+    string name;
+    Node   root;
+};
+
+bool load_words(const string& path, Node& root) {
+    ifstream in(path);
+    if (!in) return false;
+
+    string   line;
+    uint32_t rank = 0;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        ++rank;
+
+        Node* node = &root;
+        for (auto it = line.rbegin(); it != line.rend(); ++it) {
+            uint8_t c     = static_cast<uint8_t>(tolower(static_cast<unsigned char>(*it)));
+            auto&   child = node->children[c];
+            if (!child) child = make_unique<Node>();
+            node = child.get();
+        }
+        if (node->rank == 0) node->rank = rank;
+    }
+    return true;
+}
+
+void write_array(FILE* out, const char* type, const string& name, const vector<uint32_t>& values) {
+    fprintf(out, "inline constexpr %s %s[] = {", type, name.c_str());
+    for (size_t i = 0; i < values.size(); ++i) {
+        fprintf(out, i % 16 == 0 ? "\n    %u," : " %u,", values[i]);
+    }
+    fprintf(out, "\n};\n\n");
+}
+
+// Узлы нумеруются обходом в ширину: корень - 0, дети узла идут подряд по возрастанию
+// символа, поэтому рёбра узла i - [first_edge[i], first_edge[i + 1]). Дети корня есть
+// почти у каждого символа пароля, поэтому для них отдельная таблица на все 256 байтов
+void write_trie(FILE* out, const Dictionary& dict) {
+    vector<uint32_t> firstEdge, labels, targets, ranks, root(256, 0);
+
+    deque<const Node*> queue = {&dict.root};
+    uint32_t           next  = 1;
+    while (!queue.empty()) {
+        const Node* node = queue.front();
+        queue.pop_front();
+
+        firstEdge.push_back(static_cast<uint32_t>(labels.size()));
+        ranks.push_back(node->rank);
+        for (const auto& [label, child] : node->children) {
+            if (node == &dict.root) root[label] = next;
+            labels.push_back(label);
+            targets.push_back(next++);
+            queue.push_back(child.get());
+        }
+    }
+    firstEdge.push_back(static_cast<uint32_t>(labels.size()));
+
+    write_array(out, "uint32_t", dict.name + "_first_edge", firstEdge);
+    write_array(out, "uint8_t", dict.name + "_labels", labels);
+    write_array(out, "uint32_t", dict.name + "_targets", targets);
+    write_array(out, "uint32_t", dict.name + "_ranks", ranks);
+    write_array(out, "uint32_t", dict.name + "_root", root);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <strength_dicts.h> <name>=<words.txt>...\n", argv[0]);
+        return 2;
+    }
+
+    vector<Dictionary> dicts(argc - 2);
+    for (int i = 2; i < argc; ++i) {
+        string arg = argv[i];
+        size_t eq  = arg.find('=');
+        if (eq == string::npos || eq == 0) {
+            fprintf(stderr, "strength_dict_compile: bad argument '%s'\n", argv[i]);
+            return 2;
+        }
+        dicts[i - 2].name = arg.substr(0, eq);
+        if (!load_words(arg.substr(eq + 1), dicts[i - 2].root)) {
+            fprintf(stderr, "strength_dict_compile: cannot read '%s'\n", argv[i] + eq + 1);
+            return 1;
+        }
+    }
+
+    FILE* out = fopen(argv[1], "w");
+    if (!out) {
+        fprintf(stderr, "strength_dict_compile: cannot write '%s'\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(out,
+            "// Сгенерировано strength_dict_compile из dictionaries/*.txt, не редактировать\n"
+            "#ifndef STRENGTH_DICTS_H\n#define STRENGTH_DICTS_H\n\n#include <cstdint>\n\n"
+            "namespace strength_dicts {\n\n");
+    for (const auto& dict : dicts) write_trie(out, dict);
+
+    fprintf(out,
+            "struct Trie {\n    const char*     name;\n    const uint32_t* first_edge;\n"
+            "    const uint8_t*  labels;\n    const uint32_t* targets;\n"
+            "    const uint32_t* ranks;\n"
+            "    const uint32_t* root;  // Дети корня по символу, 0 - нет\n"
+            "};\n\ninline constexpr Trie tries[] = {\n");
+    for (const auto& dict : dicts) {
+        const char* n = dict.name.c_str();
+        fprintf(out,
+                "    {\"%s\", %s_first_edge, %s_labels, %s_targets, %s_ranks, %s_root},\n",
+                n, n, n, n, n, n);
+    }
+    fprintf(out, "};\n\n}  // namespace strength_dicts\n\n#endif\n");
+
+    bool ok = fclose(out) == 0;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,698 @@
+#include "strength_estimator.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+#include "secure_arena.h"
+#include "strength_dicts.h"
+
+using namespace std;
+
+namespace {
+
+// Константы модели zxcvbn
+constexpr double MIN_GUESSES_SINGLE_CHAR             = 10;
+constexpr double MIN_GUESSES_MULTI_CHAR              = 50;
+constexpr double BRUTEFORCE_CARDINALITY              = 10;
+constexpr double MIN_GUESSES_BEFORE_GROWING_SEQUENCE = 10000;
+constexpr int    MIN_YEAR_SPACE                      = 20;
+
+constexpr double INFINITY_PI = numeric_limits<double>::infinity();  // Разбора нет
+
+constexpr size_t MAX_WORD_LENGTH  = 32;
+constexpr size_t MAX_REPEAT_BLOCK = 16;
+
+double n_choose_k(int n, int k) {
+    if (k > n) return 0;
+    double r = 1;
+    for (int d = 1; d <= k; ++d) r = r * (n - k + d) / d;
+    return r;
+}
+
+// Сколько способов расставить s особых символов среди s + u: для заглавных букв и Shift
+double variations(int special, int plain) {
+    if (special == 0) return 1;
+    if (plain == 0) return 2;
+    double v = 0;
+    for (int i = 1; i <= min(special, plain); ++i) v += n_choose_k(special + plain, i);
+    return v;
+}
+
+// Все строчные - 1, заглавная только первая или последняя - 2, иначе сочетания
+double uppercase_variations(string_view token) {
+    int upper = 0, lower = 0;
+    for (char c : token) {
+        if (isupper(static_cast<unsigned char>(c))) ++upper;
+        if (islower(static_cast<unsigned char>(c))) ++lower;
+    }
+    if (upper == 1 && (isupper(static_cast<unsigned char>(token.front())) ||
+                       isupper(static_cast<unsigned char>(token.back())))) {
+        return 2;
+    }
+    return variations(upper, lower);
+}
+
+// Замены букв похожими символами: p@ssw0rd
+struct LeetSub {
+    char from;
+    char to;
+};
+
+constexpr LeetSub LEET[] = {{'4', 'a'}, {'@', 'a'}, {'8', 'b'}, {'(', 'c'}, {'{', 'c'}, {'[', 'c'},
+                            {'<', 'c'}, {'3', 'e'}, {'6', 'g'}, {'9', 'g'}, {'1', 'i'}, {'!', 'i'},
+                            {'|', 'i'}, {'1', 'l'}, {'|', 'l'}, {'7', 'l'}, {'0', 'o'}, {'$', 's'},
+                            {'5', 's'}, {'+', 't'}, {'7', 't'}, {'%', 'x'}, {'2', 'z'}};
+
+// Буквы, которые может заменять символ, по символу: обход словаря на каждом шаге
+// смотрит сюда, а не перебирает всю таблицу LEET
+const char* leet_letters(char raw) {
+    static const auto TABLE = [] {
+        array<array<char, 4>, 256> table{};
+        for (const auto& sub : LEET) {
+            auto& letters = table[static_cast<uint8_t>(sub.from)];
+            letters[strlen(letters.data())] = sub.to;
+        }
+        return table;
+    }();
+    return TABLE[static_cast<uint8_t>(raw)].data();
+}
+
+int dictionary_index(const char* name) {
+    for (size_t i = 0; i < size(strength_dicts::tries); ++i) {
+        if (strcmp(strength_dicts::tries[i].name, name) == 0) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void push_match(vector<StrengthMatch>& matches, StrengthMatch match) {
+    double min = match.begin == match.end ? MIN_GUESSES_SINGLE_CHAR : MIN_GUESSES_MULTI_CHAR;
+    match.guesses = max(match.guesses, min);
+    matches.push_back(match);
+}
+
+// Обход дерева словаря назад от позиции end: каждый узел с рангом - слово,
+// которое заканчивается в end
+struct DictionaryWalk {
+    const strength_dicts::Trie& trie;
+    uint8_t                     dictionary;
+    string_view                 password;
+    size_t                      end;
+    vector<StrengthMatch>&      matches;
+    char                        letters[MAX_WORD_LENGTH];  // letters[d] - буква для end - d
+
+    uint32_t child(uint32_t node, char c) const {
+        if (node == 0) return trie.root[static_cast<uint8_t>(c)];
+        const uint8_t* first = trie.labels + trie.first_edge[node];
+        const uint8_t* last  = trie.labels + trie.first_edge[node + 1];
+        const uint8_t* it    = lower_bound(first, last, static_cast<uint8_t>(c));
+        return it != last && *it == static_cast<uint8_t>(c) ? trie.targets[it - trie.labels] : 0;
+    }
+
+    void walk(uint32_t node, size_t depth) {
+        if (depth > 0 && trie.ranks[node]) emit(node, depth);
+        if (depth == MAX_WORD_LENGTH || depth > end) return;
+
+        char raw   = password[end - depth];
+        char lower = static_cast<char>(tolower(static_cast<unsigned char>(raw)));
+        if (uint32_t next = child(node, lower)) {
+            letters[depth] = lower;
+            walk(next, depth + 1);
+        }
+        for (const char* to = leet_letters(raw); *to; ++to) {
+            if (uint32_t next = child(node, *to)) {
+                letters[depth] = *to;
+                walk(next, depth + 1);
+            }
+        }
+    }
+
+    void emit(uint32_t node, size_t depth) {
+        size_t      begin = end + 1 - depth;
+        string_view token = password.substr(begin, depth);
+
+        // Для каждой замены: сколько букв заменено и сколько таких же оставлено как есть
+        double leet = 1;
+        for (size_t d = 0; d < depth; ++d) {
+            char raw = password[end - d];
+            if (tolower(static_cast<unsigned char>(raw)) == letters[d]) continue;
+
+            bool seen = false;
+            for (size_t e = 0; e < d && !seen; ++e) {
+                seen = password[end - e] == raw && letters[e] == letters[d];
+            }
+            if (seen) continue;
+
+            int subbed = 0, unsubbed = 0;
+            for (size_t e = 0; e < depth; ++e) {
+                char c = password[end - e];
+                if (c == raw && letters[e] == letters[d]) ++subbed;
+                if (tolower(static_cast<unsigned char>(c)) == letters[d]) ++unsubbed;
+            }
+            leet *= variations(subbed, unsubbed);
+        }
+
+        StrengthMatch match;
+        match.pattern    = StrengthMatch::DICTIONARY;
+        match.dictionary = dictionary;
+        match.begin      = static_cast<uint16_t>(begin);
+        match.end        = static_cast<uint16_t>(end);
+        match.rank       = trie.ranks[node];
+        match.guesses    = match.rank * uppercase_variations(token) * leet;
+        push_match(matches, match);
+    }
+};
+
+// Раскладка QWERTY со сдвигом рядов: соседи - клавиши рядом в ряду и касающиеся
+// в соседних рядах, всего до шести направлений
+struct Keyboard {
+    struct Key {
+        int8_t row     = -1;
+        float  x       = 0;
+        bool   shifted = false;
+    };
+
+    Key    keys[256];
+    double starts = 0;  // Клавиш, с которых может начаться дорожка
+    double degree = 0;  // Среднее число соседей
+
+    Keyboard() {
+        static const char* const lower[]  = {"`1234567890-=", "qwertyuiop[]\\", "asdfghjkl;'",
+                                             "zxcvbnm,./"};
+        static const char* const upper[]  = {"~!@#$%^&*()_+", "QWERTYUIOP{}|", "ASDFGHJKL:\"",
+                                             "ZXCVBNM<>?"};
+        static const float       offset[] = {0, 1.5f, 1.75f, 2.25f};
+
+        for (int row = 0; row < 4; ++row) {
+            for (size_t i = 0; lower[row][i]; ++i) {
+                float x = offset[row] + i;
+                keys[static_cast<uint8_t>(lower[row][i])] = {static_cast<int8_t>(row), x, false};
+                keys[static_cast<uint8_t>(upper[row][i])] = {static_cast<int8_t>(row), x, true};
+            }
+        }
+
+        size_t edges = 0;
+        for (int a = 0; a < 256; ++a) {
+            if (keys[a].row < 0 || keys[a].shifted) continue;
+            starts += 1;
+            for (int b = 0; b < 256; ++b) {
+                if (keys[b].row >= 0 && !keys[b].shifted && direction(a, b) >= 0) ++edges;
+            }
+        }
+        degree = edges / starts;
+    }
+
+    // Направление от a к b (0-5), -1 - не соседи
+    int direction(uint8_t a, uint8_t b) const {
+        const Key& ka = keys[a];
+        const Key& kb = keys[b];
+        if (ka.row < 0 || kb.row < 0) return -1;
+
+        int   dr = kb.row - ka.row;
+        float dx = kb.x - ka.x;
+        if (dr == 0) return fabs(fabs(dx) - 1) < 0.01f ? (dx > 0 ? 0 : 1) : -1;
+        if (abs(dr) == 1 && fabs(dx) < 1) return (dr < 0 ? 2 : 4) + (dx > 0 ? 0 : 1);
+        return -1;
+    }
+
+    double guesses(int length, int turns, int shifted) const {
+        double g = 0;
+        for (int i = 2; i <= length; ++i) {
+            for (int j = 1; j <= min(turns, i - 1); ++j) {
+                g += n_choose_k(i - 1, j - 1) * starts * pow(degree, j);
+            }
+        }
+        return g * variations(shifted, length - shifted);
+    }
+};
+
+const Keyboard& qwerty() {
+    static const Keyboard keyboard;
+    return keyboard;
+}
+
+int reference_year() {
+    static const int year = [] {
+        using namespace chrono;
+        return static_cast<int>(year_month_day(floor<days>(system_clock::now())).year());
+    }();
+    return year;
+}
+
+// Год из 2 цифр: 51-99 - 19xx, остальные - 20xx
+int expand_year(int value, int digits) {
+    if (digits == 4) return value >= 1000 && value <= 2050 ? value : -1;
+    if (digits == 2) return value > 50 ? 1900 + value : 2000 + value;
+    return -1;
+}
+
+bool day_month(int day, int dayDigits, int month, int monthDigits) {
+    return dayDigits <= 2 && monthDigits <= 2 && day >= 1 && day <= 31 && month >= 1 &&
+           month <= 12;
+}
+
+// Год в начале или в конце, день и месяц в любом порядке; -1 - не дата
+int parse_date(const int* values, const int* digits) {
+    int  best     = -1;
+    auto consider = [&](int year) {
+        if (year < 0) return;
+        if (best < 0 || abs(year - reference_year()) < abs(best - reference_year())) best = year;
+    };
+    if (day_month(values[1], digits[1], values[2], digits[2]) ||
+        day_month(values[2], digits[2], values[1], digits[1])) {
+        consider(expand_year(values[0], digits[0]));
+    }
+    if (day_month(values[0], digits[0], values[1], digits[1]) ||
+        day_month(values[1], digits[1], values[0], digits[0])) {
+        consider(expand_year(values[2], digits[2]));
+    }
+    return best;
+}
+
+int digits_value(string_view s) {
+    int v = 0;
+    for (char c : s) v = v * 10 + (c - '0');
+    return v;
+}
+
+bool all_digits(string_view s) {
+    return s.find_first_not_of("0123456789") == string_view::npos;
+}
+
+// Степени и факториалы по длине: pow и tgamma на каждый разбор дороже самого поиска
+struct GuessTables {
+    static constexpr size_t SIZE = StrengthEstimator::MAX_LENGTH + 1;
+
+    array<double, SIZE> bruteforce;  // BRUTEFORCE_CARDINALITY^n
+    array<double, SIZE> factorial;   // n!
+    array<double, SIZE> growing;     // MIN_GUESSES_BEFORE_GROWING_SEQUENCE^(n - 1)
+
+    GuessTables() {
+        for (size_t n = 0; n < SIZE; ++n) {
+            bruteforce[n] = pow(BRUTEFORCE_CARDINALITY, static_cast<double>(n));
+            factorial[n]  = tgamma(n + 1.0);
+            growing[n]    = pow(MIN_GUESSES_BEFORE_GROWING_SEQUENCE, static_cast<double>(n) - 1);
+        }
+    }
+};
+
+const GuessTables& guess_tables() {
+    static const GuessTables tables;
+    return tables;
+}
+
+}  // namespace
+
+StrengthEstimator::~StrengthEstimator() {
+    clear();
+}
+
+void StrengthEstimator::clear() {
+    secure_wipe(password_);
+    positions_.clear();
+    result_ = StrengthResult();
+}
+
+StrengthResult StrengthEstimator::estimate(string_view password) {
+    StrengthEstimator estimator;
+    return estimator.update(password);
+}
+
+const StrengthResult& StrengthEstimator::update(string_view password) {
+    password = password.substr(0, min(password.size(), MAX_LENGTH));
+
+    size_t common = 0;
+    while (common < password.size() && common < password_.size() &&
+           password[common] == password_[common]) {
+        ++common;
+    }
+    if (common == password.size() && common == password_.size()) return result_;
+
+    // Буфер сразу на MAX_LENGTH: дописывание не переносит пароль, оставляя копию
+    if (password_.capacity() < MAX_LENGTH) password_.reserve(MAX_LENGTH);
+    secure_zero(password_.data() + common, password_.size() - common);
+    password_.resize(common);
+    password_.append(password.substr(common));
+
+    // Позиции за концом пароля не удаляются: их векторы переиспользуются без выделений
+    if (positions_.size() < password_.size()) positions_.resize(password_.size());
+    for (size_t k = common; k < password_.size(); ++k) {
+        positions_[k].matches.clear();
+        positions_[k].best.clear();
+        extend(k);
+    }
+    finish();
+    return result_;
+}
+
+void StrengthEstimator::extend(size_t k) {
+    match_dictionary(k);
+    match_spatial(k);
+    match_sequence(k);
+    match_repeat(k);
+    match_date(k);
+    optimize(k);
+}
+
+void StrengthEstimator::match_dictionary(size_t k) {
+    for (size_t i = 0; i < size(strength_dicts::tries); ++i) {
+        DictionaryWalk walk{strength_dicts::tries[i], static_cast<uint8_t>(i), password_, k,
+                            positions_[k].matches, {}};
+        walk.walk(0, 0);
+    }
+}
+
+void StrengthEstimator::match_spatial(size_t k) {
+    const Keyboard& keyboard = qwerty();
+    Position&       cur      = positions_[k];
+    uint8_t         c        = static_cast<uint8_t>(password_[k]);
+    int dir = k > 0 ? keyboard.direction(static_cast<uint8_t>(password_[k - 1]), c) : -1;
+
+    if (dir < 0) {
+        cur.spatialStart = static_cast<uint16_t>(k);
+        cur.spatialTurns = 0;
+        cur.spatialDir   = -1;
+        cur.spatialShift = keyboard.keys[c].shifted;
+        return;
+    }
+
+    const Position& prev = positions_[k - 1];
+    cur.spatialStart     = prev.spatialStart;
+    cur.spatialTurns     = prev.spatialTurns + (dir != prev.spatialDir);
+    cur.spatialDir       = static_cast<int8_t>(dir);
+    cur.spatialShift     = prev.spatialShift + keyboard.keys[c].shifted;
+
+    int length = static_cast<int>(k) - cur.spatialStart + 1;
+    if (length < 3) return;
+
+    StrengthMatch match;
+    match.pattern = StrengthMatch::SPATIAL;
+    match.begin   = cur.spatialStart;
+    match.end     = static_cast<uint16_t>(k);
+    match.turns   = cur.spatialTurns;
+    match.guesses = keyboard.guesses(length, cur.spatialTurns, cur.spatialShift);
+    push_match(cur.matches, match);
+}
+
+// Последовательности с постоянным шагом до 5 внутри одного класса: abc, 2468, ZYX
+void StrengthEstimator::match_sequence(size_t k) {
+    auto group = [](char c) {
+        if (islower(static_cast<unsigned char>(c))) return 1;
+        if (isupper(static_cast<unsigned char>(c))) return 2;
+        if (isdigit(static_cast<unsigned char>(c))) return 3;
+        return 0;
+    };
+
+    Position& cur   = positions_[k];
+    int       delta = k > 0 ? password_[k] - password_[k - 1] : 0;
+    if (delta == 0 || abs(delta) > 5 || group(password_[k]) == 0 ||
+        group(password_[k]) != group(password_[k - 1])) {
+        cur.sequenceStart = static_cast<uint16_t>(k);
+        cur.sequenceDelta = 0;
+        return;
+    }
+
+    const Position& prev = positions_[k - 1];
+    cur.sequenceStart    = prev.sequenceDelta == delta ? prev.sequenceStart : uint16_t(k - 1);
+    cur.sequenceDelta    = delta;
+
+    int length = static_cast<int>(k) - cur.sequenceStart + 1;
+    if (length < 3) return;
+
+    // Очевидное начало (a, z, 0, 1, 9) перебирают первым
+    char   first = password_[cur.sequenceStart];
+    double base  = 26;
+    if (strchr("aAzZ019", first)) {
+        base = 4;
+    } else if (isdigit(static_cast<unsigned char>(first))) {
+        base = 10;
+    }
+    if (delta < 0) base *= 2;
+
+    StrengthMatch match;
+    match.pattern = StrengthMatch::SEQUENCE;
+    match.begin   = cur.sequenceStart;
+    match.end     = static_cast<uint16_t>(k);
+    match.guesses = base * length;
+    push_match(cur.matches, match);
+}
+
+// Повтор символа (aaaa) и блока (abcabc): попытки блока, умноженные на число повторов
+void StrengthEstimator::match_repeat(size_t k) {
+    Position& cur   = positions_[k];
+    bool      same  = k > 0 && password_[k] == password_[k - 1];
+    cur.repeatStart = same ? positions_[k - 1].repeatStart : static_cast<uint16_t>(k);
+
+    int run = static_cast<int>(k) - cur.repeatStart + 1;
+    if (run >= 3) {
+        StrengthMatch match;
+        match.pattern = StrengthMatch::REPEAT;
+        match.begin   = cur.repeatStart;
+        match.end     = static_cast<uint16_t>(k);
+        match.guesses = MIN_GUESSES_SINGLE_CHAR * run;
+        push_match(cur.matches, match);
+    }
+
+    string_view password = password_;
+    for (size_t block = 2; block <= MAX_REPEAT_BLOCK && 2 * block <= k + 1; ++block) {
+        if (password[k] != password[k - block]) continue;
+        string_view last = password.substr(k + 1 - block, block);
+        if (password.substr(k + 1 - 2 * block, block) != last) continue;
+        // Блок из одного символа уже покрыт повтором символа
+        if (last.find_first_not_of(last[0]) == string_view::npos) continue;
+
+        size_t count = 2;
+        while ((count + 1) * block <= k + 1 &&
+               password.substr(k + 1 - (count + 1) * block, block) == last) {
+            ++count;
+        }
+
+        StrengthMatch match;
+        match.pattern = StrengthMatch::REPEAT;
+        match.begin   = static_cast<uint16_t>(k + 1 - count * block);
+        match.end     = static_cast<uint16_t>(k);
+        match.guesses = estimate(last).guesses * count;
+        push_match(cur.matches, match);
+    }
+}
+
+// Даты из 4-8 цифр без разделителей или с одинаковыми разделителями (12.05.1990),
+// и отдельные недавние годы
+void StrengthEstimator::match_date(size_t k) {
+    static const char SEPARATORS[] = " /\\_.-";
+
+    if (!isdigit(static_cast<unsigned char>(password_[k]))) return;
+
+    string_view password = password_;
+    for (size_t length = 4; length <= 10 && length <= k + 1; ++length) {
+        string_view s = password.substr(k + 1 - length, length);
+        if (!isdigit(static_cast<unsigned char>(s.front())) ||
+            !isdigit(static_cast<unsigned char>(s.back()))) {
+            continue;
+        }
+
+        int    year      = -1;
+        double separator = 1;
+        if (all_digits(s)) {
+            if (length == 4) {
+                int value = digits_value(s);
+                if (value >= 1900 && value <= 2039) year = value;
+            }
+            for (int a = 1; a <= 4 && length <= 8; ++a) {
+                for (int b = 1; b <= 4 && a + b < static_cast<int>(length); ++b) {
+                    int c = static_cast<int>(length) - a - b;
+                    if (c > 4) continue;
+
+                    int values[] = {digits_value(s.substr(0, a)), digits_value(s.substr(a, b)),
+                                    digits_value(s.substr(a + b))};
+                    int digits[] = {a, b, c};
+                    int parsed   = parse_date(values, digits);
+                    if (parsed >= 0 && (year < 0 || abs(parsed - reference_year()) <
+                                                        abs(year - reference_year()))) {
+                        year = parsed;
+                    }
+                }
+            }
+        } else if (length >= 6) {
+            size_t first = s.find_first_not_of("0123456789");
+            size_t last  = s.find_last_not_of("0123456789");
+            if (first == last || s[first] != s[last] || !strchr(SEPARATORS, s[first])) continue;
+
+            string_view parts[] = {s.substr(0, first), s.substr(first + 1, last - first - 1),
+                                   s.substr(last + 1)};
+            if (parts[1].empty() || !all_digits(parts[1])) continue;
+            if (parts[0].size() > 4 || parts[1].size() > 4 || parts[2].size() > 4) continue;
+
+            int values[3], digits[3];
+            for (int i = 0; i < 3; ++i) {
+                values[i] = digits_value(parts[i]);
+                digits[i] = static_cast<int>(parts[i].size());
+            }
+            year      = parse_date(values, digits);
+            separator = 4;
+        }
+        if (year < 0) continue;
+
+        double guesses = max(abs(year - reference_year()), MIN_YEAR_SPACE) * separator;
+        // Отдельный год - сам по себе, полная дата - ещё и день года
+        if (!(length == 4 && separator == 1 && digits_value(s) == year)) guesses *= 365;
+
+        StrengthMatch match;
+        match.pattern = StrengthMatch::DATE;
+        match.begin   = static_cast<uint16_t>(k + 1 - length);
+        match.end     = static_cast<uint16_t>(k);
+        match.guesses = guesses;
+        push_match(positions_[k].matches, match);
+    }
+}
+
+// Разбор префикса до k: для каждого числа фрагментов l - минимальное произведение
+// попыток. Итог zxcvbn - l! * произведение + 10000^(l - 1), поэтому при равном l
+// достаточно минимума произведения, а разбор из большего числа фрагментов с не меньшим
+// произведением никогда не выиграет и отбрасывается. У случайных паролей из коротких
+// словарных фрагментов длин много, поэтому кандидаты собираются в массив по длине
+void StrengthEstimator::optimize(size_t k) {
+    const auto& powers = guess_tables().bruteforce;
+    Position&   cur    = positions_[k];
+
+    // Разбор префикса до k - не больше k + 1 фрагментов
+    candidates_.assign(k + 2, Step{INFINITY_PI, 0, {}});
+    auto consider = [&](uint16_t length, double pi, const StrengthMatch& match) {
+        Step& step = candidates_[length];
+        if (pi < step.pi) step = Step{pi, length, match};
+    };
+    auto relax = [&](const StrengthMatch& match) {
+        if (match.begin == 0) {
+            consider(1, match.guesses, match);
+            return;
+        }
+        for (const auto& prev : positions_[match.begin - 1].best) {
+            consider(prev.length + 1, prev.pi * match.guesses, match);
+        }
+    };
+
+    for (const auto& match : cur.matches) relax(match);
+
+    // Перебор [i, k] для всех i сразу. Попытки перебора - степени BRUTEFORCE_CARDINALITY
+    // (не меньше минимумов), поэтому из двух перебор, дешевле до k - 1, дешевле и до k:
+    // достаточно продлить лучшие переборы прошлой позиции и начать новый после её разборов
+    auto bruteforce = [&](uint16_t length, double base, uint16_t begin) {
+        double pi = base * powers[k - begin + 1];
+        for (auto& step : cur.bruteforce) {
+            if (step.length != length) continue;
+            if (pi < step.pi * powers[k - step.match.begin + 1]) {
+                step.pi          = base;
+                step.match.begin = begin;
+            }
+            return;
+        }
+        StrengthMatch match;
+        match.pattern = StrengthMatch::BRUTEFORCE;
+        match.begin   = begin;
+        cur.bruteforce.push_back(Step{base, length, match});
+    };
+    cur.bruteforce.clear();
+    if (k == 0) {
+        bruteforce(1, 1, 0);
+    } else {
+        const Position& prev = positions_[k - 1];
+        for (const auto& step : prev.bruteforce) bruteforce(step.length, step.pi, step.match.begin);
+        // Два перебора подряд не лучше одного общего
+        for (const auto& step : prev.best) {
+            if (step.match.pattern == StrengthMatch::BRUTEFORCE) continue;
+            bruteforce(step.length + 1, step.pi, static_cast<uint16_t>(k));
+        }
+    }
+    for (auto& step : cur.bruteforce) {
+        step.match.end     = static_cast<uint16_t>(k);
+        step.match.guesses = powers[k - step.match.begin + 1];
+        consider(step.length, step.pi * step.match.guesses, step.match);
+    }
+
+    double bestPi = INFINITY_PI;
+    for (const auto& step : candidates_) {
+        if (step.pi >= bestPi) continue;
+        cur.best.push_back(step);
+        bestPi = step.pi;
+    }
+}
+
+void StrengthEstimator::finish() {
+    result_ = StrengthResult();
+    if (password_.empty()) return;
+
+    const GuessTables& tables     = guess_tables();
+    size_t             bestLength = 0;
+    double             guesses    = INFINITY_PI;
+    for (const auto& step : positions_[password_.size() - 1].best) {
+        double g = tables.factorial[step.length] * step.pi + tables.growing[step.length];
+        if (g < guesses) {
+            guesses    = g;
+            bestLength = step.length;
+        }
+    }
+
+    // Назад по позициям: разбор из l фрагментов до k кончается match, перед ним - l - 1
+    for (size_t k = password_.size() - 1, l = bestLength; l > 0; --l) {
+        const auto& best = positions_[k].best;
+        auto step = find_if(best.begin(), best.end(), [&](const Step& s) { return s.length == l; });
+        const StrengthMatch& match = step->match;
+        result_.sequence.push_back(match);
+        if (match.begin == 0) break;
+        k = match.begin - 1;
+    }
+    reverse(result_.sequence.begin(), result_.sequence.end());
+
+    result_.guesses       = guesses;
+    result_.guesses_log10 = log10(guesses);
+    result_.score         = 4;
+    for (double threshold : {1e10, 1e8, 1e6, 1e3}) {
+        if (guesses < threshold + 5) --result_.score;
+    }
+    result_.percent = static_cast<int>(clamp(lround(result_.guesses_log10 * 7), 0L, 100L));
+    if (result_.score > 2) return;
+
+    // Подсказка по самому длинному узнанному фрагменту
+    const StrengthMatch* longest = nullptr;
+    for (const auto& match : result_.sequence) {
+        if (match.pattern == StrengthMatch::BRUTEFORCE) continue;
+        if (!longest || match.end - match.begin > longest->end - longest->begin) longest = &match;
+    }
+    if (!longest) return;
+
+    static const int passwords = dictionary_index("passwords");
+    switch (longest->pattern) {
+        case StrengthMatch::DICTIONARY:
+            if (longest->dictionary != passwords) {
+                result_.warning = result_.sequence.size() == 1 ? "A word by itself is easy to guess"
+                                                               : "Common words are easy to guess";
+            } else if (longest->rank <= 10) {
+                result_.warning = "This is a top-10 common password";
+            } else if (longest->rank <= 100) {
+                result_.warning = "This is a top-100 common password";
+            } else {
+                result_.warning = "This is a very common password";
+            }
+            break;
+        case StrengthMatch::SPATIAL:
+            result_.warning = longest->turns == 1 ? "Straight rows of keys are easy to guess"
+                                                  : "Short keyboard patterns are easy to guess";
+            break;
+        case StrengthMatch::SEQUENCE:
+            result_.warning = "Sequences like abc or 6543 are easy to guess";
+            break;
+        case StrengthMatch::REPEAT:
+            result_.warning = "Repeats like \"aaa\" or \"abcabc\" are easy to guess";
+            break;
+        case StrengthMatch::DATE:
+            result_.warning = "Dates and years are easy to guess";
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef STRENGTH_ESTIMATOR_H
+#define STRENGTH_ESTIMATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Фрагмент пароля, узнанный оценщиком, и число попыток, за которое его подберут
+struct StrengthMatch {
+    enum Pattern : uint8_t { BRUTEFORCE, DICTIONARY, SPATIAL, SEQUENCE, REPEAT, DATE };
+
+    Pattern  pattern    = BRUTEFORCE;
+    uint8_t  dictionary = 0;  // DICTIONARY: номер словаря в strength_dicts::tries
+    uint16_t begin      = 0;  // Первый символ фрагмента
+    uint16_t end        = 0;  // Последний символ, включительно
+    uint16_t turns      = 0;  // SPATIAL: число поворотов на клавиатуре
+    uint32_t rank       = 0;  // DICTIONARY: ранг слова по частоте
+    double   guesses    = 0;
+};
+
+struct StrengthResult {
+    double      guesses       = 1;  // Попыток до подбора при оптимальном разборе
+    double      guesses_log10 = 0;
+    int         score         = 0;  // 0-4, пороги как у zxcvbn (10^3, 10^6, 10^8, 10^10)
+    int         percent       = 0;  // 0-100 для индикатора: 7 за каждый порядок попыток
+    std::string warning;            // Почему пароль слабый, пусто для стойких
+
+    std::vector<StrengthMatch> sequence;  // Разбор пароля с минимальным числом попыток
+};
+
+// Оценка стойкости пароля в духе zxcvbn: пароль раскладывается на словарные слова
+// (с заглавными и заменами вроде @ вместо a), клавиатурные дорожки, последовательности,
+// повторы и даты, а оставшиеся символы считаются перебором. Итог - минимальное по всем
+// разборам число попыток.
+//
+// Словари собраны при сборке в префиксные деревья (strength_dict_compile), поэтому
+// при запуске ничего не разбирается. Все совпадения и разбор хранятся по позиции, где
+// они заканчиваются, и зависят только от символов до неё: update пересчитывает лишь
+// хвост после общего с прошлым вызовом префикса, то есть на каждое нажатие клавиши -
+// одну позицию.
+class StrengthEstimator {
+   public:
+    // Символы дальше не оцениваются: такой пароль и так не подобрать перебором
+    static constexpr size_t MAX_LENGTH = 100;
+
+    StrengthEstimator() = default;
+    ~StrengthEstimator();
+
+    StrengthEstimator(const StrengthEstimator&)            = delete;
+    StrengthEstimator& operator=(const StrengthEstimator&) = delete;
+
+    const StrengthResult& update(std::string_view password);
+    // Забывает пароль прошлого вызова (с затиранием)
+    void clear();
+
+    // Оценка без сохранения состояния
+    static StrengthResult estimate(std::string_view password);
+
+   private:
+    struct Step {
+        double        pi     = 0;  // Произведение попыток фрагментов разбора
+        uint16_t      length = 0;  // Число фрагментов
+        StrengthMatch match;       // Последний фрагмент разбора
+    };
+
+    // Совпадения, которые заканчиваются в позиции, и состояние поиска для следующей
+    struct Position {
+        std::vector<StrengthMatch> matches;
+        std::vector<Step>          best;  // Лучшие разборы префикса по возрастанию length
+        // Лучшие разборы, кончающиеся перебором до этой позиции, по length; pi - без перебора
+        std::vector<Step> bruteforce;
+
+        uint16_t spatialStart  = 0;
+        uint16_t spatialTurns  = 0;
+        uint16_t spatialShift  = 0;  // Символов с Shift в дорожке
+        int8_t   spatialDir    = -1;
+        uint16_t sequenceStart = 0;
+        int      sequenceDelta = 0;
+        uint16_t repeatStart   = 0;
+    };
+
+    void extend(size_t k);
+    void match_dictionary(size_t k);
+    void match_spatial(size_t k);
+    void match_sequence(size_t k);
+    void match_repeat(size_t k);
+    void match_date(size_t k);
+    void optimize(size_t k);
+    void finish();
+
+    std::string           password_;
+    std::vector<Position> positions_;
+    std::vector<Step>     candidates_;  // optimize: лучший разбор по числу фрагментов
+    StrengthResult        result_;
+};
+
+#endif
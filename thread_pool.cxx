@@ -0,0 +1,64 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t i = 1; i < threads; ++i) workers_.emplace_back(&ThreadPool::worker, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(max(1u, thread::hardware_concurrency()));
+    return pool;
+}
+
+void ThreadPool::run(size_t count, const function<void(size_t)>& task) {
+    if (count == 0) return;
+    if (count == 1 || workers_.empty()) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    lock_guard<mutex>  runLock(runMutex_);
+    unique_lock<mutex> lock(mutex_);
+    task_  = &task;
+    count_ = count;
+    next_  = 0;
+    ++job_;
+    wake_.notify_all();
+
+    drain(lock);
+    done_.wait(lock, [this] { return next_ == count_ && running_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::drain(unique_lock<mutex>& lock) {
+    while (task_ && next_ < count_) {
+        size_t index = next_++;
+        auto&  task  = *task_;
+        ++running_;
+        lock.unlock();
+        task(index);
+        lock.lock();
+        if (--running_ == 0 && next_ == count_) done_.notify_all();
+    }
+}
+
+void ThreadPool::worker() {
+    unique_lock<mutex> lock(mutex_);
+    uint64_t           seen = 0;
+    while (true) {
+        wake_.wait(lock, [&] { return stopping_ || job_ != seen; });
+        if (stopping_) break;
+        seen = job_;
+        drain(lock);
+    }
+}
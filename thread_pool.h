@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул рабочих потоков для задач, которые делятся на независимые части
+// (полосы Argon2id). Потоки создаются один раз и ждут работы.
+class ThreadPool {
+   public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Выполняет task(0..count-1) на потоках пула и вызывающем потоке, возвращается,
+    // когда все части готовы. Вызовы из разных потоков выполняются по очереди.
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+    size_t size() const { return workers_.size() + 1; }
+
+    // Общий пул на все ядра машины
+    static ThreadPool& shared();
+
+   private:
+    void worker();
+    // Берёт и выполняет части текущей работы, пока они есть
+    void drain(std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread> workers_;
+    std::mutex               runMutex_;  // Одна работа за раз
+
+    std::mutex                         mutex_;
+    std::condition_variable            wake_;
+    std::condition_variable            done_;
+    const std::function<void(size_t)>* task_     = nullptr;
+    size_t                             count_    = 0;
+    size_t                             next_     = 0;  // Следующая невзятая часть
+    size_t                             running_  = 0;  // Части, которые сейчас выполняются
+    uint64_t                           job_      = 0;  // Номер работы, будит потоки
+    bool                               stopping_ = false;
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include "vault_audit.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#include "database.h"
+#include "kdf.h"
+#include "secure_arena.h"
+#include "strength_estimator.h"
+#include "vault_format.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t ROWS_PER_TASK = 512;
+constexpr size_t DIGEST_SIZE   = 16;
+
+using Digest = array<uint8_t, DIGEST_SIZE>;
+
+// BLAKE2b от соли и полей (с нулём между ними); buffer затирается
+Digest salted_digest(const uint8_t* salt, string_view first, string_view second, string& buffer) {
+    buffer.assign(reinterpret_cast<const char*>(salt), SALT_SIZE);
+    buffer.append(first);
+    buffer.push_back('\0');
+    buffer.append(second);
+
+    Digest digest;
+    blake2b(buffer.data(), buffer.size(), digest.data(), digest.size());
+    secure_wipe(buffer);
+    return digest;
+}
+
+// Группы строк с одинаковым хешем. Таблица разбита на части по последнему байту хеша,
+// у каждой своя блокировка, и потоки почти не ждут друг друга. Внутри части - открытая
+// адресация по первым байтам хеша: место под все строки выделяется заранее, и вставка
+// не выделяет память. Строки группы связаны списком через next_
+class DigestGroups {
+   public:
+    struct Group {
+        uint32_t first = 0;  // Строка, вставленная первой
+        uint32_t head  = 0;  // Последняя вставленная, остальные - по next_
+        uint32_t count = 0;  // 0 - ячейка свободна
+    };
+
+    explicit DigestGroups(size_t rows) : next_(rows) {
+        // Заполнение не выше 3/4 при равномерном разбиении; перекос исправит grow
+        size_t slots = bit_ceil(rows * 4 / 3 / SHARDS + 8);
+        for (auto& shard : shards_) shard.slots.resize(slots);
+    }
+
+    // true - строка первая со своим хешем
+    bool insert(const Digest& digest, uint32_t row) {
+        Shard&            shard = shards_[digest[DIGEST_SIZE - 1] % SHARDS];
+        lock_guard<mutex> lock(shard.lock);
+
+        if ((shard.used + 1) * 4 > shard.slots.size() * 3) grow(shard);
+        Slot& slot     = find(shard.slots, digest);
+        bool  inserted = slot.group.count == 0;
+        if (inserted) {
+            slot.digest      = digest;
+            slot.group.first = row;
+            ++shard.used;
+        } else {
+            next_[row] = slot.group.head;
+        }
+        slot.group.head = row;
+        ++slot.group.count;
+        return inserted;
+    }
+
+    // Группы из нескольких строк по убыванию размера (вызывать после всех insert)
+    vector<Group> repeated() const {
+        vector<Group> groups;
+        for (const auto& shard : shards_) {
+            for (const auto& slot : shard.slots) {
+                if (slot.group.count > 1) groups.push_back(slot.group);
+            }
+        }
+        sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) {
+            return a.count != b.count ? a.count > b.count : a.first < b.first;
+        });
+        return groups;
+    }
+
+    template <typename Fn>
+    void for_each_row(const Group& group, Fn fn) const {
+        uint32_t row = group.head;
+        for (uint32_t i = 0; i < group.count; ++i, row = next_[row]) fn(row);
+    }
+
+   private:
+    static constexpr size_t SHARDS = 64;
+
+    struct Slot {
+        Digest digest;
+        Group  group;
+    };
+
+    struct Shard {
+        mutex        lock;
+        vector<Slot> slots;  // Размер - степень двойки
+        size_t       used = 0;
+    };
+
+    static Slot& find(vector<Slot>& slots, const Digest& digest) {
+        size_t hash;
+        memcpy(&hash, digest.data(), sizeof(hash));
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            if (slots[i].group.count == 0 || slots[i].digest == digest) return slots[i];
+        }
+    }
+
+    static void grow(Shard& shard) {
+        vector<Slot> old = move(shard.slots);
+        shard.slots.assign(old.size() * 2, Slot{});
+        for (const auto& slot : old) {
+            if (slot.group.count) find(shard.slots, slot.digest) = slot;
+        }
+    }
+
+    array<Shard, SHARDS> shards_;
+    vector<uint32_t>     next_;
+};
+
+// Поля CSV в кавычках по необходимости. Значение, с которого начинается формула
+// (= + - @), предваряется апострофом, чтобы таблица не выполнила название записи
+string csv_field(string_view value) {
+    string field;
+    if (!value.empty() && strchr("=+-@", value[0])) field += '\'';
+    field += value;
+    if (field.find_first_of(",\"\r\n") == string::npos) return field;
+
+    string quoted = "\"";
+    for (char c : field) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+}  // namespace
+
+AuditReport db_audit(const EntryTable& entries, const VaultKey* key, const BreachCorpus* breaches,
+                     ThreadPool& pool) {
+    auto start = chrono::steady_clock::now();
+
+    size_t      rows = entries.size();
+    AuditReport report;
+    report.entries = rows;
+
+    uint8_t salt[SALT_SIZE];
+    fill_random(salt, sizeof(salt));
+
+    DigestGroups    passwords(rows), names(rows);
+    vector<uint8_t>  scores(rows, 0), strengths(rows, 0), unreadable(rows, 0);
+    vector<uint32_t> breached(rows, 0);
+    vector<string>   warnings(rows);
+    if (breaches && !breaches->is_open()) breaches = nullptr;
+
+    // Каждый различный пароль оценивается и сверяется с утечками только в строке, первой
+    // вставившей его хеш; остальные строки группы получают результат на втором проходе
+    size_t tasks = (rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    pool.run(tasks, [&](size_t task) {
+        StrengthEstimator estimator;
+        string            password, buffer;
+
+        size_t end = min(rows, (task + 1) * ROWS_PER_TASK);
+        for (size_t row = task * ROWS_PER_TASK; row < end; ++row) {
+            EntryRef entry = entries[row];
+            uint32_t index = static_cast<uint32_t>(row);
+            names.insert(salted_digest(salt, entry.title, entry.login, buffer), index);
+
+            bool readable = true;
+            if (entry.sealed_password.empty()) {
+                password.assign(entry.password);
+            } else {
+                readable = key && db_reveal_password(entry, *key, password);
+            }
+            if (!readable) {
+                unreadable[row] = 1;
+                continue;
+            }
+
+            if (passwords.insert(salted_digest(salt, password, {}, buffer), index)) {
+                const StrengthResult& result = estimator.update(password);
+                scores[row]                  = static_cast<uint8_t>(result.score);
+                strengths[row]               = static_cast<uint8_t>(result.percent);
+                if (result.score <= AUDIT_WEAK_SCORE) warnings[row] = result.warning;
+                if (breaches) breached[row] = breaches->check(password);
+            }
+            secure_wipe(password);
+        }
+        estimator.clear();
+    });
+
+    vector<uint32_t> reuseGroups(rows, 0), reusedWith(rows, 0), duplicateGroups(rows, 0);
+
+    vector<DigestGroups::Group> reused = passwords.repeated();
+    report.reuse_groups                = reused.size();
+    for (size_t g = 0; g < reused.size(); ++g) {
+        const auto& group = reused[g];
+        passwords.for_each_row(group, [&](uint32_t row) {
+            reuseGroups[row] = static_cast<uint32_t>(g + 1);
+            reusedWith[row]  = group.count - 1;
+            scores[row]      = scores[group.first];
+            strengths[row]   = strengths[group.first];
+            breached[row]    = breached[group.first];
+            if (row != group.first) warnings[row] = warnings[group.first];
+        });
+        report.reused += group.count;
+    }
+
+    vector<DigestGroups::Group> duplicates = names.repeated();
+    report.duplicate_groups                = duplicates.size();
+    for (size_t g = 0; g < duplicates.size(); ++g) {
+        names.for_each_row(duplicates[g], [&](uint32_t row) {
+            duplicateGroups[row] = static_cast<uint32_t>(g + 1);
+        });
+        report.duplicates += duplicates[g].count;
+    }
+
+    for (size_t row = 0; row < rows; ++row) {
+        AuditFinding finding;
+        finding.score           = scores[row];
+        finding.unreadable      = unreadable[row] != 0;
+        finding.reuse_group     = reuseGroups[row];
+        finding.duplicate_group = duplicateGroups[row];
+        finding.breached        = breached[row];
+        if (!finding.unreadable && !finding.weak() && finding.breached == 0 &&
+            finding.reuse_group == 0 && finding.duplicate_group == 0) {
+            continue;
+        }
+
+        EntryRef entry      = entries[row];
+        finding.id          = entry.id;
+        finding.title       = entry.title;
+        finding.login       = entry.login;
+        finding.strength    = strengths[row];
+        finding.warning     = move(warnings[row]);
+        finding.reused_with = reusedWith[row];
+
+        if (finding.unreadable) ++report.unreadable;
+        if (finding.weak()) ++report.weak;
+        if (finding.breached) ++report.breached;
+        report.findings.push_back(move(finding));
+    }
+
+    sort(report.findings.begin(), report.findings.end(),
+         [](const AuditFinding& a, const AuditFinding& b) {
+             if (a.unreadable != b.unreadable) return a.unreadable;
+             if ((a.breached != 0) != (b.breached != 0)) return a.breached != 0;
+             if (a.score != b.score) return a.score < b.score;
+             if (a.reused_with != b.reused_with) return a.reused_with > b.reused_with;
+             return a.title < b.title;
+         });
+
+    secure_zero(salt, sizeof(salt));
+    report.elapsed_ms =
+        chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+bool db_export_audit(const AuditReport& report, const string& path) {
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) return false;
+
+    out << "id,title,login,score,strength,reuse_group,reused_with,duplicate_group,breached,"
+           "unreadable,warning\n";
+    for (const auto& f : report.findings) {
+        out << f.id << ',' << csv_field(f.title) << ',' << csv_field(f.login) << ',' << f.score
+            << ',' << f.strength << ',' << f.reuse_group << ',' << f.reused_with << ','
+            << f.duplicate_group << ',' << f.breached << ',' << (f.unreadable ? 1 : 0) << ','
+            << csv_field(f.warning) << '\n';
+    }
+    out.flush();
+    return out.good();
+}
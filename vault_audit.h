@@ -0,0 +1,64 @@
+#ifndef VAULT_AUDIT_H
+#define VAULT_AUDIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "breach_corpus.h"
+#include "entry_table.h"
+#include "thread_pool.h"
+#include "vault_key.h"
+
+// Слабым считается пароль с оценкой StrengthEstimator не выше этой (до 10^8 попыток)
+constexpr int AUDIT_WEAK_SCORE = 2;
+
+// Запись с проблемами: слабый, утёкший или повторяющийся пароль, дубль названия и логина
+struct AuditFinding {
+    uint64_t    id = 0;
+    std::string title;
+    std::string login;
+    int         score    = 0;  // 0-4, StrengthEstimator
+    int         strength = 0;  // 0-100, как password_strength
+    std::string warning;       // Подсказка оценщика для слабого пароля
+
+    uint32_t reuse_group     = 0;  // Группа записей с одинаковым паролем (с 1), 0 - нет
+    uint32_t reused_with     = 0;  // Сколько ещё записей с тем же паролем
+    uint32_t duplicate_group = 0;  // Группа записей с тем же названием и логином (с 1), 0 - нет
+    uint32_t breached        = 0;  // Сколько раз пароль встречался в утечках, 0 - нет
+    bool     unreadable      = false;  // Запечатанный пароль не расшифровался
+
+    bool weak() const { return !unreadable && score <= AUDIT_WEAK_SCORE; }
+};
+
+struct AuditReport {
+    size_t entries          = 0;
+    size_t weak             = 0;
+    size_t reused           = 0;  // Записей, чей пароль есть ещё где-то
+    size_t reuse_groups     = 0;
+    size_t duplicates       = 0;  // Записей с повторяющимися названием и логином
+    size_t duplicate_groups = 0;
+    size_t breached         = 0;  // Записей с паролем из файла утечек
+    size_t unreadable       = 0;
+    double elapsed_ms       = 0;
+
+    // Только записи с проблемами: сначала нерасшифрованные, затем утёкшие, затем по
+    // возрастанию стойкости и по убыванию числа повторов
+    std::vector<AuditFinding> findings;
+};
+
+// Проверка всех записей. Пароли расшифровываются и оцениваются частями на потоках pool;
+// одинаковые находятся по хешу (BLAKE2b со случайной на проверку солью) в общей таблице,
+// разбитой на части со своими блокировками, поэтому каждый различный пароль оценивается
+// один раз. key - ключ хранилища для запечатанных паролей (nullptr - их нет), breaches -
+// открытый файл утечек, по которому сверяется каждый различный пароль (nullptr - без
+// сверки). Записи не должны меняться во время проверки
+AuditReport db_audit(const EntryTable& entries, const VaultKey* key,
+                     const BreachCorpus* breaches = nullptr,
+                     ThreadPool&         pool     = ThreadPool::shared());
+
+// Отчёт в CSV: по строке на запись с проблемами, без паролей
+bool db_export_audit(const AuditReport& report, const std::string& path);
+
+#endif
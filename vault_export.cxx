@@ -0,0 +1,160 @@
+#include "vault_export.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "database.h"
+#include "file_sync.h"
+#include "secure_arena.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t EXPORT_BUFFER = 64 * 1024;
+
+// Буфер выгрузки поверх временного файла. В нём пароли открытым текстом, поэтому
+// после каждого сброса и в конце он затирается. Ошибка записи запоминается, и
+// остальная выгрузка только проходит вхолостую
+class ExportWriter {
+   public:
+    explicit ExportWriter(file_sync::AtomicFile& file) : file_(file) {}
+    ~ExportWriter() { secure_zero(buffer_.data(), buffer_.size()); }
+
+    void put(char c) {
+        if (used_ == buffer_.size()) flush();
+        buffer_[used_++] = c;
+    }
+
+    void write(string_view s) {
+        while (!s.empty()) {
+            if (used_ == buffer_.size()) flush();
+            size_t n = min(s.size(), buffer_.size() - used_);
+            memcpy(buffer_.data() + used_, s.data(), n);
+            used_ += n;
+            s.remove_prefix(n);
+        }
+    }
+
+    bool flush() {
+        ok_ = ok_ && file_.write(string_view(buffer_.data(), used_));
+        secure_zero(buffer_.data(), used_);
+        used_ = 0;
+        return ok_;
+    }
+
+    // Поле CSV: в кавычках, если в нём есть разделитель, кавычка, перевод строки или
+    // пробел по краям. Апостроф против формул здесь не ставится: он изменил бы пароль
+    void csv(string_view value) {
+        bool quote = value.find_first_of(",\"\r\n") != string_view::npos ||
+                     (!value.empty() && (value.front() == ' ' || value.back() == ' '));
+        if (!quote) return write(value);
+
+        put('"');
+        for (char c : value) {
+            if (c == '"') put('"');
+            put(c);
+        }
+        put('"');
+    }
+
+    // Строка JSON: экранируются кавычка, обратная черта и управляющие символы
+    void json(string_view value) {
+        static const char hex[] = "0123456789abcdef";
+
+        put('"');
+        for (char c : value) {
+            auto u = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(c);
+            } else if (c == '\n') {
+                write("\\n");
+            } else if (c == '\r') {
+                write("\\r");
+            } else if (c == '\t') {
+                write("\\t");
+            } else if (u < 0x20) {
+                write("\\u00");
+                put(hex[u >> 4]);
+                put(hex[u & 0xf]);
+            } else {
+                put(c);
+            }
+        }
+        put('"');
+    }
+
+   private:
+    file_sync::AtomicFile&     file_;
+    array<char, EXPORT_BUFFER> buffer_;
+    size_t                     used_ = 0;
+    bool                       ok_   = true;
+};
+
+}  // namespace
+
+bool db_parse_export_format(string_view name, ExportFormat& format) {
+    if (name == "csv") {
+        format = ExportFormat::Csv;
+    } else if (name == "json") {
+        format = ExportFormat::Json;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ExportFormat db_export_format_for(const string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos) return ExportFormat::Csv;
+
+    string ext = path.substr(dot + 1);
+    for (char& c : ext) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    return ext == "json" ? ExportFormat::Json : ExportFormat::Csv;
+}
+
+bool db_export(const EntryTable& entries, const VaultKey* key, const string& path,
+               ExportFormat format) {
+    file_sync::AtomicFile file;
+    if (!file.open(path)) return false;
+
+    bool         json = format == ExportFormat::Json;
+    ExportWriter out(file);
+    string       password;
+    out.write(json ? "{\n  \"encrypted\": false,\n  \"folders\": [],\n  \"items\": ["
+                   : "title,login,password,favorite\n");
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        EntryRef entry = entries[i];
+        if (entry.sealed_password.empty()) {
+            password.assign(entry.password);
+        } else if (!key || !db_reveal_password(entry, *key, password)) {
+            secure_wipe(password);
+            return false;  // Временный файл удалит AtomicFile
+        }
+
+        if (json) {
+            out.write(i ? ",\n    {\"type\": 1, \"name\": " : "\n    {\"type\": 1, \"name\": ");
+            out.json(entry.title);
+            out.write(entry.is_favorite ? ", \"favorite\": true" : ", \"favorite\": false");
+            out.write(", \"notes\": null, \"login\": {\"username\": ");
+            out.json(entry.login);
+            out.write(", \"password\": ");
+            out.json(password);
+            out.write(", \"uris\": []}}");
+        } else {
+            out.csv(entry.title);
+            out.put(',');
+            out.csv(entry.login);
+            out.put(',');
+            out.csv(password);
+            out.write(entry.is_favorite ? ",1\n" : ",0\n");
+        }
+        secure_wipe(password);
+    }
+    if (json) out.write(entries.size() ? "\n  ]\n}\n" : "]\n}\n");
+
+    return out.flush() && file.commit();
+}
@@ -0,0 +1,31 @@
+#ifndef VAULT_EXPORT_H
+#define VAULT_EXPORT_H
+
+#include <string>
+#include <string_view>
+
+#include "entry_table.h"
+#include "vault_key.h"
+
+// Открытые выгрузки для переноса в другие менеджеры паролей. Зашифрованная копия
+// хранилища - это db_save_file под другим именем (Save As)
+enum class ExportFormat {
+    Csv,   // title,login,password,favorite: читают импорт hush и большинство менеджеров
+    Json,  // Незашифрованный JSON в формате Bitwarden
+};
+
+// Формат по имени: csv или json; false - имя неизвестно
+bool db_parse_export_format(std::string_view name, ExportFormat& format);
+// По расширению файла: .json - JSON, остальное - CSV
+ExportFormat db_export_format_for(const std::string& path);
+
+// Выгрузка всех записей с паролями открытым текстом. Записи сериализуются по одной
+// через буфер постоянного размера, который по заполнении уходит в файл, а в конце
+// затирается; запечатанные пароли расшифровываются тоже по одному, поэтому память не
+// зависит от размера хранилища. Файл (права 0600) собирается во временном рядом и
+// подменяет старый только целиком. key - ключ хранилища для запечатанных паролей.
+// false - файл не записан или пароль какой-то записи не расшифровался
+bool db_export(const EntryTable& entries, const VaultKey* key, const std::string& path,
+               ExportFormat format);
+
+#endif
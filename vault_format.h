@@ -0,0 +1,49 @@
+#ifndef VAULT_FORMAT_H
+#define VAULT_FORMAT_H
+
+// Внутренние детали формата файла, общие для database.cxx и journal.cxx
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "cipher.h"
+#include "database.h"
+
+constexpr size_t SALT_SIZE = 16;
+constexpr size_t KEY_SIZE  = 32;
+
+// Запечатанный блок или запись журнала: nonce, шифротекст, код подлинности
+constexpr size_t SEALED_OVERHEAD = CHACHA_NONCE_SIZE + POLY1305_TAG_SIZE;
+
+// Ключ файла из мастер-пароля и соли: Argon2id с параметрами из заголовка v2, а при пустых
+// параметрах - derive_key_simple для v1. Вырабатывается заново при каждом вызове;
+// открытое хранилище держит его в VaultKey
+bool derive_file_key(const std::string& password, const uint8_t* salt, const KdfParams& kdf,
+                     uint8_t* key);
+
+// Запечатывает sealed на ключе файла: первые CHACHA_NONCE_SIZE байт заполняются nonce,
+// остальное шифруется на месте, в конец дописывается код подлинности над ad и шифротекстом
+void seal_payload(std::string& sealed, const uint8_t* fileKey, const uint8_t* ad, size_t adLen);
+// Проверяет код и расшифровывает на месте; plain указывает внутрь data.
+// false - данные, связанные данные или ключ не те
+bool open_payload(uint8_t* data, size_t size, const uint8_t* fileKey, const uint8_t* ad,
+                  size_t adLen, uint8_t*& plain, size_t& plainSize);
+
+void fill_random(uint8_t* out, size_t len);
+
+// FNV-1a: контрольные суммы и отпечаток заголовка, не криптография
+uint64_t fnv1a64(const void* data, size_t len);
+
+void write_entry(std::string& out, const EntryRef& entry);
+// Сколько байт добавит write_entry. Буфер с открытым текстом резервируется заранее:
+// при росте строки старая память освобождается незатёртой
+size_t entry_size(const EntryRef& entry);
+bool read_entry(const uint8_t* data, size_t size, size_t& pos, EntryRef& entry);
+
+void     put_u32(std::string& out, uint32_t v);
+void     put_u64(std::string& out, uint64_t v);
+uint32_t get_u32(const uint8_t* p);
+uint64_t get_u64(const uint8_t* p);
+
+#endif
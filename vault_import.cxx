@@ -0,0 +1,820 @@
+#include "vault_import.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <unordered_set>
+#include <vector>
+
+#include "secure_arena.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t READ_BUFFER = 64 * 1024;
+constexpr size_t MAX_DEPTH   = 64;       // Вложенность XML и JSON
+constexpr size_t MAX_FIELDS  = 256;      // Столбцов в строке CSV
+constexpr size_t MAX_FIELD   = 1 << 20;  // Поле длиннее мегабайта - не выгрузка паролей
+
+constexpr uint32_t REPLACEMENT_CHARACTER = 0xfffd;  // Вместо непарного суррогата
+
+// Буферизованное чтение выгрузки с подсчётом строк для сообщений об ошибках.
+// В буфере пароли открытым текстом, поэтому он затирается
+class Input {
+   public:
+    explicit Input(istream& in) : in_(in), buffer_(READ_BUFFER) {}
+    ~Input() { secure_zero(buffer_.data(), buffer_.size()); }
+
+    int peek() {
+        if (pos_ == end_ && !fill()) return EOF;
+        return static_cast<unsigned char>(buffer_[pos_]);
+    }
+
+    int get() {
+        int c = peek();
+        if (c == EOF) return EOF;
+        ++pos_;
+        if (c == '\n') ++line_;
+        return c;
+    }
+
+    bool consume(char c) {
+        if (peek() != static_cast<unsigned char>(c)) return false;
+        get();
+        return true;
+    }
+
+    void skip_space() {
+        for (int c = peek(); c == ' ' || c == '\t' || c == '\r' || c == '\n'; c = peek()) get();
+    }
+
+    // BOM UTF-8 в начале файла (его пишут Excel и Windows-версии менеджеров)
+    void skip_bom() {
+        if (!consume('\xef')) return;
+        consume('\xbb');
+        consume('\xbf');
+    }
+
+    size_t line() const { return line_; }
+
+   private:
+    bool fill() {
+        in_.read(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+        end_ = static_cast<size_t>(in_.gcount());
+        pos_ = 0;
+        return end_ > 0;
+    }
+
+    istream&     in_;
+    vector<char> buffer_;
+    size_t       pos_  = 0;
+    size_t       end_  = 0;
+    size_t       line_ = 1;
+};
+
+// Запись выгрузки до сопоставления с PasswordEntry
+struct Record {
+    string title;
+    string login;
+    string password;
+    string url;
+    bool   favorite = false;
+
+    void clear() {
+        title.clear();
+        login.clear();
+        secure_wipe(password);
+        url.clear();
+        favorite = false;
+    }
+};
+
+string lower(string_view s) {
+    string out(s);
+    for (char& c : out) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return out;
+}
+
+// Название по адресу, если его нет (Firefox): https://me@mail.example.com:443/x -> mail.example.com
+string host_of(string_view url) {
+    size_t scheme = url.find("://");
+    if (scheme != string_view::npos) url.remove_prefix(scheme + 3);
+    url = url.substr(0, url.find_first_of("/?#"));
+    size_t at = url.rfind('@');
+    if (at != string_view::npos) url.remove_prefix(at + 1);
+    return string(url.substr(0, url.find(':')));
+}
+
+void append_utf8(string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xc0 | cp >> 6);
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xe0 | cp >> 12);
+        out += static_cast<char>(0x80 | (cp >> 6 & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | cp >> 18);
+        out += static_cast<char>(0x80 | (cp >> 12 & 0x3f));
+        out += static_cast<char>(0x80 | (cp >> 6 & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+}
+
+// Символ после \ в строке JSON, кроме \u; 0 - неизвестная последовательность
+char json_escape(int c) {
+    switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            return static_cast<char>(c);
+        case 'b':
+            return '\b';
+        case 'f':
+            return '\f';
+        case 'n':
+            return '\n';
+        case 'r':
+            return '\r';
+        case 't':
+            return '\t';
+        default:
+            return 0;
+    }
+}
+
+// Общая часть разборщиков: сообщение об ошибке со строкой и выдача записей
+class Reader {
+   public:
+    Reader(Input& in, const ImportSink& sink, string& error)
+        : in_(in), sink_(sink), error_(error) {}
+
+   protected:
+    bool fail(const string& message) {
+        error_ = "line " + to_string(in_.line()) + ": " + message;
+        return false;
+    }
+
+    // Записи без логина и пароля (заметки, карты) не выдаются. Без названия берётся
+    // адрес, без адреса - логин. stopped_ - sink прервал разбор
+    bool emit(Record& record) {
+        if (!record.login.empty() || !record.password.empty()) {
+            entry_.title = !record.title.empty() ? record.title
+                           : !record.url.empty() ? host_of(record.url)
+                                                 : record.login;
+            entry_.login.assign(record.login);
+            entry_.password.assign(record.password);
+            entry_.is_favorite = record.favorite;
+            stopped_           = !sink_(entry_);
+            secure_wipe(entry_.password);
+        }
+        record.clear();
+        return !stopped_;
+    }
+
+    Input&            in_;
+    const ImportSink& sink_;
+    string&           error_;
+    PasswordEntry     entry_;
+    bool              stopped_ = false;
+};
+
+// CSV с заголовком (RFC 4180: поля в кавычках могут содержать запятые, "" и переводы
+// строк). Столбцы ищутся по названиям, которые пишут распространённые менеджеры
+class CsvReader : Reader {
+   public:
+    using Reader::Reader;
+
+    bool run() {
+        size_t count;
+        if (!read_row(count)) return error_.empty();
+
+        vector<string> names;
+        for (size_t i = 0; i < count; ++i) {
+            string name = lower(fields_[i]);
+            name.erase(0, name.find_first_not_of(' '));
+            name.erase(name.find_last_not_of(' ') + 1);
+            names.push_back(name);
+        }
+        auto column = [&](initializer_list<const char*> candidates) {
+            for (const char* candidate : candidates) {
+                for (size_t i = 0; i < names.size(); ++i) {
+                    if (names[i] == candidate) return static_cast<int>(i);
+                }
+            }
+            return -1;
+        };
+        int title    = column({"title", "name", "account"});
+        int login    = column({"username", "login", "login_username", "login name", "user name",
+                               "user", "email", "e-mail"});
+        int password = column({"password", "login_password"});
+        int url      = column({"url", "login_uri", "uri", "website", "web site"});
+        int favorite = column({"favorite", "favourite", "fav"});
+        int type     = column({"type"});  // Bitwarden: login, note, card, identity
+        if (password < 0) return fail("CSV header has no password column");
+        if (title < 0 && url < 0 && login < 0) return fail("CSV header has no title column");
+
+        Record record;
+        while (read_row(count)) {
+            auto field = [&](int i) -> const string& {
+                static const string none;
+                return i >= 0 && static_cast<size_t>(i) < count ? fields_[i] : none;
+            };
+            if (count == 1 && fields_[0].empty()) continue;  // Пустая строка
+
+            string kind = lower(field(type));
+            if (kind.empty() || kind == "login") {
+                string fav      = lower(field(favorite));
+                record.title    = field(title);
+                record.login    = field(login);
+                record.password = field(password);
+                record.url      = field(url);
+                record.favorite = fav == "1" || fav == "true" || fav == "yes";
+                if (password < static_cast<int>(count)) secure_wipe(fields_[password]);
+                if (!emit(record)) break;
+            }
+        }
+        for (auto& f : fields_) secure_wipe(f);
+        return error_.empty();
+    }
+
+   private:
+    // false - конец входа или ошибка (тогда error_ не пуст)
+    bool read_row(size_t& count) {
+        count = 0;
+        if (in_.peek() == EOF) return false;
+
+        for (;;) {
+            if (count == MAX_FIELDS) return fail("too many columns");
+            if (count == fields_.size()) fields_.emplace_back();
+            string& field = fields_[count++];
+            field.clear();
+
+            int c = in_.peek();
+            if (c == '"') {
+                in_.get();
+                size_t start = in_.line();
+                for (;;) {
+                    c = in_.get();
+                    if (c == EOF) {
+                        error_ = "line " + to_string(start) + ": unterminated quoted field";
+                        return false;
+                    }
+                    if (c == '"' && !in_.consume('"')) break;
+                    if (field.size() == MAX_FIELD) return fail("field too long");
+                    field += static_cast<char>(c);
+                }
+            }
+            // Поле без кавычек или то, что осталось после закрывающей кавычки
+            for (c = in_.peek(); c != EOF && c != ',' && c != '\n' && c != '\r'; c = in_.peek()) {
+                if (field.size() == MAX_FIELD) return fail("field too long");
+                field += static_cast<char>(in_.get());
+            }
+
+            c = in_.get();
+            if (c == ',') continue;
+            if (c == '\r') in_.consume('\n');
+            return true;
+        }
+    }
+
+    vector<string> fields_;
+};
+
+// KeePass 2.x XML: Group/Entry/String с парами Key и Value. История изменений
+// (Entry/History/Entry) и корзина (группа с Meta/RecycleBinUUID) не импортируются
+class KeePassReader : Reader {
+   public:
+    using Reader::Reader;
+
+    bool run() {
+        for (int c = in_.get(); c != EOF; c = in_.get()) {
+            if (c == '<') {
+                if (!markup()) break;
+            } else if (c == '&') {
+                if (!entity()) break;
+            } else if (capture_) {
+                if (text_.size() == MAX_FIELD) return fail("value too long");
+                text_ += static_cast<char>(c);
+            }
+            if (stopped_) break;
+        }
+        if (error_.empty() && !stopped_ && !stack_.empty()) fail("unexpected end of file");
+
+        secure_wipe(text_);
+        secure_wipe(value_);
+        return error_.empty();
+    }
+
+   private:
+    static constexpr size_t NO_ENTRY = SIZE_MAX;
+
+    bool skip_past(string_view end) {
+        size_t matched = 0;
+        for (int c = in_.get(); c != EOF; c = in_.get()) {
+            matched = c == static_cast<unsigned char>(end[matched]) ? matched + 1
+                      : c == static_cast<unsigned char>(end[0])     ? 1
+                                                                    : 0;
+            if (matched == end.size()) return true;
+        }
+        return fail("unterminated markup");
+    }
+
+    bool markup() {
+        if (in_.consume('?')) return skip_past("?>");
+        if (in_.consume('!')) {
+            if (in_.consume('-')) return skip_past("-->");
+            if (!in_.consume('[')) return skip_past(">");  // DOCTYPE
+
+            // <![CDATA[...]]>: текст как есть
+            if (!skip_past("[")) return false;
+            size_t matched = 0;
+            for (int c = in_.get(); c != EOF; c = in_.get()) {
+                if (capture_ && text_.size() == MAX_FIELD) return fail("value too long");
+                if (capture_) text_ += static_cast<char>(c);
+                matched = c == ']' ? matched + 1 : (c == '>' && matched >= 2 ? 3 : 0);
+                if (matched == 3) {
+                    if (capture_) text_.resize(text_.size() - 3);
+                    return true;
+                }
+            }
+            return fail("unterminated CDATA");
+        }
+
+        bool   closing = in_.consume('/');
+        string name;
+        for (int c = in_.peek(); c != EOF && c != '>' && c != '/' && c > ' '; c = in_.peek()) {
+            name += static_cast<char>(in_.get());
+        }
+        if (name.empty()) return fail("malformed tag");
+
+        // Атрибуты не нужны: пропускаются с учётом кавычек
+        bool selfClosing = false;
+        char quote       = 0;
+        for (int c = in_.get();; c = in_.get()) {
+            if (c == EOF) return fail("unterminated tag <" + name + ">");
+            if (quote) {
+                if (c == quote) quote = 0;
+            } else if (c == '"' || c == '\'') {
+                quote = static_cast<char>(c);
+            } else if (c == '>') {
+                break;
+            } else {
+                selfClosing = c == '/';
+            }
+        }
+
+        if (closing) return close(name);
+        if (!open(name)) return false;
+        return !selfClosing || close(name);
+    }
+
+    bool entity() {
+        string name;
+        for (int c = in_.get(); c != ';'; c = in_.get()) {
+            if (c == EOF || name.size() > 8) return fail("malformed entity");
+            name += static_cast<char>(c);
+        }
+        if (!capture_) return true;
+
+        if (name == "lt") {
+            text_ += '<';
+        } else if (name == "gt") {
+            text_ += '>';
+        } else if (name == "amp") {
+            text_ += '&';
+        } else if (name == "quot") {
+            text_ += '"';
+        } else if (name == "apos") {
+            text_ += '\'';
+        } else if (name.size() > 1 && name[0] == '#') {
+            bool     hex = name[1] == 'x' || name[1] == 'X';
+            char*    end = nullptr;
+            uint32_t cp  = static_cast<uint32_t>(strtoul(&name[hex ? 2 : 1], &end, hex ? 16 : 10));
+            if (*end != '\0' || cp > 0x10ffff || (cp >= 0xd800 && cp < 0xe000)) {
+                return fail("malformed entity &" + name + ";");
+            }
+            append_utf8(text_, cp);
+        } else {
+            return fail("unknown entity &" + name + ";");
+        }
+        return true;
+    }
+
+    bool open(const string& name) {
+        if (stack_.size() == MAX_DEPTH) return fail("nesting too deep");
+        const string& parent = stack_.empty() ? string() : stack_.back();
+        size_t        depth  = stack_.size();
+
+        if (name == "Group") {
+            groups_.push_back(!groups_.empty() && groups_.back());
+        } else if (name == "Entry" && parent == "Group") {
+            entry_ = depth;
+            record_.clear();
+        }
+
+        // Текст собирается только там, где он нужен
+        capture_ = (entry_ != NO_ENTRY && depth == entry_ + 2 && parent == "String" &&
+                    (name == "Key" || name == "Value")) ||
+                   (name == "UUID" && parent == "Group") ||
+                   (name == "RecycleBinUUID" && parent == "Meta");
+        if (capture_) secure_wipe(text_);
+
+        stack_.push_back(name);
+        return true;
+    }
+
+    bool close(const string& name) {
+        if (stack_.empty() || stack_.back() != name) return fail("unexpected </" + name + ">");
+        stack_.pop_back();
+        size_t depth = stack_.size();
+
+        if (capture_) {
+            if (name == "Key") {
+                key_ = text_;
+            } else if (name == "Value") {
+                value_.swap(text_);
+            } else if (name == "RecycleBinUUID") {
+                recycleBin_ = text_;
+            } else if (!recycleBin_.empty() && text_ == recycleBin_) {
+                groups_.back() = true;  // UUID группы-корзины
+            }
+            secure_wipe(text_);
+            capture_ = false;
+        }
+
+        if (name == "String" && entry_ != NO_ENTRY && depth == entry_ + 1) {
+            if (key_ == "Title") {
+                record_.title.swap(value_);
+            } else if (key_ == "UserName") {
+                record_.login.swap(value_);
+            } else if (key_ == "Password") {
+                record_.password.swap(value_);
+            } else if (key_ == "URL") {
+                record_.url.swap(value_);
+            }
+            key_.clear();
+            secure_wipe(value_);
+        } else if (name == "Entry" && depth == entry_) {
+            entry_ = NO_ENTRY;
+            if (groups_.empty() || !groups_.back()) return emit(record_);
+            record_.clear();
+        } else if (name == "Group") {
+            groups_.pop_back();
+        }
+        return true;
+    }
+
+    vector<string> stack_;              // Открытые элементы
+    vector<bool>   groups_;             // Для открытых групп: внутри корзины
+    size_t         entry_   = NO_ENTRY;  // Глубина открытой записи
+    bool           capture_ = false;
+    string         text_;
+    string         key_;
+    string         value_;
+    string         recycleBin_;
+    Record         record_;
+};
+
+// Незашифрованный JSON Bitwarden: items[] с type 1 (логин), name, favorite и
+// login.username, login.password, login.uris[].uri. Разбор рекурсивный, но глубина
+// ограничена, и в памяти одна текущая запись
+class BitwardenReader : Reader {
+   public:
+    using Reader::Reader;
+
+    bool run() {
+        bool ok = members(0, [&](const string& key) {
+            if (key == "encrypted") {
+                string value;
+                if (!literal(value)) return false;
+                if (value == "true") {
+                    return fail("encrypted Bitwarden exports are not supported, "
+                                "export as unencrypted .json");
+                }
+                return true;
+            }
+            if (key == "items") return elements(1, [&] { return item(); });
+            return skip(1);
+        });
+        if (!ok) return error_.empty();
+
+        in_.skip_space();
+        return in_.peek() == EOF || fail("unexpected data after JSON");
+    }
+
+   private:
+    bool item() {
+        Record record;
+        int    type = 0;
+        bool   ok   = members(2, [&](const string& key) {
+            if (key == "type") {
+                string value;
+                if (!literal(value)) return false;
+                type = atoi(value.c_str());
+                return true;
+            }
+            if (key == "name") return string_or_null(record.title);
+            if (key == "favorite") {
+                string value;
+                if (!literal(value)) return false;
+                record.favorite = value == "true";
+                return true;
+            }
+            if (key != "login") return skip(3);
+
+            in_.skip_space();
+            if (in_.peek() != '{') return skip(3);  // null
+            return members(3, [&](const string& field) {
+                if (field == "username") return string_or_null(record.login);
+                if (field == "password") return string_or_null(record.password);
+                if (field != "uris") return skip(4);
+
+                in_.skip_space();
+                if (in_.peek() != '[') return skip(4);
+                return elements(4, [&] {
+                    return members(5, [&](const string& name) {
+                        if (name != "uri" || !record.url.empty()) return skip(6);
+                        return string_or_null(record.url);
+                    });
+                });
+            });
+        });
+        if (!ok) {
+            record.clear();
+            return false;
+        }
+        if (type != 1) {
+            record.clear();
+            return true;
+        }
+        return emit(record);
+    }
+
+    bool expect(char c) {
+        in_.skip_space();
+        if (in_.consume(c)) return true;
+        return fail(string("expected '") + c + "'");
+    }
+
+    // Объект: fn(key) разбирает значение каждого поля
+    template <typename Fn>
+    bool members(size_t depth, Fn fn) {
+        if (depth == MAX_DEPTH) return fail("nesting too deep");
+        if (!expect('{')) return false;
+        in_.skip_space();
+        if (in_.consume('}')) return true;
+
+        string key;
+        for (;;) {
+            in_.skip_space();
+            if (in_.peek() != '"') return fail("expected field name");
+            if (!string_value(&key) || !expect(':') || !fn(key)) return false;
+            in_.skip_space();
+            if (in_.consume(',')) continue;
+            return in_.consume('}') || fail("expected ',' or '}'");
+        }
+    }
+
+    template <typename Fn>
+    bool elements(size_t depth, Fn fn) {
+        if (depth == MAX_DEPTH) return fail("nesting too deep");
+        if (!expect('[')) return false;
+        in_.skip_space();
+        if (in_.consume(']')) return true;
+
+        for (;;) {
+            if (!fn()) return false;
+            in_.skip_space();
+            if (in_.consume(',')) continue;
+            return in_.consume(']') || fail("expected ',' or ']'");
+        }
+    }
+
+    bool skip(size_t depth) {
+        in_.skip_space();
+        int c = in_.peek();
+        if (c == '{') return members(depth, [&](const string&) { return skip(depth + 1); });
+        if (c == '[') return elements(depth, [&] { return skip(depth + 1); });
+        if (c == '"') return string_value(nullptr);
+        string value;
+        return literal(value);
+    }
+
+    // Число, true, false или null
+    bool literal(string& value) {
+        in_.skip_space();
+        value.clear();
+        for (int c = in_.peek(); (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' ||
+                                 c == '+' || c == '.' || c == 'E';
+             c = in_.peek()) {
+            if (value.size() == 64) return fail("malformed value");
+            value += static_cast<char>(in_.get());
+        }
+        return !value.empty() || fail("unexpected character");
+    }
+
+    bool string_or_null(string& out) {
+        in_.skip_space();
+        if (in_.peek() == '"') return string_value(&out);
+
+        string value;
+        if (!literal(value)) return false;
+        if (value != "null") return fail("expected string");
+        out.clear();
+        return true;
+    }
+
+    // Строка с экранированием; out == nullptr - пропустить. Суррогатная пара UTF-16
+    // (\ud83d\ude00) собирается в один символ, непарный суррогат заменяется на U+FFFD
+    bool string_value(string* out) {
+        in_.skip_space();
+        if (!in_.consume('"')) return fail("expected string");
+        if (out) out->clear();
+
+        uint32_t high   = 0;  // Первая половина пары, ждущая вторую
+        auto     append = [&](uint32_t cp) {
+            if (out) append_utf8(*out, cp);
+        };
+        auto unpaired = [&] {
+            if (high) append(REPLACEMENT_CHARACTER);
+            high = 0;
+        };
+
+        for (int c = in_.get();; c = in_.get()) {
+            if (c == EOF) return fail("unterminated string");
+            if (out && out->size() >= MAX_FIELD) return fail("string too long");
+            if (c != '\\') {
+                unpaired();
+                if (c == '"') return true;
+                if (out) *out += static_cast<char>(c);
+                continue;
+            }
+
+            c = in_.get();
+            if (char plain = json_escape(c)) {
+                unpaired();
+                if (out) *out += plain;
+                continue;
+            }
+            if (c != 'u') return fail("malformed escape");
+
+            uint32_t cp;
+            if (!hex4(cp)) return false;
+            if (cp >= 0xdc00 && cp < 0xe000 && high) {
+                append(0x10000 + ((high - 0xd800) << 10) + (cp - 0xdc00));
+                high = 0;
+            } else if (cp >= 0xd800 && cp < 0xdc00) {
+                unpaired();
+                high = cp;
+            } else {
+                unpaired();
+                append(cp >= 0xdc00 && cp < 0xe000 ? REPLACEMENT_CHARACTER : cp);
+            }
+        }
+    }
+
+    bool hex4(uint32_t& cp) {
+        cp = 0;
+        for (int i = 0; i < 4; ++i) {
+            int c = in_.get();
+            int d = c >= '0' && c <= '9'   ? c - '0'
+                    : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                           : -1;
+            if (d < 0) return fail("malformed \\u escape");
+            cp = cp << 4 | static_cast<uint32_t>(d);
+        }
+        return true;
+    }
+};
+
+// Ключ поиска дублей: название и логин через ноль
+string entry_key(string_view title, string_view login) {
+    string key;
+    key.reserve(title.size() + login.size() + 1);
+    key.append(title);
+    key.push_back('\0');
+    key.append(login);
+    return key;
+}
+
+}  // namespace
+
+bool db_parse_import_format(string_view name, ImportFormat& format) {
+    string value = lower(name);
+    if (value == "auto") {
+        format = ImportFormat::Auto;
+    } else if (value == "csv") {
+        format = ImportFormat::Csv;
+    } else if (value == "keepass" || value == "xml") {
+        format = ImportFormat::KeePassXml;
+    } else if (value == "bitwarden" || value == "json") {
+        format = ImportFormat::BitwardenJson;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* db_import_format_name(ImportFormat format) {
+    switch (format) {
+        case ImportFormat::Csv:
+            return "CSV";
+        case ImportFormat::KeePassXml:
+            return "KeePass XML";
+        case ImportFormat::BitwardenJson:
+            return "Bitwarden JSON";
+        default:
+            return "auto";
+    }
+}
+
+bool db_read_import(istream& in, ImportFormat& format, const ImportSink& sink, string& error) {
+    error.clear();
+    Input input(in);
+    input.skip_bom();
+
+    if (format == ImportFormat::Auto) {
+        input.skip_space();
+        int c  = input.peek();
+        format = c == '<'   ? ImportFormat::KeePassXml
+                 : c == '{' ? ImportFormat::BitwardenJson
+                            : ImportFormat::Csv;
+    }
+
+    switch (format) {
+        case ImportFormat::KeePassXml:
+            return KeePassReader(input, sink, error).run();
+        case ImportFormat::BitwardenJson:
+            return BitwardenReader(input, sink, error).run();
+        default:
+            return CsvReader(input, sink, error).run();
+    }
+}
+
+ImportReport db_import(Vault& vault, mutex& vaultMutex, istream& in, ImportFormat format) {
+    auto start = chrono::steady_clock::now();
+
+    // Пары название-логин, которые уже есть; импортированные добавляются сюда же
+    unordered_set<string> existing;
+    {
+        lock_guard<mutex> lock(vaultMutex);
+        existing.reserve(vault.entries.size() + IMPORT_BATCH);
+        for (size_t i = 0; i < vault.entries.size(); ++i) {
+            existing.insert(entry_key(vault.entries.title(i), vault.entries.login(i)));
+        }
+    }
+
+    ImportReport          report;
+    vector<PasswordEntry> batch;
+    batch.reserve(IMPORT_BATCH);
+
+    auto commit = [&] {
+        if (batch.empty()) return;
+        {
+            lock_guard<mutex> lock(vaultMutex);
+            for (const auto& entry : batch) vault.add(entry);
+            // Одна полная запись вместо журнала на каждую добавленную запись
+            vault.journal.stale = true;
+        }
+        report.imported += batch.size();
+        for (auto& entry : batch) secure_wipe(entry.password);
+        batch.clear();
+    };
+
+    auto sink = [&](PasswordEntry& entry) {
+        ++report.records;
+        if (entry.title.empty()) {
+            ++report.untitled;
+            return true;
+        }
+        if (!existing.insert(entry_key(entry.title, entry.login)).second) {
+            ++report.duplicates;
+            return true;
+        }
+
+        PasswordEntry& added = batch.emplace_back();
+        added.title          = entry.title;
+        added.login          = entry.login;
+        added.password.assign(entry.password);
+        added.is_favorite = entry.is_favorite;
+        if (batch.size() == IMPORT_BATCH) commit();
+        return true;
+    };
+
+    db_read_import(in, format, sink, report.error);
+    commit();
+
+    report.format = format;
+    report.elapsed_ms =
+        chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return report;
+}
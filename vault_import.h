@@ -0,0 +1,57 @@
+#ifndef VAULT_IMPORT_H
+#define VAULT_IMPORT_H
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "database.h"
+
+// Выгрузки других менеджеров паролей, которые понимает импорт
+enum class ImportFormat {
+    Auto,           // По первому значимому символу: '<' - XML, '{' - JSON, иначе CSV
+    Csv,            // С заголовком: Chrome, Firefox, Bitwarden, KeePass, 1Password и т.п.
+    KeePassXml,     // KeePass 2.x, File -> Export -> KeePass XML (2.x)
+    BitwardenJson,  // Bitwarden, незашифрованный .json
+};
+
+// Записи добавляются в хранилище пачками такого размера, каждая под одной блокировкой
+constexpr size_t IMPORT_BATCH = 1024;
+
+// Формат по имени: csv, keepass, bitwarden или auto; false - имя неизвестно
+bool        db_parse_import_format(std::string_view name, ImportFormat& format);
+const char* db_import_format_name(ImportFormat format);
+
+struct ImportReport {
+    ImportFormat format     = ImportFormat::Auto;  // Формат, которым разобрана выгрузка
+    size_t       records    = 0;  // Записей с логином и паролем в выгрузке
+    size_t       imported   = 0;
+    size_t       duplicates = 0;  // Такие название и логин уже есть в хранилище или выше
+    size_t       untitled   = 0;  // Ни названия, ни адреса, ни логина - пропущены
+    std::string  error;           // Пусто - выгрузка прочитана целиком
+    double       elapsed_ms = 0;
+};
+
+// Очередная запись выгрузки; false прекращает разбор. После вызова пароль в entry
+// затирается, сохранить его можно только копией
+using ImportSink = std::function<bool(PasswordEntry& entry)>;
+
+// Потоковый разбор выгрузки: в памяти только буфер чтения и текущая запись, поэтому
+// размер выгрузки не ограничен. Заметки, карты и прочие записи без пароля и логина
+// пропускаются. format - Auto определяется по содержимому и заменяется найденным.
+// false - выгрузка повреждена, error - причина с номером строки
+bool db_read_import(std::istream& in, ImportFormat& format, const ImportSink& sink,
+                    std::string& error);
+
+// Импорт в хранилище. Записи с теми же названием и логином, что уже есть (по множеству
+// хешей, собранному до начала), пропускаются. Пачки по IMPORT_BATCH записей добавляются
+// под vaultMutex, и GUI и фоновые потоки не ждут весь импорт. Хранилище помечается
+// для записи целиком: вместо журнала на сотни тысяч записей сохранение будет одно.
+// При ошибке разбора добавленные до неё записи остаются
+ImportReport db_import(Vault& vault, std::mutex& vaultMutex, std::istream& in,
+                       ImportFormat format = ImportFormat::Auto);
+
+#endif
@@ -0,0 +1,47 @@
+#include "vault_key.h"
+
+#include <cstring>
+
+#include "secure_arena.h"
+#include "vault_format.h"
+
+using namespace std;
+
+VaultKey::VaultKey(const uint8_t* key, const uint8_t* salt, const KdfParams& kdf)
+    : key_(secure_alloc(SIZE)), kdf_(kdf) {
+    memcpy(key_, key, SIZE);
+    memcpy(salt_, salt, sizeof(salt_));
+}
+
+VaultKey::~VaultKey() {
+    secure_free(key_, SIZE);
+}
+
+VaultKeyPtr VaultKey::derive(const string& password, const uint8_t* salt, const KdfParams& kdf) {
+    uint8_t key[SIZE];
+    if (!derive_file_key(password, salt, kdf, key)) return nullptr;
+
+    auto result = make_shared<const VaultKey>(key, salt, kdf);
+    secure_zero(key, sizeof(key));
+    return result;
+}
+
+VaultKeyPtr VaultKey::generate(const string& password, const KdfParams& kdf) {
+    uint8_t salt[SALT_SIZE];
+    fill_random(salt, SALT_SIZE);
+    return derive(password, salt, kdf);
+}
+
+bool VaultKey::matches(const uint8_t* salt, const KdfParams& kdf) const {
+    return kdf_ == kdf && memcmp(salt_, salt, sizeof(salt_)) == 0;
+}
+
+bool VaultKey::verify(const string& password) const {
+    uint8_t key[SIZE];
+    if (!derive_file_key(password, salt_, kdf_, key)) return false;
+
+    uint8_t diff = 0;
+    for (size_t i = 0; i < SIZE; ++i) diff |= key[i] ^ key_[i];
+    secure_zero(key, sizeof(key));
+    return diff == 0;
+}
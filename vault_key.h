@@ -0,0 +1,48 @@
+#ifndef VAULT_KEY_H
+#define VAULT_KEY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "kdf.h"
+
+class VaultKey;
+using VaultKeyPtr = std::shared_ptr<const VaultKey>;
+
+// Ключ открытого хранилища. Вырабатывается из мастер-пароля один раз - при открытии
+// файла или смене пароля, - после чего сам пароль не нужен: сохранения, журнал и фоновая
+// запись берут готовый ключ. Ключ лежит на отдельной странице, закреплённой в памяти
+// (mlock), чтобы не попасть в swap и дамп процесса, и затирается при уничтожении.
+class VaultKey {
+   public:
+    static constexpr size_t SIZE = 32;
+
+    VaultKey(const uint8_t* key, const uint8_t* salt, const KdfParams& kdf);
+    ~VaultKey();
+
+    VaultKey(const VaultKey&)            = delete;
+    VaultKey& operator=(const VaultKey&) = delete;
+
+    // Ключ для соли и параметров файла; nullptr - параметры вне допустимых пределов
+    static VaultKeyPtr derive(const std::string& password, const uint8_t* salt,
+                              const KdfParams& kdf);
+    // Ключ с новой случайной солью: новый файл или смена пароля и параметров
+    static VaultKeyPtr generate(const std::string& password, const KdfParams& kdf);
+
+    const uint8_t*   data() const { return key_; }
+    const uint8_t*   salt() const { return salt_; }
+    const KdfParams& kdf() const { return kdf_; }
+
+    // Выработан ли ключ для этой соли и этих параметров
+    bool matches(const uint8_t* salt, const KdfParams& kdf) const;
+    // Тот ли это пароль: ключ вырабатывается заново и сравнивается за постоянное время
+    bool verify(const std::string& password) const;
+
+   private:
+    uint8_t*  key_;  // На закреплённой странице (secure_alloc)
+    uint8_t   salt_[16];
+    KdfParams kdf_;
+};
+
+#endif
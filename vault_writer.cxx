@@ -0,0 +1,108 @@
+#include "vault_writer.h"
+
+#include "journal.h"
+
+using namespace std;
+
+VaultWriter::VaultWriter(Vault& vault, mutex& vaultMutex, Listener listener)
+    : vault_(vault), vaultMutex_(vaultMutex), listener_(std::move(listener)) {}
+
+// Недописанные изменения уходят на диск сразу, без паузы на склейку
+VaultWriter::~VaultWriter() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void VaultWriter::schedule() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        requested_ = true;
+        deadline_  = chrono::steady_clock::now() + COALESCE_DELAY;
+        if (!thread_.joinable()) thread_ = thread(&VaultWriter::run, this);
+    }
+    wake_.notify_one();
+}
+
+void VaultWriter::flush() {
+    unique_lock<mutex> lock(mutex_);
+    flushing_ = true;
+    wake_.notify_all();
+    done_.wait(lock, [this] { return !requested_ && !busy_; });
+    flushing_ = false;
+}
+
+bool VaultWriter::idle() {
+    lock_guard<mutex> lock(mutex_);
+    return !requested_ && !busy_;
+}
+
+void VaultWriter::run() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return requested_ || stopping_; });
+        if (!requested_) break;
+
+        // Каждая новая правка отодвигает запись, серия правок уходит на диск одной пачкой
+        while (!stopping_ && !flushing_ && chrono::steady_clock::now() < deadline_) {
+            wake_.wait_until(lock, deadline_);
+        }
+
+        requested_  = false;
+        busy_       = true;
+        bool notify = !stopping_;  // При закрытии GUI уже не ждёт уведомлений
+        lock.unlock();
+
+        string error;
+        bool   wrote = false;
+        bool   saved = write_once(wrote, error);
+        if (wrote && notify && listener_) listener_(saved, error);
+
+        lock.lock();
+        busy_ = false;
+        done_.notify_all();
+    }
+}
+
+bool VaultWriter::write_once(bool& wrote, string& error) {
+    VaultSnapshot snapshot;
+    JournalBatch  batch;
+    bool          full;
+    {
+        lock_guard<mutex> lock(vaultMutex_);
+        bool changed = !vault_.journal.pending.empty() || vault_.journal.stale;
+        if (vault_.path.empty()) return true;
+
+        full = db_journal_needs_compaction(vault_) || (changed && !db_journal_usable(vault_));
+        if (!full && !changed) return true;
+
+        if (full) {
+            snapshot = db_snapshot(vault_);
+        } else {
+            db_journal_take(vault_, batch);
+        }
+    }
+    wrote = true;
+
+    if (!full) {
+        bool written = db_journal_write(batch);
+
+        lock_guard<mutex> lock(vaultMutex_);
+        db_journal_commit(vault_, batch, written);
+        if (written && !db_journal_needs_compaction(vault_)) return true;
+
+        // Журнал перерос порог или его не удалось дописать: сразу пишем файл целиком
+        snapshot = db_snapshot(vault_);
+    }
+
+    bool saved = db_write_snapshot(snapshot, snapshot.path);
+    {
+        lock_guard<mutex> lock(vaultMutex_);
+        db_commit_snapshot(vault_, snapshot, saved);
+    }
+    if (!saved) error = "Failed to save database " + snapshot.path;
+    return saved;
+}
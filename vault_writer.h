@@ -0,0 +1,63 @@
+#ifndef VAULT_WRITER_H
+#define VAULT_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "database.h"
+
+// Фоновая запись хранилища. После правки GUI вызывает schedule(), и поток,
+// дождавшись паузы в правках, пишет все накопленные изменения одной пачкой:
+// дописывает журнал или, если журнал перерос порог, записывает файл целиком.
+// Блокировка хранилища берётся только на снимок и фиксацию, диск - без неё,
+// поэтому правки никогда не ждут записи.
+class VaultWriter {
+   public:
+    // Вызывается из фонового потока после каждой записи
+    using Listener = std::function<void(bool saved, const std::string& error)>;
+
+    // Пауза, за которую серия правок склеивается в одну запись
+    static constexpr auto COALESCE_DELAY = std::chrono::milliseconds(300);
+
+    VaultWriter(Vault& vault, std::mutex& vaultMutex, Listener listener);
+    ~VaultWriter();
+
+    VaultWriter(const VaultWriter&)            = delete;
+    VaultWriter& operator=(const VaultWriter&) = delete;
+
+    // Сообщает, что хранилище изменилось (или журнал пора проверить на свёртку).
+    // Пишется ключом хранилища (vault.key), пароль не нужен
+    void schedule();
+
+    // Дожидается записи всего накопленного: перед загрузкой другого файла,
+    // сохранением под другим именем и выходом
+    void flush();
+
+    // Нет ни запланированной, ни идущей записи
+    bool idle();
+
+   private:
+    void run();
+    // Пишет накопленное; wrote - было ли что писать
+    bool write_once(bool& wrote, std::string& error);
+
+    Vault&      vault_;
+    std::mutex& vaultMutex_;
+    Listener    listener_;
+
+    std::mutex                            mutex_;
+    std::condition_variable               wake_;
+    std::condition_variable               done_;
+    std::thread                           thread_;
+    std::chrono::steady_clock::time_point deadline_;
+    bool                                  requested_ = false;
+    bool                                  busy_      = false;
+    bool                                  flushing_  = false;
+    bool                                  stopping_  = false;
+};
+
+#endif